@@ -82,8 +82,9 @@ void BitAssembler_entry(CFGCommon_ARG* cmdarg) {
     BitAssembler_OCLA::parse(bitobj, cmdarg->taskPath.c_str(), yosysBin,
                              analyzeCMDPath);
 
-    // Writing out
-    bitgen = bitobj.write(bitasm_file);
+    // Writing out (with index for lazy reader, the big arrays are compressed
+    // in parallel segments)
+    bitgen = bitobj.write(bitasm_file, nullptr, true, 1);
     CFG_POST_MSG("  Status: %s", bitgen ? "success" : "fail");
   }
   CFG_POST_MSG("BITASM elapsed time: %.3f seconds",
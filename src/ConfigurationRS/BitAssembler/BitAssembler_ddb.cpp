@@ -13,7 +13,9 @@ void CFG_ddb_search_device(const std::string& filepath,
                            const std::string& device_name,
                            BitAssembler_DEVICE& device) {
   CFGObject_DEV_DDB dev_ddb;
-  dev_ddb.read(filepath);
+  // Only the device with matching name is decoded, the others are skipped
+  dev_ddb.read(filepath, {"family", "series", "protocol", "blwl", "device"},
+               nullptr, "name", device_name);
   bool found = false;
   for (CFGObject_DEV_DDB_DEVICE*& dev : dev_ddb.device) {
     if (dev->name == device_name) {
@@ -1,13 +1,45 @@
 #include "BitAssembler_mgr.h"
 
+#include <string.h>
+
 #include <fstream>
 #include <iostream>
 
 #include "CFGCommonRS/CFGCommonRS.h"
 #include "nlohmann_json/json.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITASSEMBLER_MGR_SSE2
+#endif
+
 #define PCB_BIT_SIZE (36 * 1024)
 
+// Next non-blank line of memory mapped text file, trailing whitespace trimmed
+static bool BitAssembler_MGR_get_next_line(const CFG_MMAP_FILE& file,
+                                           size_t& index, const char*& line,
+                                           size_t& size) {
+  const char* data = reinterpret_cast<const char*>(file.data());
+  while (index < file.size()) {
+    const char* end =
+        reinterpret_cast<const char*>(memchr(&data[index], '\n',
+                                             file.size() - index));
+    size_t next = end == nullptr ? file.size() : (size_t)(end - data) + 1;
+    line = &data[index];
+    size = next - index;
+    index = next;
+    while (size && (line[size - 1] == ' ' || line[size - 1] == '\t' ||
+                    line[size - 1] == '\n' || line[size - 1] == '\r')) {
+      size--;
+    }
+    if (size) {
+      return true;
+    }
+  }
+  return false;
+}
+
 BitAssembler_MGR::BitAssembler_MGR() {
   CFG_INTERNAL_ERROR("This constructor is not supported");
 }
@@ -29,30 +61,33 @@ void BitAssembler_MGR::get_scan_chain_fcb(
   // Read fabric_bitstream.bit as text line by line, parse info out
   std::string filepath =
       CFG_print("%s/fabric_bitstream.bit", m_project_path.c_str());
-  std::fstream file;
-  file.open(filepath.c_str(), std::ios::in);
+  CFG_MMAP_FILE file(filepath);
   CFG_ASSERT_MSG(file.is_open(), "Fail to open %s", filepath.c_str());
-  std::string line = "";
+  size_t file_index = 0;
+  const char* line_ptr = nullptr;
+  size_t line_size = 0;
   size_t line_tracking = 0;
   size_t data_line = 0;
+  size_t bytes_per_line = 0;
   bool lsb = false;
   std::vector<uint8_t> data;
-  while (getline(file, line)) {
-    // Only trim the trailing whitespace
-    CFG_get_rid_trailing_whitespace(line);
-    if (line.size() == 0) {
-      // allow blank line
+  while (BitAssembler_MGR_get_next_line(file, file_index, line_ptr,
+                                        line_size)) {
+    if (line_tracking == 2) {
+      // This will be all data, no exception
+      CFG_ASSERT(data_line < fcb->length);
+      CFG_ASSERT(line_size == fcb->width);
+      get_bitline_into_bytes(line_ptr, fcb->width,
+                             &data[data_line * bytes_per_line], nullptr, lsb);
+      data_line++;
       continue;
     }
+    std::string line(line_ptr, line_size);
     // Strict checking on the format
     if (line_tracking == 0) {
       // First line must start with this keyword
       CFG_ASSERT(line == "// Fabric bitstream");
       line_tracking++;
-    } else if (line_tracking == 2) {
-      // This will be all data, no exception
-      get_bitline_into_bytes(line, data, fcb->width, lsb);
-      data_line++;
     } else {
       if (line.find("//") == 0) {
         if (line.find("// Version:") == 0 || line.find("// Date:") == 0) {
@@ -90,7 +125,10 @@ void BitAssembler_MGR::get_scan_chain_fcb(
         // Start of data
         // Make sure length and width is known
         CFG_ASSERT(fcb->check_exist("length") && fcb->check_exist("width"));
-        get_bitline_into_bytes(line, data, fcb->width, lsb);
+        CFG_ASSERT(line_size == fcb->width);
+        bytes_per_line = ((size_t)(fcb->width) + 7) / 8;
+        data.resize(bytes_per_line * fcb->length);
+        get_bitline_into_bytes(line_ptr, fcb->width, &data[0], nullptr, lsb);
         line_tracking++;
         data_line++;
       }
@@ -99,7 +137,6 @@ void BitAssembler_MGR::get_scan_chain_fcb(
   CFG_ASSERT(fcb->check_exist("length") && fcb->check_exist("width"));
   CFG_ASSERT(fcb->length == data_line);
   fcb->write_u8s("data", data);
-  file.close();
 }
 
 void BitAssembler_MGR::get_ql_membank_fcb(
@@ -112,35 +149,41 @@ void BitAssembler_MGR::get_ql_membank_fcb(
   // Read fabric_bitstream.bit as text line by line, parse info out
   std::string filepath =
       CFG_print("%s/fabric_bitstream.bit", m_project_path.c_str());
-  std::fstream file;
-  file.open(filepath.c_str(), std::ios::in);
+  CFG_MMAP_FILE file(filepath);
   CFG_ASSERT_MSG(file.is_open(), "Fail to open %s", filepath.c_str());
-  std::string line = "";
+  size_t file_index = 0;
+  const char* line_ptr = nullptr;
+  size_t line_size = 0;
   size_t line_tracking = 0;
   size_t data_line = 0;
+  size_t bytes_per_line = 0;
   bool lsb = false;
-  uint32_t one_hot_wl = 0;
   bool wl_increasing = false;
   std::vector<uint8_t> data;
   std::vector<uint8_t> mask;
-  while (getline(file, line)) {
-    // Only trim the trailing whitespace
-    CFG_get_rid_trailing_whitespace(line);
-    if (line.size() == 0) {
-      // allow blank line
+  while (BitAssembler_MGR_get_next_line(file, file_index, line_ptr,
+                                        line_size)) {
+    if (line_tracking == 2) {
+      // This will be all data, no exception
+      // Each line is BL bits followed by one-hot WL bits
+      CFG_ASSERT(data_line < fcb->wl);
+      CFG_ASSERT(line_size == ((size_t)(fcb->bl) + fcb->wl));
+      get_bitline_into_bytes(line_ptr, fcb->bl,
+                             &data[data_line * bytes_per_line],
+                             &mask[data_line * bytes_per_line], lsb);
+      uint32_t one_hot_wl =
+          get_one_hot_bit(&line_ptr[fcb->bl], fcb->wl, lsb);
+      CFG_ASSERT(one_hot_wl == (wl_increasing ? data_line
+                                              : fcb->wl - data_line - 1));
+      data_line++;
       continue;
     }
+    std::string line(line_ptr, line_size);
     // Strict checking on the format
     if (line_tracking == 0) {
       // First line must start with this keyword
       CFG_ASSERT(line == "// Fabric bitstream");
       line_tracking++;
-    } else if (line_tracking == 2) {
-      // This will be all data, no exception
-      get_wl_bitline_into_bytes(
-          line, data, mask, fcb->bl, fcb->wl,
-          wl_increasing ? data_line : fcb->wl - data_line - 1, lsb);
-      data_line++;
     } else {
       if (line.find("//") == 0) {
         if (line.find("// Version:") == 0 || line.find("// Date:") == 0) {
@@ -186,8 +229,13 @@ void BitAssembler_MGR::get_ql_membank_fcb(
         // Start of data
         // Make sure BL and WL is known
         CFG_ASSERT(fcb->check_exist("wl") && fcb->check_exist("bl"));
-        get_wl_bitline_into_bytes(line, data, mask, fcb->bl, fcb->wl, 0, lsb,
-                                  &one_hot_wl);
+        CFG_ASSERT(line_size == ((size_t)(fcb->bl) + fcb->wl));
+        bytes_per_line = ((size_t)(fcb->bl) + 7) / 8;
+        data.resize(bytes_per_line * fcb->wl);
+        mask.resize(bytes_per_line * fcb->wl);
+        get_bitline_into_bytes(line_ptr, fcb->bl, &data[0], &mask[0], lsb);
+        uint32_t one_hot_wl =
+            get_one_hot_bit(&line_ptr[fcb->bl], fcb->wl, lsb);
         CFG_ASSERT(one_hot_wl == 0 || one_hot_wl == (fcb->wl - 1));
         wl_increasing = one_hot_wl == 0;
         line_tracking++;
@@ -200,7 +248,6 @@ void BitAssembler_MGR::get_ql_membank_fcb(
   CFG_ASSERT(data.size() == mask.size());
   fcb->write_u8s("data", data);
   fcb->write_u8s("mask", mask);
-  file.close();
 }
 
 void BitAssembler_MGR::get_icb(const CFGObject_BITOBJ_ICB* icb) {
@@ -466,111 +513,106 @@ void BitAssembler_MGR::get_one_region_ccff_fcb(const std::string& filepath,
 
 std::string BitAssembler_MGR::get_ocla_design(const std::string& filepath) {
   CFG_ASSERT(CFG_check_file_extensions(filepath, {".bitasm"}) == 0);
-  // Read the BitObj file
+  // Only decode the OCLA member of the BitObj file
   CFGObject_BITOBJ bitobj;
-  CFG_ASSERT(bitobj.read(filepath));
+  CFG_ASSERT(bitobj.read(filepath, {"ocla"}));
   return bitobj.ocla;
 }
 
-template <typename T>
-uint32_t BitAssembler_MGR::get_bitline_into_bytes(
-    T& start, T& end, std::vector<uint8_t>& bytes,
-    std::vector<uint8_t>* mask_bytes, uint32_t size) {
-  CFG_ASSERT(start != end);
+void BitAssembler_MGR::get_bitline_into_bytes(const char* line,
+                                              const uint32_t size,
+                                              uint8_t* bytes,
+                                              uint8_t* mask_bytes,
+                                              const bool lsb) {
+  // Bit N is character N (LSB -> MSB) or the N-th character from the end
+  // (MSB -> LSB). Output bytes must be zero initialized
+  CFG_ASSERT(size);
   uint32_t index = 0;
-  while (start != end) {
-    if ((index % 8) == 0) {
-      bytes.push_back(0);
+#if defined(BITASSEMBLER_MGR_SSE2)
+  // 16 characters into 16 bits at a time
+  const __m128i one = _mm_set1_epi8('1');
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i x = _mm_set1_epi8('x');
+  for (; (index + 16) <= size; index += 16) {
+    __m128i chars;
+    if (lsb) {
+      chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&line[index]));
+    } else {
+      chars = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(&line[size - index - 16]));
+      // Reverse the character ordering
+      chars = _mm_shuffle_epi32(chars, 0x1B);
+      chars = _mm_shufflelo_epi16(chars, 0xB1);
+      chars = _mm_shufflehi_epi16(chars, 0xB1);
+      chars = _mm_or_si128(_mm_slli_epi16(chars, 8), _mm_srli_epi16(chars, 8));
     }
-    if (mask_bytes != nullptr && (index % 8) == 0) {
-      mask_bytes->push_back(0);
+    __m128i ones = _mm_cmpeq_epi8(chars, one);
+    __m128i known = _mm_or_si128(ones, _mm_cmpeq_epi8(chars, zero));
+    CFG_ASSERT(_mm_movemask_epi8(
+                   _mm_or_si128(known, _mm_cmpeq_epi8(chars, x))) == 0xFFFF);
+    int bits = _mm_movemask_epi8(ones);
+    bytes[index >> 3] = (uint8_t)(bits);
+    bytes[(index >> 3) + 1] = (uint8_t)(bits >> 8);
+    if (mask_bytes != nullptr) {
+      bits = _mm_movemask_epi8(known);
+      mask_bytes[index >> 3] = (uint8_t)(bits);
+      mask_bytes[(index >> 3) + 1] = (uint8_t)(bits >> 8);
     }
-    if (*start == '1') {
-      bytes.back() |= (1 << (index & 7));
+  }
+#endif
+  for (; index < size; index++) {
+    char c = lsb ? line[index] : line[size - index - 1];
+    if (c == '1') {
+      bytes[index >> 3] |= (1 << (index & 7));
     } else {
-      CFG_ASSERT(*start == '0' || *start == 'x');
-    }
-    if (mask_bytes != nullptr && (*start == '0' || *start == '1')) {
-      mask_bytes->back() |= (1 << (index & 7));
+      CFG_ASSERT(c == '0' || c == 'x');
     }
-    start++;
-    index++;
-    if (index == size) {
-      break;
+    if (mask_bytes != nullptr && (c == '0' || c == '1')) {
+      mask_bytes[index >> 3] |= (1 << (index & 7));
     }
   }
-  return index;
 }
 
-uint32_t BitAssembler_MGR::get_bitline_into_bytes(const std::string& line,
-                                                  std::vector<uint8_t>& bytes,
-                                                  const uint32_t expected_bit,
-                                                  const bool lsb) {
-  CFG_ASSERT(line.size());
-  CFG_ASSERT(expected_bit == 0 || expected_bit == line.size());
-  uint32_t bits = 0;
-  if (lsb) {
-    auto start = line.begin();
-    auto end = line.end();
-    bits = get_bitline_into_bytes(start, end, bytes, nullptr);
-    CFG_ASSERT(start == end);
-  } else {
-    auto start = line.rbegin();
-    auto end = line.rend();
-    bits = get_bitline_into_bytes(start, end, bytes, nullptr);
-    CFG_ASSERT(start == end);
-  }
-  return bits;
-}
-
-uint32_t BitAssembler_MGR::get_wl_bitline_into_bytes(
-    const std::string& line, std::vector<uint8_t>& bytes,
-    std::vector<uint8_t>& mask_bytes, const uint32_t expected_bl_bit,
-    const uint32_t expected_wl_bit, const uint32_t expected_wl, const bool lsb,
-    uint32_t* one_hot_wl) {
-  CFG_ASSERT(line.size());
-  CFG_ASSERT(expected_bl_bit);
-  CFG_ASSERT(expected_wl_bit);
-  CFG_ASSERT((expected_bl_bit + expected_wl_bit) == (uint32_t)(line.size()));
-  std::vector<uint8_t> wl;
-  uint32_t bl_size = 0;
-  if (lsb) {
-    auto start = line.begin();
-    auto end = line.end();
-    bl_size =
-        get_bitline_into_bytes(start, end, bytes, &mask_bytes, expected_bl_bit);
-    CFG_ASSERT(bl_size == expected_bl_bit);
-    get_bitline_into_bytes(start, end, wl, nullptr, expected_wl_bit);
-    CFG_ASSERT(start == end);
-  } else {
-    auto start = line.rbegin();
-    auto end = line.rend();
-    get_bitline_into_bytes(start, end, wl, nullptr, expected_wl_bit);
-    bl_size =
-        get_bitline_into_bytes(start, end, bytes, &mask_bytes, expected_bl_bit);
-    CFG_ASSERT(bl_size == expected_bl_bit);
-    CFG_ASSERT(start == end);
-  }
-  if (one_hot_wl == nullptr) {
-    CFG_ASSERT(expected_wl < expected_wl_bit);
-    for (uint32_t i = 0; i < expected_wl_bit; i++) {
-      if (wl[i >> 3] & (1 << (i & 7))) {
-        CFG_ASSERT(i == expected_wl);
-      } else {
-        CFG_ASSERT(i != expected_wl);
+uint32_t BitAssembler_MGR::get_one_hot_bit(const char* line,
+                                           const uint32_t size,
+                                           const bool lsb) {
+  CFG_ASSERT(size);
+  uint32_t one_hot = size;
+  uint32_t index = 0;
+#if defined(BITASSEMBLER_MGR_SSE2)
+  // Validate 16 characters at a time, only look closer if there is '1'
+  const __m128i one = _mm_set1_epi8('1');
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i x = _mm_set1_epi8('x');
+  for (; (index + 16) <= size; index += 16) {
+    __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&line[index]));
+    __m128i ones = _mm_cmpeq_epi8(chars, one);
+    __m128i valid = _mm_or_si128(
+        ones, _mm_or_si128(_mm_cmpeq_epi8(chars, zero),
+                           _mm_cmpeq_epi8(chars, x)));
+    CFG_ASSERT(_mm_movemask_epi8(valid) == 0xFFFF);
+    if (_mm_movemask_epi8(ones)) {
+      for (uint32_t i = index; i < (index + 16); i++) {
+        if (line[i] == '1') {
+          // Can only set once
+          CFG_ASSERT(one_hot == size);
+          one_hot = i;
+        }
       }
     }
-  } else {
-    (*one_hot_wl) = expected_wl_bit;
-    for (uint32_t i = 0; i < expected_wl_bit; i++) {
-      if (wl[i >> 3] & (1 << (i & 7))) {
-        // Can only set once
-        CFG_ASSERT((*one_hot_wl) == expected_wl_bit);
-        (*one_hot_wl) = i;
-      }
+  }
+#endif
+  for (; index < size; index++) {
+    if (line[index] == '1') {
+      // Can only set once
+      CFG_ASSERT(one_hot == size);
+      one_hot = index;
+    } else {
+      CFG_ASSERT(line[index] == '0' || line[index] == 'x');
     }
-    // Must have one-hot-bit
-    CFG_ASSERT((*one_hot_wl) < expected_wl_bit);
   }
-  return bl_size;
+  // Must have one-hot-bit
+  CFG_ASSERT(one_hot < size);
+  return lsb ? one_hot : (size - one_hot - 1);
 }
@@ -1,6 +1,133 @@
+#include <chrono>
+
+#include "BitAssembler_mgr.h"
 #include "CFGCommonRS/CFGCommonRS.h"
 
+static uint32_t test_seed = 0x3C6EF372;
+
+static char test_random_bit(bool allow_x) {
+  test_seed = test_seed * 1664525 + 1013904223;
+  if (allow_x && (test_seed >> 28) == 0) {
+    return 'x';
+  }
+  return (test_seed >> 24) & 1 ? '1' : '0';
+}
+
+static void test_pack_bits(const std::string& bits, bool lsb,
+                           std::vector<uint8_t>& data,
+                           std::vector<uint8_t>* mask) {
+  // Reference: bit N is character N (LSB -> MSB) or N-th from the end
+  size_t offset = data.size();
+  data.resize(offset + (bits.size() + 7) / 8);
+  if (mask != nullptr) {
+    mask->resize(data.size());
+  }
+  for (size_t i = 0; i < bits.size(); i++) {
+    char c = lsb ? bits[i] : bits[bits.size() - i - 1];
+    if (c == '1') {
+      data[offset + (i >> 3)] |= (1 << (i & 7));
+    }
+    if (mask != nullptr && c != 'x') {
+      (*mask)[offset + (i >> 3)] |= (1 << (i & 7));
+    }
+  }
+}
+
+static void test_write_scan_chain_file(uint32_t length, uint32_t width,
+                                       bool lsb, std::vector<uint8_t>& data) {
+  std::string text = CFG_print(
+      "// Fabric bitstream\n// Version: Test\n// Date: Today\n// Bitstream "
+      "length: %d\n// Bitstream width (%s): %d\n",
+      length, lsb ? "LSB -> MSB" : "MSB -> LSB", width);
+  for (uint32_t i = 0; i < length; i++) {
+    std::string line = "";
+    for (uint32_t j = 0; j < width; j++) {
+      line.push_back(test_random_bit(true));
+    }
+    test_pack_bits(line, lsb, data, nullptr);
+    text += line + (i % 2 ? "\r\n" : "\n");
+  }
+  CFG_write_binary_file("fabric_bitstream.bit",
+                        reinterpret_cast<const uint8_t*>(text.c_str()),
+                        text.size());
+}
+
+static void test_write_ql_membank_file(uint32_t bl, uint32_t wl, bool lsb,
+                                       bool increasing,
+                                       std::vector<uint8_t>& data,
+                                       std::vector<uint8_t>& mask) {
+  std::string text = CFG_print(
+      "// Fabric bitstream\n// Bitstream length: %d\n// Bitstream width "
+      "(%s): <bl_address %d bits><wl_address %d bits>\n",
+      wl, lsb ? "LSB -> MSB" : "MSB -> LSB", bl, wl);
+  for (uint32_t i = 0; i < wl; i++) {
+    std::string bl_bits = "";
+    for (uint32_t j = 0; j < bl; j++) {
+      bl_bits.push_back(test_random_bit(true));
+    }
+    test_pack_bits(bl_bits, lsb, data, &mask);
+    uint32_t one_hot = increasing ? i : (wl - i - 1);
+    std::string wl_bits(wl, '0');
+    wl_bits[lsb ? one_hot : (wl - one_hot - 1)] = '1';
+    text += bl_bits + wl_bits + "\n";
+  }
+  CFG_write_binary_file("fabric_bitstream.bit",
+                        reinterpret_cast<const uint8_t*>(text.c_str()),
+                        text.size());
+}
+
+void test_fabric_bitstream_parsing() {
+  CFG_POST_MSG("Fabric Bitstream Parsing Test");
+  BitAssembler_MGR mgr(".", "test");
+  for (bool lsb : {true, false}) {
+    std::vector<uint8_t> data;
+    test_write_scan_chain_file(97, 1237, lsb, data);
+    CFGObject_BITOBJ bitobj;
+    mgr.get_scan_chain_fcb(&bitobj.scan_chain_fcb);
+    CFG_ASSERT(bitobj.scan_chain_fcb.length == 97);
+    CFG_ASSERT(bitobj.scan_chain_fcb.width == 1237);
+    CFG_ASSERT(bitobj.scan_chain_fcb.data == data);
+    for (bool increasing : {true, false}) {
+      std::vector<uint8_t> ql_data;
+      std::vector<uint8_t> ql_mask;
+      test_write_ql_membank_file(517, 131, lsb, increasing, ql_data, ql_mask);
+      CFGObject_BITOBJ ql_bitobj;
+      mgr.get_ql_membank_fcb(&ql_bitobj.ql_membank_fcb);
+      CFG_ASSERT(ql_bitobj.ql_membank_fcb.bl == 517);
+      CFG_ASSERT(ql_bitobj.ql_membank_fcb.wl == 131);
+      CFG_ASSERT(ql_bitobj.ql_membank_fcb.data == ql_data);
+      CFG_ASSERT(ql_bitobj.ql_membank_fcb.mask == ql_mask);
+    }
+  }
+  std::remove("fabric_bitstream.bit");
+}
+
+void test_fabric_bitstream_benchmark() {
+  CFG_POST_MSG("Fabric Bitstream Parsing Benchmark");
+  const uint32_t length = 4096;
+  const uint32_t width = 8192;
+  std::vector<uint8_t> data;
+  test_write_scan_chain_file(length, width, false, data);
+  BitAssembler_MGR mgr(".", "test");
+  CFGObject_BITOBJ bitobj;
+  auto start = std::chrono::steady_clock::now();
+  mgr.get_scan_chain_fcb(&bitobj.scan_chain_fcb);
+  double elapsed = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  CFG_ASSERT(bitobj.scan_chain_fcb.data == data);
+  CFG_POST_MSG("!!! Result: %d x %d bits parsed in %.3f ms", length, width,
+               elapsed);
+  std::remove("fabric_bitstream.bit");
+}
+
 int main(int argc, const char** argv) {
   CFG_POST_MSG("This is BITASM unit test");
+  // Benchmarks only run on request: bitassembler_test --benchmark
+  bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
+  test_fabric_bitstream_parsing();
+  if (benchmark) {
+    test_fabric_bitstream_benchmark();
+  }
   return 0;
 }
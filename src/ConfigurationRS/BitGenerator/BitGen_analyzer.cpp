@@ -3,16 +3,24 @@
 BitGen_ANALYZER::BitGen_ANALYZER(const std::string& filepath,
                                  std::ofstream* file,
                                  std::vector<uint8_t>* aes_key)
-    : m_filepath(filepath), m_file(file), m_aes_key(aes_key) {
+    : m_filepath(filepath),
+      m_file(file),
+      m_aes_key(aes_key),
+      m_decompressed_data(BitGen_ANALYZER_DECOMPRESS_BUFFER_SIZE, 0) {
   CFG_ASSERT(m_file != nullptr);
   CFG_ASSERT(m_file->is_open());
   CFG_ASSERT(m_file->good());
   CFG_ASSERT(m_aes_key == nullptr || m_aes_key->size() == 16 ||
              m_aes_key->size() == 32);
+  if (m_aes_key != nullptr) {
+    // Key the AES session once, every payload block only sets the IV
+    m_ctr = CFG_MEM_NEW(CFGOpenSSL_CTR, m_aes_key->data(), m_aes_key->size());
+  }
 }
 
 BitGen_ANALYZER::~BitGen_ANALYZER() {
-  memset(m_decompressed_data, 0, sizeof(m_decompressed_data));
+  CFG_MEM_DELETE(m_ctr);
+  memset(m_decompressed_data.data(), 0, m_decompressed_data.size());
 }
 
 template <typename T>
@@ -139,6 +147,7 @@ bool BitGen_ANALYZER::parse_bop(const uint8_t* data, size_t size,
           m_decompress_engine.reset();
           m_status.decompression_status = BitGen_DECOMPRESS_ENGINE_GOOD_STATUS;
           m_decompressed_data_offset = 0;
+          m_decompressed_size = 0;
           std::string binfilepath =
               CFG_print("%s.bop%d.payload%d.bin",
                         m_filepath.substr(0, m_filepath.size() - 4).c_str(),
@@ -586,10 +595,10 @@ void BitGen_ANALYZER::challenge(std::string space,
       if ((m_header.encryption == "ctr128" && m_aes_key->size() == 16) ||
           (m_header.encryption == "ctr256" && m_aes_key->size() == 32)) {
         uint8_t plain_data[64] = {0};
-        CFGOpenSSL::ctr_decrypt(&m_current_bop_data[0x240], plain_data,
-                                sizeof(plain_data), m_aes_key->data(),
-                                m_aes_key->size(), m_header.iv,
-                                sizeof(m_header.iv));
+        CFG_ASSERT(m_ctr != nullptr);
+        m_ctr->set_iv(m_header.iv, sizeof(m_header.iv));
+        m_ctr->process(&m_current_bop_data[0x240], plain_data,
+                       sizeof(plain_data));
         update_iv(m_header.iv);
         uint32_t challenge_crc32 =
             get_u32(&plain_data[sizeof(plain_data) - sizeof(challenge_crc32)]);
@@ -899,14 +908,16 @@ void BitGen_ANALYZER::parse_payload(std::string space, const uint8_t* data,
     (*m_file) << CFG_convert_bytes_to_hex_string(iv, 16).c_str();
     (*m_file) << ")";
     (*m_file) << "\n";
-    CFGOpenSSL::ctr_decrypt(data, plain_data, size, m_aes_key->data(),
-                            m_aes_key->size(), iv, 16, iv);
+    // Consecutive blocks continue the running IV without re-initialization
+    CFG_ASSERT(m_ctr != nullptr);
+    m_ctr->set_iv(iv, 16);
+    m_ctr->process(data, plain_data, size);
+    m_ctr->get_iv(iv, 16);
   }
   (*m_file) << space.c_str() << "Block: Payload\n";
   (*m_file) << space.c_str() << print_repeat_word_line("-", 100).c_str()
             << "\n";
-  (*m_file) << space.c_str()
-            << "  Absolute | Offset   | Data     | Decrpt   | Decompress\n";
+  (*m_file) << space.c_str() << "  Absolute | Offset   | Data     | Decrpt\n";
   (*m_file) << space.c_str() << print_repeat_word_line("-", 100).c_str()
             << "\n";
   std::string unencrypted_data_string = print_repeat_word_line(" ", 8);
@@ -922,90 +933,27 @@ void BitGen_ANALYZER::parse_payload(std::string space, const uint8_t* data,
       unencrypted_data_string = CFG_print("%08X", plain_u32);
     }
     (*m_file) << space.c_str()
-              << CFG_print("  %08X | %08X | %08X | %s |",
+              << CFG_print("  %08X | %08X | %08X | %s",
                            m_current_bop_offset + payload_addr + i,
                            payload_addr + i, u32,
                            unencrypted_data_string.c_str())
-                     .c_str();
-    if (proceed_dcmp &&
-        m_status.decompression_status !=
-            BitGen_DECOMPRESS_ENGINE_ERROR_STATUS &&
-        m_status.decompression_status != BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
-      uint32_t decompressed_data = 0;
+                     .c_str()
+              << "\n";
+    if (!proceed_dcmp && remaining_size) {
+      size_t write_size = remaining_size > 4 ? 4 : remaining_size;
       if (m_aes_key != nullptr) {
-        decompressed_data = plain_u32;
+        binfile.write((char*)(&plain_u32), write_size);
       } else {
-        decompressed_data = u32;
-      }
-      m_status.decompression_status = BitGen_DECOMPRESS_ENGINE_GOOD_STATUS;
-      CFG_ASSERT(m_decompressed_data_offset < 4);
-      while (m_status.decompression_status ==
-             BitGen_DECOMPRESS_ENGINE_GOOD_STATUS) {
-        size_t dcmp_out_size = 0;
-        m_status.decompression_status = m_decompress_engine.process(
-            (uint8_t*)(&decompressed_data), sizeof(decompressed_data),
-            &m_decompressed_data[m_decompressed_data_offset],
-            sizeof(m_decompressed_data) - m_decompressed_data_offset,
-            dcmp_out_size);
-        if (m_status.decompression_status ==
-            BitGen_DECOMPRESS_ENGINE_ERROR_STATUS) {
-          m_status.status = false;
-          break;
-        } else if (m_status.decompression_status ==
-                   BitGen_DECOMPRESS_ENGINE_NEED_INPUT_STATUS) {
-          break;
-        }
-        CFG_ASSERT(dcmp_out_size);
-        size_t total_size = m_decompressed_data_offset + dcmp_out_size;
-        CFG_ASSERT(total_size <= sizeof(m_decompressed_data));
-        uint8_t* dcmp_data_ptr = &m_decompressed_data[0];
-        while (total_size >= 4) {
-          (*m_file) << CFG_print(" %08X", get_u32(dcmp_data_ptr)).c_str();
-          binfile.write((char*)(dcmp_data_ptr), 4);
-          total_size -= 4;
-          dcmp_data_ptr += 4;
-        }
-        m_decompressed_data_offset = total_size;
-        if (m_decompressed_data_offset) {
-          CFG_ASSERT(m_decompressed_data_offset < 4);
-          if (m_decompressed_data != dcmp_data_ptr) {
-            CFG_ASSERT(dcmp_data_ptr > m_decompressed_data);
-            memcpy(m_decompressed_data, dcmp_data_ptr,
-                   m_decompressed_data_offset);
-          }
-        }
-      }
-      if (m_status.decompression_status !=
-              BitGen_DECOMPRESS_ENGINE_ERROR_STATUS &&
-          m_decompressed_data_offset != 0) {
-        if (m_status.decompression_status !=
-            BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
-          (*m_file) << CFG_print(" (Remaining: ");
-        }
-        (*m_file) << CFG_convert_bytes_to_hex_string(
-                         m_decompressed_data, m_decompressed_data_offset, ", ")
-                         .c_str();
-        if (m_status.decompression_status !=
-            BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
-          (*m_file) << ")";
-        }
-      }
-      if (m_status.decompression_status ==
-          BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
-        (*m_file) << " [DCMP: DONE]";
-      }
-    } else if (!proceed_dcmp) {
-      if (remaining_size) {
-        size_t write_size = remaining_size > 4 ? 4 : remaining_size;
-        if (m_aes_key != nullptr) {
-          binfile.write((char*)(&plain_u32), write_size);
-        } else {
-          binfile.write((char*)(&u32), write_size);
-        }
-        remaining_size -= write_size;
+        binfile.write((char*)(&u32), write_size);
       }
+      remaining_size -= write_size;
     }
-    (*m_file) << "\n";
+  }
+  if (proceed_dcmp &&
+      m_status.decompression_status != BitGen_DECOMPRESS_ENGINE_ERROR_STATUS &&
+      m_status.decompression_status != BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
+    decompress_payload(space, m_aes_key != nullptr ? plain_data : data,
+                       binfile);
   }
   memset(plain_data, 0, sizeof(plain_data));
   if (m_status.decompression_status == BitGen_DECOMPRESS_ENGINE_DONE_STATUS &&
@@ -1036,6 +984,70 @@ void BitGen_ANALYZER::parse_payload(std::string space, const uint8_t* data,
   }
 }
 
+void BitGen_ANALYZER::decompress_payload(std::string space,
+                                         const uint8_t* data,
+                                         std::ofstream& binfile) {
+  // The whole block goes into the engine at once, it only needs another call
+  // when the output buffer is full
+  (*m_file) << space.c_str() << "Block: Decompressed Payload\n";
+  (*m_file) << space.c_str() << print_repeat_word_line("-", 100).c_str()
+            << "\n";
+  (*m_file) << space.c_str() << "  Offset   | Decompress\n";
+  (*m_file) << space.c_str() << print_repeat_word_line("-", 100).c_str()
+            << "\n";
+  m_status.decompression_status = BitGen_DECOMPRESS_ENGINE_GOOD_STATUS;
+  CFG_ASSERT(m_decompressed_data_offset < 4);
+  while (m_status.decompression_status ==
+         BitGen_DECOMPRESS_ENGINE_GOOD_STATUS) {
+    size_t dcmp_out_size = 0;
+    m_status.decompression_status = m_decompress_engine.process_block(
+        data, BitGen_BITSTREAM_BLOCK_SIZE,
+        &m_decompressed_data[m_decompressed_data_offset],
+        m_decompressed_data.size() - m_decompressed_data_offset,
+        dcmp_out_size);
+    if (m_status.decompression_status ==
+        BitGen_DECOMPRESS_ENGINE_ERROR_STATUS) {
+      m_status.status = false;
+      break;
+    } else if (m_status.decompression_status ==
+               BitGen_DECOMPRESS_ENGINE_NEED_INPUT_STATUS) {
+      break;
+    }
+    CFG_ASSERT(dcmp_out_size);
+    size_t total_size = m_decompressed_data_offset + dcmp_out_size;
+    CFG_ASSERT(total_size <= m_decompressed_data.size());
+    size_t word_size = total_size & ~(size_t)(3);
+    binfile.write((char*)(m_decompressed_data.data()), word_size);
+    for (size_t i = 0; i < word_size; i += 32) {
+      (*m_file) << space.c_str()
+                << CFG_print("  %08X |", m_decompressed_size + i).c_str();
+      for (size_t j = i; j < (i + 32) && j < word_size; j += 4) {
+        (*m_file)
+            << CFG_print(" %08X", get_u32(&m_decompressed_data[j])).c_str();
+      }
+      (*m_file) << "\n";
+    }
+    m_decompressed_size += word_size;
+    m_decompressed_data_offset = total_size - word_size;
+    if (m_decompressed_data_offset) {
+      memmove(&m_decompressed_data[0], &m_decompressed_data[word_size],
+              m_decompressed_data_offset);
+    }
+  }
+  if (m_status.decompression_status != BitGen_DECOMPRESS_ENGINE_ERROR_STATUS &&
+      m_decompressed_data_offset != 0) {
+    (*m_file) << space.c_str() << "  Remaining: "
+              << CFG_convert_bytes_to_hex_string(m_decompressed_data.data(),
+                                                 m_decompressed_data_offset,
+                                                 ", ")
+                     .c_str()
+              << "\n";
+  }
+  if (m_status.decompression_status == BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
+    (*m_file) << space.c_str() << "  [DCMP: DONE]\n";
+  }
+}
+
 void BitGen_ANALYZER::post_warning(const std::string& space,
                                    const std::string& msg, bool new_line) {
   CFG_ASSERT(m_file != nullptr);
@@ -1146,14 +1158,23 @@ std::vector<size_t> BitGen_ANALYZER::parse(const std::vector<uint8_t>& data,
                                            bool check_end_size, bool check_crc,
                                            std::string& error_msg,
                                            bool print_msg) {
+  return parse(data.data(), data.size(), check_end_size, check_crc, error_msg,
+               print_msg);
+}
+
+std::vector<size_t> BitGen_ANALYZER::parse(const uint8_t* data,
+                                           size_t data_size,
+                                           bool check_end_size, bool check_crc,
+                                           std::string& error_msg,
+                                           bool print_msg) {
   std::string msg = "\nBitstream Anayzer\n";
   std::vector<size_t> sizes;
-  if (data.size() == 0 || ((data.size() % BitGen_BITSTREAM_BLOCK_SIZE) != 0)) {
-    error_msg = CFG_print("Bitstream has invalid Bytes size %ld", data.size());
+  if (data_size == 0 || ((data_size % BitGen_BITSTREAM_BLOCK_SIZE) != 0)) {
+    error_msg = CFG_print("Bitstream has invalid Bytes size %ld", data_size);
   } else {
     error_msg = "";
     size_t index = 0;
-    while (index < data.size()) {
+    while (index < data_size) {
       std::string identifier = CFG_get_null_terminate_string(&data[index], 4);
       int identifier_index =
           BitGen_PACKER::find_supported_bop_identifier(identifier);
@@ -1165,7 +1186,7 @@ std::vector<size_t> BitGen_ANALYZER::parse(const std::vector<uint8_t>& data,
       }
       size_t size = (size_t)(get_u64(&data[index + 8]));
       if (size == 0 || ((size % BitGen_BITSTREAM_BLOCK_SIZE) != 0) ||
-          (index + size) > data.size()) {
+          (index + size) > data_size) {
         error_msg = CFG_print("BOP Identifier %s has invalid Bytes size %ld",
                               identifier.c_str(), size);
         sizes.clear();
@@ -1186,16 +1207,16 @@ std::vector<size_t> BitGen_ANALYZER::parse(const std::vector<uint8_t>& data,
       if (check_end_size) {
         bool is_last_block = (data[index + 0x780] & 1) != 0;
         size_t end_size = (size_t)(get_u64(&data[index + 0x788]));
-        if ((index + end_size) != data.size()) {
+        if ((index + end_size) != data_size) {
           error_msg = CFG_print(
               "BOP Identifier %s has invalid End Bytes size - Expect %ld but "
               "found",
-              identifier.c_str(), data.size() - index, end_size);
+              identifier.c_str(), data_size - index, end_size);
           sizes.clear();
           break;
         }
         if (is_last_block) {
-          if ((index + size) != data.size()) {
+          if ((index + size) != data_size) {
             error_msg = CFG_print(
                 "Last BOP block bit had been set, but BOP size does not "
                 "indicate this is last block");
@@ -1203,7 +1224,7 @@ std::vector<size_t> BitGen_ANALYZER::parse(const std::vector<uint8_t>& data,
             break;
           }
         } else {
-          if ((index + size) == data.size()) {
+          if ((index + size) == data_size) {
             error_msg = CFG_print(
                 "Last BOP block bit had been not set, but BOP size indicates "
                 "this is last block");
@@ -1227,10 +1248,18 @@ std::vector<size_t> BitGen_ANALYZER::parse(const std::vector<uint8_t>& data,
 void BitGen_ANALYZER::parse_debug(const std::string& input_filepath,
                                   const std::string& output_filepath,
                                   std::vector<uint8_t>& aes_key) {
-  std::vector<uint8_t> data;
-  CFG_read_binary_file(input_filepath, data);
+  // the bitstream is memory mapped instead of read into memory. every BOP is
+  // walked in place block by block and its pages are released once done, so
+  // the memory usage does not grow with the bitstream size
+  CFG_MMAP_FILE input(input_filepath);
+  if (!input.is_open()) {
+    CFG_POST_ERR("Fail to map bitstream %s", input_filepath.c_str());
+    return;
+  }
+  const uint8_t* data = input.data();
   std::string error_msg = "";
-  std::vector<size_t> sizes = parse(data, true, false, error_msg, false);
+  std::vector<size_t> sizes =
+      parse(data, input.size(), true, false, error_msg, false);
   if (error_msg.empty()) {
     std::ofstream file;
     file.open(output_filepath.c_str());
@@ -1245,6 +1274,7 @@ void BitGen_ANALYZER::parse_debug(const std::string& input_filepath,
     for (auto& size : sizes) {
       bool status =
           analyzer.parse_bop(&data[start_index], size, bop_index, start_index);
+      input.release(start_index, size);
       start_index += size;
       bop_index++;
       if (!status) {
@@ -6,6 +6,10 @@
 #include "CFGCommonRS/CFGCommonRS.h"
 #include "CFGCrypto/CFGCrypto_key.h"
 
+// Output buffer of one payload block decompression, a block normally expands
+// within it in a single engine call
+#define BitGen_ANALYZER_DECOMPRESS_BUFFER_SIZE (64 * 1024)
+
 struct BitGen_ANALYZER_BOP_HEADER {
   void reset() {
     identifier = "";
@@ -113,6 +117,9 @@ class BitGen_ANALYZER {
   static std::vector<size_t> parse(const std::vector<uint8_t>& data,
                                    bool check_end_size, bool check_crc,
                                    std::string& error_msg, bool print_msg);
+  static std::vector<size_t> parse(const uint8_t* data, size_t data_size,
+                                   bool check_end_size, bool check_crc,
+                                   std::string& error_msg, bool print_msg);
   static void parse_debug(const std::string& input_filepath,
                           const std::string& output_filepath,
                           std::vector<uint8_t>& aes_key);
@@ -150,6 +157,8 @@ class BitGen_ANALYZER {
                      bool action_force_turn_off_compression, bool action_iv,
                      uint8_t* iv, bool is_last_payload_block,
                      std::ofstream& binfile);
+  void decompress_payload(std::string space, const uint8_t* data,
+                          std::ofstream& binfile);
   void post_warning(const std::string& space, const std::string& msg,
                     bool new_line = true);
   void post_error(const std::string& space, const std::string& msg,
@@ -162,6 +171,7 @@ class BitGen_ANALYZER {
   std::string m_filepath = "";
   std::ofstream* m_file = nullptr;
   std::vector<uint8_t>* m_aes_key = nullptr;
+  CFGOpenSSL_CTR* m_ctr = nullptr;
   const uint8_t* m_current_bop_data = nullptr;
   size_t m_current_bop_data_index = 0;
   size_t m_current_bop_size = 0;
@@ -171,8 +181,9 @@ class BitGen_ANALYZER {
   BitGen_ANALYZER_BOP_HEADER m_header;
   BitGen_ANALYZER_INTEGRITY m_integrity;
   BitGen_DECOMPRESS_ENGINE m_decompress_engine;
-  uint8_t m_decompressed_data[BitGen_BITSTREAM_BLOCK_SIZE] = {0};
+  std::vector<uint8_t> m_decompressed_data;
   size_t m_decompressed_data_offset = 0;
+  size_t m_decompressed_size = 0;
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "BitGen_decompress_engine.h"
 
-#define BitGen_DECOMPRESS_ENGINE_VERSION (0)
+#include <algorithm>
+
+#define BitGen_DECOMPRESS_ENGINE_VERSION (1)
 #define ENABLE_DEBUG (0)
 
 BitGen_DECOMPRESS_ENGINE::BitGen_DECOMPRESS_ENGINE() {
@@ -24,6 +26,10 @@ void BitGen_DECOMPRESS_ENGINE::reset() {
   m_identifier_index = 0;
   m_original_size = 0;
   m_compress_size = 0;
+  m_version = 0;
+  m_segment_size = 0;
+  m_segment_count = 0;
+  m_segment_end = 0;
   m_flag = BitGen_DECOMPRESS_ENGINE_CMP_NONE_TYPE;
   m_flag_repeat = 0;
   m_flag_index = 0;
@@ -47,6 +53,20 @@ void BitGen_DECOMPRESS_ENGINE::reset() {
 BitGen_DECOMPRESS_ENGINE_STATUS BitGen_DECOMPRESS_ENGINE::process(
     const uint8_t* input, const size_t input_size, uint8_t* output,
     const size_t output_size, size_t& current_output_size) {
+  m_bulk = false;
+  return execute(input, input_size, output, output_size, current_output_size);
+}
+
+BitGen_DECOMPRESS_ENGINE_STATUS BitGen_DECOMPRESS_ENGINE::process_block(
+    const uint8_t* input, const size_t input_size, uint8_t* output,
+    const size_t output_size, size_t& current_output_size) {
+  m_bulk = true;
+  return execute(input, input_size, output, output_size, current_output_size);
+}
+
+BitGen_DECOMPRESS_ENGINE_STATUS BitGen_DECOMPRESS_ENGINE::execute(
+    const uint8_t* input, const size_t input_size, uint8_t* output,
+    const size_t output_size, size_t& current_output_size) {
   CFG_ASSERT(input != NULL);
   CFG_ASSERT(input_size > 0);
   CFG_ASSERT(output != NULL);
@@ -101,8 +121,12 @@ BitGen_DECOMPRESS_ENGINE_STATUS BitGen_DECOMPRESS_ENGINE::process(
         break;
       case BitGen_DECOMPRESS_ENGINE_GET_ORIGINAL_SIZE_STATE:
       case BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE:
+      case BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_SIZE_STATE:
         get_information(input, input_size);
         break;
+      case BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_STATE:
+        get_segment(input, input_size);
+        break;
       case BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE:
         get_flag(input, input_size);
         break;
@@ -132,7 +156,8 @@ BitGen_DECOMPRESS_ENGINE_STATUS BitGen_DECOMPRESS_ENGINE::process(
     if (m_status == BitGen_DECOMPRESS_ENGINE_ERROR_STATUS) {
       break;
     } else if (m_done) {
-      if (m_total_input_index == m_compress_size) {
+      if (m_total_input_index == m_compress_size &&
+          (m_version == 0 || m_total_input_index == m_segment_end)) {
         m_status = BitGen_DECOMPRESS_ENGINE_DONE_STATUS;
       } else {
         m_status = BitGen_DECOMPRESS_ENGINE_ERROR_STATUS;
@@ -209,8 +234,9 @@ void BitGen_DECOMPRESS_ENGINE::get_identifier(const uint8_t* input,
   }
   if (m_identifier_index == (size_t)(sizeof(m_identifier))) {
     if (memcmp(m_identifier, "CFG_CMP", 7) == 0 &&
-        m_identifier[7] == BitGen_DECOMPRESS_ENGINE_VERSION) {
+        m_identifier[7] <= BitGen_DECOMPRESS_ENGINE_VERSION) {
       // Good
+      m_version = m_identifier[7];
       m_state = BitGen_DECOMPRESS_ENGINE_GET_ORIGINAL_SIZE_STATE;
     } else {
       m_state = BitGen_DECOMPRESS_ENGINE_ERROR_STATE;
@@ -226,8 +252,11 @@ void BitGen_DECOMPRESS_ENGINE::get_identifier(const uint8_t* input,
 void BitGen_DECOMPRESS_ENGINE::get_information(const uint8_t* input,
                                                const size_t input_size) {
   CFG_ASSERT(m_state == BitGen_DECOMPRESS_ENGINE_GET_ORIGINAL_SIZE_STATE ||
-             m_state == BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE);
-  get_variable_u64(input, input_size, false);
+             m_state == BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE ||
+             m_state == BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_SIZE_STATE);
+  // Segment size is already part of the compressed data
+  get_variable_u64(input, input_size,
+                   m_state == BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_SIZE_STATE);
   if (m_variable_u64_done) {
     if (m_state == BitGen_DECOMPRESS_ENGINE_GET_ORIGINAL_SIZE_STATE) {
       m_state = BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE;
@@ -235,11 +264,25 @@ void BitGen_DECOMPRESS_ENGINE::get_information(const uint8_t* input,
 #if ENABLE_DEBUG
       printf("Original Size: %d\n", (uint32_t)(m_original_size));
 #endif
-    } else {
-      m_state = BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE;
+    } else if (m_state == BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE) {
+      m_state = m_version == 0
+                    ? BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE
+                    : BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_SIZE_STATE;
       m_compress_size = (size_t)(m_variable_u64);
 #if ENABLE_DEBUG
       printf("Compressed Size: %d\n", (uint32_t)(m_compress_size));
+#endif
+    } else {
+      m_segment_size = (size_t)(m_variable_u64);
+      if (m_segment_size == 0 || (m_segment_size % 2048) != 0) {
+        m_state = BitGen_DECOMPRESS_ENGINE_ERROR_STATE;
+        m_error_msgs.push_back(
+            CFG_print("Invalid Segment Size: %ld", m_segment_size));
+      } else {
+        m_state = BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE;
+      }
+#if ENABLE_DEBUG
+      printf("Segment Size: %d\n", (uint32_t)(m_segment_size));
 #endif
     }
     m_variable_u64_done = false;
@@ -248,9 +291,52 @@ void BitGen_DECOMPRESS_ENGINE::get_information(const uint8_t* input,
   }
 }
 
+void BitGen_DECOMPRESS_ENGINE::get_segment(const uint8_t* input,
+                                           const size_t input_size) {
+  CFG_ASSERT(m_state == BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_STATE);
+  CFG_ASSERT(m_version == 1);
+  if (m_variable_u64_index == 0) {
+    // Previous segment must be fully consumed, at segment boundary
+    if ((m_total_output_index % m_segment_size) != 0) {
+      m_state = BitGen_DECOMPRESS_ENGINE_ERROR_STATE;
+      m_error_msgs.push_back(CFG_print(
+          "Segment %ld does not end at segment boundary", m_segment_count));
+      return;
+    } else if (m_segment_count && m_total_input_index != m_segment_end) {
+      m_state = BitGen_DECOMPRESS_ENGINE_ERROR_STATE;
+      m_error_msgs.push_back(CFG_print(
+          "Segment %ld input size does not match with its compressed size",
+          m_segment_count));
+      return;
+    }
+  }
+  get_variable_u64(input, input_size, true);
+  if (m_variable_u64_done) {
+    m_segment_end = m_total_input_index + (size_t)(m_variable_u64);
+    m_segment_count++;
+    if (m_variable_u64 == 0 || m_segment_end > m_compress_size) {
+      m_state = BitGen_DECOMPRESS_ENGINE_ERROR_STATE;
+      m_error_msgs.push_back(
+          CFG_print("Invalid Segment %ld Compressed Size: %ld",
+                    m_segment_count, (size_t)(m_variable_u64)));
+    } else {
+      m_state = BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE;
+    }
+    m_variable_u64_done = false;
+    m_variable_u64_index = 0;
+    m_variable_u64 = 0;
+  }
+}
+
 void BitGen_DECOMPRESS_ENGINE::get_flag(const uint8_t* input,
                                         const size_t input_size) {
   CFG_ASSERT(m_state == BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE);
+  if (m_version == 1 && m_variable_u64_index == 0 &&
+      m_segment_count == (m_total_output_index / m_segment_size)) {
+    // Version 1 - every segment starts with its compressed size
+    m_state = BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_STATE;
+    return;
+  }
   get_variable_u64(input, input_size, true);
   if (m_variable_u64_done) {
     m_flag = (BitGen_DECOMPRESS_ENGINE_CMP_TYPE)(m_variable_u64 & 0x7);
@@ -367,9 +453,19 @@ void BitGen_DECOMPRESS_ENGINE::output_cmp(uint8_t* output,
       m_total_output_index++;
       m_track_cmp |= 1;
     } else if (m_flag_index < m_flag_size) {
-      output[m_output_index++] = m_compress_variable;
-      m_total_output_index++;
-      m_flag_index++;
+      if (m_bulk) {
+        size_t size = std::min(m_flag_size - m_flag_index,
+                               output_size - m_output_index);
+        CFG_ASSERT((m_total_output_index + size) <= m_original_size);
+        memset(&output[m_output_index], m_compress_variable, size);
+        m_output_index += size;
+        m_total_output_index += size;
+        m_flag_index += size;
+      } else {
+        output[m_output_index++] = m_compress_variable;
+        m_total_output_index++;
+        m_flag_index++;
+      }
       m_track_cmp |= (m_flag_index == m_flag_size ? 2 : 0);
     } else if (!m_output_variable &&
                (m_flag == BitGen_DECOMPRESS_ENGINE_CMP_ZERO_VAR_TYPE ||
@@ -429,6 +525,22 @@ void BitGen_DECOMPRESS_ENGINE::output_none(const uint8_t* input,
   CFG_ASSERT(m_state == BitGen_DECOMPRESS_ENGINE_OUTPUT_NONE_STATE);
   CFG_ASSERT(m_total_input_index < m_compress_size);
   CFG_ASSERT(m_total_output_index < m_original_size);
+  if (m_bulk) {
+    size_t size = std::min({m_flag_size - m_flag_index,
+                            input_size - m_input_index,
+                            output_size - m_output_index});
+    CFG_ASSERT((m_total_output_index + size) <= m_original_size);
+    CFG_ASSERT((m_total_input_index + size) <= m_compress_size);
+    memcpy(&output[m_output_index], &input[m_input_index], size);
+    if (m_flag_repeat) {
+      memcpy(&m_none_data[m_flag_index], &input[m_input_index], size);
+    }
+    m_flag_index += size;
+    m_input_index += size;
+    m_output_index += size;
+    m_total_output_index += size;
+    m_total_input_index += size;
+  }
   while (m_flag_index < m_flag_size && m_input_index < input_size &&
          m_output_index < output_size) {
     CFG_ASSERT(m_total_output_index < m_original_size);
@@ -474,6 +586,15 @@ void BitGen_DECOMPRESS_ENGINE::output_none_repeat(uint8_t* output,
   CFG_ASSERT(m_total_input_index <= m_compress_size);
   CFG_ASSERT(m_total_output_index < m_original_size);
   while (m_repeat_index < m_repeat_size) {
+    if (m_bulk) {
+      size_t size = std::min(m_flag_size - m_flag_index,
+                             output_size - m_output_index);
+      CFG_ASSERT((m_total_output_index + size) <= m_original_size);
+      memcpy(&output[m_output_index], &m_none_data[m_flag_index], size);
+      m_output_index += size;
+      m_flag_index += size;
+      m_total_output_index += size;
+    }
     while (m_output_index < output_size && m_flag_index < m_flag_size) {
       CFG_ASSERT(m_total_output_index < m_original_size);
       output[m_output_index++] = m_none_data[m_flag_index++];
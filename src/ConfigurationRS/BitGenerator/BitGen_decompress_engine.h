@@ -14,6 +14,8 @@ enum BitGen_DECOMPRESS_ENGINE_STATE {
   BitGen_DECOMPRESS_ENGINE_GET_IDENTIFIER_STATE,
   BitGen_DECOMPRESS_ENGINE_GET_ORIGINAL_SIZE_STATE,
   BitGen_DECOMPRESS_ENGINE_GET_COMPRESS_SIZE_STATE,
+  BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_SIZE_STATE,
+  BitGen_DECOMPRESS_ENGINE_GET_SEGMENT_STATE,
   BitGen_DECOMPRESS_ENGINE_GET_FLAG_STATE,
   BitGen_DECOMPRESS_ENGINE_GET_VARIABLE_STATE,
   BitGen_DECOMPRESS_ENGINE_GET_REPEAT_STATE,
@@ -39,19 +41,33 @@ class BitGen_DECOMPRESS_ENGINE {
   BitGen_DECOMPRESS_ENGINE();
   ~BitGen_DECOMPRESS_ENGINE();
   void reset();
+  // Byte by byte like the firmware
   BitGen_DECOMPRESS_ENGINE_STATUS process(const uint8_t* input,
                                           const size_t input_size,
                                           uint8_t* output,
                                           const size_t output_size,
                                           size_t& current_output_size);
+  // Same status and output as process(), but runs and none-compressed data
+  // are expanded in bulk. Meant for a whole payload block at a time
+  BitGen_DECOMPRESS_ENGINE_STATUS process_block(const uint8_t* input,
+                                                const size_t input_size,
+                                                uint8_t* output,
+                                                const size_t output_size,
+                                                size_t& current_output_size);
   std::string get_coverage_info();
 
  protected:
   void init();
+  BitGen_DECOMPRESS_ENGINE_STATUS execute(const uint8_t* input,
+                                          const size_t input_size,
+                                          uint8_t* output,
+                                          const size_t output_size,
+                                          size_t& current_output_size);
   void get_variable_u64(const uint8_t* input, const size_t input_size,
                         bool update);
   void get_identifier(const uint8_t* input, const size_t input_size);
   void get_information(const uint8_t* input, const size_t input_size);
+  void get_segment(const uint8_t* input, const size_t input_size);
   void get_flag(const uint8_t* input, const size_t input_size);
   void get_variable(const uint8_t* input, const size_t input_size);
   void get_repeat(const uint8_t* input, const size_t input_size);
@@ -73,6 +89,10 @@ class BitGen_DECOMPRESS_ENGINE {
   size_t m_identifier_index = 0;
   size_t m_original_size = 0;
   size_t m_compress_size = 0;
+  uint8_t m_version = 0;
+  size_t m_segment_size = 0;   // version 1 only
+  size_t m_segment_count = 0;  // number of segment started
+  size_t m_segment_end = 0;    // total input index where the segment ends
   BitGen_DECOMPRESS_ENGINE_CMP_TYPE m_flag =
       BitGen_DECOMPRESS_ENGINE_CMP_NONE_TYPE;
   bool m_flag_repeat = 0;
@@ -90,6 +110,7 @@ class BitGen_DECOMPRESS_ENGINE {
   uint8_t m_track_cmp = 0;
   bool m_output_variable = false;
   bool m_done = false;
+  bool m_bulk = false;
   uint32_t m_coverage = 0;
   std::vector<std::string> m_error_msgs;
 };
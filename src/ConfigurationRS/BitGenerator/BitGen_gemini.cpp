@@ -12,6 +12,112 @@
 #define PCB_PARITY_BIT_SIZE (PCB_UNIT_PARITY_BIT * PCB_UNIT_SIZE)
 #define PCB_CONFIG_ALL_BLOCK_AT_ONCE (1)
 #define PCB_CONFIG_INCLUDE_PARITY (1)
+// Payload bytes of one PCB block
+#if PCB_CONFIG_INCLUDE_PARITY
+#define PCB_PAYLOAD_SIZE ((2 * PCB_USER_DATA_BIT_SIZE) / 8)
+#else
+#define PCB_PAYLOAD_SIZE (PCB_USER_DATA_BIT_SIZE / 8)
+#endif
+// Bits moved per iteration by the word kernels. A chunk plus its bit offset
+// within the first byte always fits a 64 bits word
+#define BITGEN_GEMINI_CHUNK_BITS (56)
+
+static uint64_t BitGen_GEMINI_load(const uint8_t* data, size_t size,
+                                   size_t byte_index) {
+  uint64_t value = 0;
+  if ((byte_index + 8) <= size) {
+    // Fixed size, compiler turns this into single load
+    for (size_t i = 0; i < 8; i++) {
+      value |= (uint64_t)(data[byte_index + i]) << (i * 8);
+    }
+  } else {
+    for (size_t i = 0; (byte_index + i) < size; i++) {
+      value |= (uint64_t)(data[byte_index + i]) << (i * 8);
+    }
+  }
+  return value;
+}
+
+static void BitGen_GEMINI_store(uint8_t* data, size_t size, size_t byte_index,
+                                uint64_t value) {
+  if ((byte_index + 8) <= size) {
+    for (size_t i = 0; i < 8; i++) {
+      data[byte_index + i] = (uint8_t)(value >> (i * 8));
+    }
+  } else {
+    for (size_t i = 0; (byte_index + i) < size; i++) {
+      data[byte_index + i] = (uint8_t)(value >> (i * 8));
+    }
+  }
+}
+
+static uint64_t BitGen_GEMINI_get_bits(const uint8_t* data, size_t size,
+                                       size_t index, size_t bits) {
+  CFG_ASSERT(bits > 0 && bits <= BITGEN_GEMINI_CHUNK_BITS);
+  CFG_ASSERT((index + bits) <= (size * 8));
+  uint64_t value = BitGen_GEMINI_load(data, size, index >> 3) >> (index & 7);
+  return value & ((1ULL << bits) - 1);
+}
+
+static void BitGen_GEMINI_set_bits(uint8_t* data, size_t size, size_t index,
+                                   size_t bits, uint64_t value) {
+  CFG_ASSERT(bits > 0 && bits <= BITGEN_GEMINI_CHUNK_BITS);
+  CFG_ASSERT((index + bits) <= (size * 8));
+  uint64_t mask = ((1ULL << bits) - 1) << (index & 7);
+  uint64_t word = BitGen_GEMINI_load(data, size, index >> 3);
+  word = (word & ~mask) | ((value << (index & 7)) & mask);
+  BitGen_GEMINI_store(data, size, index >> 3, word);
+}
+
+static void BitGen_GEMINI_copy_bits(uint8_t* dest, size_t dest_size,
+                                    size_t dest_index, const uint8_t* src,
+                                    size_t src_size, size_t src_index,
+                                    size_t bits) {
+  CFG_ASSERT((dest_index + bits) <= (dest_size * 8));
+  CFG_ASSERT((src_index + bits) <= (src_size * 8));
+  if ((dest_index & 7) == 0 && (src_index & 7) == 0 && bits >= 8) {
+    memcpy(&dest[dest_index >> 3], &src[src_index >> 3], bits >> 3);
+    dest_index += (bits & ~7);
+    src_index += (bits & ~7);
+    bits &= 7;
+  }
+  while (bits) {
+    size_t size = std::min(bits, (size_t)(BITGEN_GEMINI_CHUNK_BITS));
+    BitGen_GEMINI_set_bits(dest, dest_size, dest_index, size,
+                           BitGen_GEMINI_get_bits(src, src_size, src_index,
+                                                  size));
+    dest_index += size;
+    src_index += size;
+    bits -= size;
+  }
+}
+
+static void BitGen_GEMINI_fill_bits(uint8_t* data, size_t size, size_t index,
+                                    size_t bits, bool value) {
+  while (bits) {
+    size_t chunk = std::min(bits, (size_t)(BITGEN_GEMINI_CHUNK_BITS));
+    BitGen_GEMINI_set_bits(data, size, index, chunk, value ? UINT64_MAX : 0);
+    index += chunk;
+    bits -= chunk;
+  }
+}
+
+static void BitGen_GEMINI_alternate_bits(uint8_t* data, size_t size,
+                                         size_t dest_index,
+                                         const uint8_t* data0,
+                                         const uint8_t* data1,
+                                         size_t src_size, size_t bit_size,
+                                         size_t count) {
+  size_t total_bits = bit_size * count;
+  for (size_t src_index = 0; src_index < total_bits; src_index += bit_size) {
+    BitGen_GEMINI_copy_bits(data, size, dest_index, data0, src_size,
+                            src_index, bit_size);
+    dest_index += bit_size;
+    BitGen_GEMINI_copy_bits(data, size, dest_index, data1, src_size,
+                            src_index, bit_size);
+    dest_index += bit_size;
+  }
+}
 
 BitGen_GEMINI::BitGen_GEMINI(const CFGObject_BITOBJ* bitobj)
     : m_bitobj(bitobj) {
@@ -43,7 +149,8 @@ uint64_t BitGen_GEMINI::align(uint64_t value, uint64_t alignment) {
   return convert_to(value, alignment) * alignment;
 }
 
-void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data) {
+void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data,
+                             uint32_t jobs) {
   BitGen_BITSTREAM_BOP* bop = CFG_MEM_NEW(BitGen_BITSTREAM_BOP);
   // Should use FPGA
   bop->field.identifier = "FPGA";
@@ -60,20 +167,17 @@ void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data) {
     CFG_ASSERT(m_bitobj->configuration.blwl.empty());
     CFG_ASSERT(m_bitobj->check_exist("scan_chain_fcb"));
     CFG_ASSERT(!m_bitobj->check_exist("ql_membank_fcb"));
-    nlohmann::json fcb;
-    fcb["action"] = "old_fcb_config";
-    fcb["cfg_cmd"] = 1;
-    fcb["bit_chain_connection"] = 0;
-    fcb["bit_twist_shift_reg"] = 0;
-    fcb["parallel_chains_count"] = m_bitobj->scan_chain_fcb.width;
+    BitGen_OLD_FCB_CONFIG_FIELD fcb;
+    fcb.cfg_cmd = 1;
+    fcb.bit_chain_connection = 0;
+    fcb.bit_twist_shift_reg = 0;
+    fcb.parallel_chains_count = m_bitobj->scan_chain_fcb.width;
     std::vector<uint8_t> payload = genbits_line_by_line(
         m_bitobj->scan_chain_fcb.data, m_bitobj->scan_chain_fcb.width,
-        m_bitobj->scan_chain_fcb.length, 8, 32,
-        fcb["bit_chain_connection"] != 0, fcb["bit_twist_shift_reg"] != 0);
-    fcb["payload"] = nlohmann::json(payload);
-    bop->actions.push_back(BitGen_JSON::gen_old_fcb_config_action(fcb));
-    BitGen_JSON::zeroize_array_numbers(fcb["payload"]);
-    memset(&payload[0], 0, payload.size());
+        m_bitobj->scan_chain_fcb.length, 8, 32, fcb.bit_chain_connection != 0,
+        fcb.bit_twist_shift_reg != 0);
+    bop->actions.push_back(
+        BitGen_JSON::gen_old_fcb_config_action(fcb, std::move(payload)));
   } else {
     CFG_ASSERT(m_bitobj->configuration.protocol == "ql_memory_bank");
     CFG_ASSERT(m_bitobj->configuration.blwl == "flatten");
@@ -81,14 +185,15 @@ void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data) {
     CFG_ASSERT(m_bitobj->check_exist("ql_membank_fcb"));
     CFG_ASSERT(m_bitobj->ql_membank_fcb.bl);
     CFG_ASSERT(m_bitobj->ql_membank_fcb.wl);
-    nlohmann::json fcb;
-    fcb["action"] = "fcb_config";
-    fcb["bitline_byte_size"] = ((m_bitobj->ql_membank_fcb.bl + 31) / 32) * 4;
-    fcb["readback"] = 0;
+    BitGen_FCB_CONFIG_FIELD fcb;
+    fcb.bitline_byte_size = ((m_bitobj->ql_membank_fcb.bl + 31) / 32) * 4;
+    fcb.readback = 0;
     uint32_t bl_byte_size = (m_bitobj->ql_membank_fcb.bl + 7) / 8;
     CFG_ASSERT((uint32_t)(m_bitobj->ql_membank_fcb.data.size()) ==
                (m_bitobj->ql_membank_fcb.wl * bl_byte_size));
     std::vector<uint8_t> payload;
+    payload.reserve((size_t)(m_bitobj->ql_membank_fcb.wl) *
+                    fcb.bitline_byte_size);
     uint32_t padding = 0;
     for (uint32_t wl = 0, index = 0; wl < m_bitobj->ql_membank_fcb.wl;
          wl++, index += bl_byte_size) {
@@ -101,11 +206,8 @@ void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data) {
         padding++;
       }
     }
-    fcb["payload"] = nlohmann::json(payload);
-    bop->actions.push_back(BitGen_JSON::gen_fcb_config_action(fcb));
-    BitGen_JSON::zeroize_array_numbers(fcb["payload"]);
-    memset(&payload[0], 0, payload.size());
-    payload.clear();
+    bop->actions.push_back(
+        BitGen_JSON::gen_fcb_config_action(fcb, std::move(payload)));
   }
 
   // ICB data
@@ -138,153 +240,80 @@ void BitGen_GEMINI::generate(std::vector<BitGen_BITSTREAM_BOP*>& data) {
                              col_stride);
 #if PCB_CONFIG_ALL_BLOCK_AT_ONCE
     // Send all block data in one action
-    nlohmann::json pcb;
-    // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
-    pcb["action"] = "pcb_config_with_parity";
-  #else
-    pcb["action"] = "pcb_config";
-  #endif
-    // clang-format on
-    pcb["ram_block_count"] = (uint32_t)(m_bitobj->pcb.size());
-    pcb["pl_ctl_skew"] = 3;
-    // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
-    pcb["pl_ctl_parity"] = 0;
-  #else
-    pcb["pl_ctl_parity"] = 1;
-  #endif
-    // clang-format on
-    pcb["pl_ctl_even"] = 0;
-    pcb["pl_ctl_split"] = 0;
-    pcb["pl_select_offset"] = 0;
-    pcb["pl_select_row"] = row_offset;
-    pcb["pl_select_col"] = col_offset;
-    pcb["pl_row_offset"] = row_offset;
-    pcb["pl_row_stride"] = row_stride;
-    pcb["pl_col_offset"] = col_offset;
-    pcb["pl_col_stride"] = col_stride;
+    BitGen_PCB_CONFIG_FIELD pcb;
+    pcb.ram_block_count = (uint32_t)(m_bitobj->pcb.size());
+    pcb.pl_ctl_skew = 3;
     // clang-format off
   #if PCB_CONFIG_INCLUDE_PARITY
-    pcb["reserved"] = 0;
+    pcb.pl_ctl_parity = 0;
   #else
-    pcb["pl_extra_w32"] = 0;
-    pcb["pl_extra_w33"] = 0;
-    pcb["pl_extra_w34"] = 0;
-    pcb["pl_extra_w35"] = 0;
+    pcb.pl_ctl_parity = 1;
   #endif
     // clang-format on
-    std::vector<uint8_t> payload;
-    for (auto& pcbobj : m_bitobj->pcb) {
-      CFG_ASSERT(pcbobj->bits == PCB_BIT_SIZE);
-      CFG_ASSERT(pcbobj->data.size() == (PCB_BIT_SIZE + 7) / 8);
-      std::vector<uint8_t> user_data;
-      std::vector<uint8_t> parity;
-      get_pcb_user_data_and_parity(pcbobj->data, user_data, parity);
-      CFG_ASSERT(user_data.size() == ((PCB_USER_DATA_BIT_SIZE + 7) / 8));
-      CFG_ASSERT(parity.size() == ((PCB_PARITY_BIT_SIZE + 7) / 8));
-      // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
-      adjust_data_bit_size(parity, PCB_UNIT_PARITY_BIT,
-                           PCB_UNIT_USER_DATA_BIT, PCB_UNIT_SIZE);
-      CFG_ASSERT(user_data.size() == parity.size());
-      append_alternate_data(payload, user_data, parity,
-                            PCB_UNIT_USER_DATA_BIT, PCB_UNIT_SIZE, 
-                            payload.size() * 8, true);
-  #else
-      payload.insert(payload.end(), user_data.begin(), user_data.end());
-  #endif
-      // clang-format on
-      memset(&user_data[0], 0, user_data.size());
-      memset(&parity[0], 0, parity.size());
-      user_data.clear();
-      parity.clear();
-    }
-    pcb["payload"] = nlohmann::json(payload);
+    pcb.pl_ctl_even = 0;
+    pcb.pl_ctl_split = 0;
+    pcb.pl_select_offset = 0;
+    pcb.pl_select_row = row_offset;
+    pcb.pl_select_col = col_offset;
+    pcb.pl_row_offset = row_offset;
+    pcb.pl_row_stride = row_stride;
+    pcb.pl_col_offset = col_offset;
+    pcb.pl_col_stride = col_stride;
+    // Blocks are independent and of fixed size, each is generated into its
+    // own slice of the payload
+    std::vector<uint8_t> payload(m_bitobj->pcb.size() * PCB_PAYLOAD_SIZE);
+    CFG_parallel_for(m_bitobj->pcb.size(), jobs, [&](size_t i) {
+      pcb_generate(m_bitobj->pcb[i], &payload[i * PCB_PAYLOAD_SIZE]);
+    });
     // clang-format off
   #if PCB_CONFIG_INCLUDE_PARITY
-    bop->actions.push_back(BitGen_JSON::gen_pcb_config_with_parity_action(pcb));
+    bop->actions.push_back(
+        BitGen_JSON::gen_pcb_config_with_parity_action(pcb,
+                                                       std::move(payload)));
   #else
-    bop->actions.push_back(BitGen_JSON::gen_pcb_config_action(pcb));
+    bop->actions.push_back(
+        BitGen_JSON::gen_pcb_config_action(pcb, std::move(payload)));
   #endif
     // clang-format on
-    BitGen_JSON::zeroize_array_numbers(pcb["payload"]);
-    memset(&payload[0], 0, payload.size());
-    payload.clear();
 #else
     // Send block data in individual action
-    for (auto& pcbobj : m_bitobj->pcb) {
-      CFG_ASSERT(pcbobj->bits == PCB_BIT_SIZE);
-      CFG_ASSERT(pcbobj->data.size() == (PCB_BIT_SIZE + 7) / 8);
-      std::vector<uint8_t> payload;
-      std::vector<uint8_t> user_data;
-      std::vector<uint8_t> parity;
-      get_pcb_user_data_and_parity(pcbobj->data, user_data, parity);
-      // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
-      adjust_data_bit_size(parity, PCB_UNIT_PARITY_BIT, PCB_UNIT_USER_DATA_BIT,
-                           PCB_UNIT_SIZE);
-      CFG_ASSERT(user_data.size() == parity.size());
-      append_alternate_data(payload, user_data, parity, PCB_UNIT_USER_DATA_BIT,
-                            PCB_UNIT_SIZE, payload.size() * 8, true);
-  #else
-      payload.insert(payload.end(), user_data.begin(), user_data.end());
-  #endif
-      // clang-format on
-      nlohmann::json pcb;
-      // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
-      pcb["action"] = "pcb_config_with_parity";
-  #else
-      pcb["action"] = "pcb_config";
-  #endif
-      // clang-format on
-      pcb["ram_block_count"] = 1;
+    std::vector<std::vector<uint8_t>> payloads(m_bitobj->pcb.size());
+    CFG_parallel_for(m_bitobj->pcb.size(), jobs, [&](size_t i) {
+      payloads[i].resize(PCB_PAYLOAD_SIZE);
+      pcb_generate(m_bitobj->pcb[i], &payloads[i][0]);
+    });
+    for (size_t i = 0; i < m_bitobj->pcb.size(); i++) {
+      const CFGObject_BITOBJ_PCB* pcbobj = m_bitobj->pcb[i];
+      BitGen_PCB_CONFIG_FIELD pcb;
+      pcb.ram_block_count = 1;
       // https://github.com/RapidSilicon/virgo/blob/060ab0e60de9d0f45fb875cc09c04bec0781861e/DV/virgo_verif_env/bcpu_real_core_c_tests/IPs/PCB/bcpu_real_pcb_a_inc_test/program.c#L20-L21
-      pcb["pl_ctl_skew"] = 3;
+      pcb.pl_ctl_skew = 3;
       // clang-format off
   #if PCB_CONFIG_INCLUDE_PARITY
-      pcb["pl_ctl_parity"] = 0;
+      pcb.pl_ctl_parity = 0;
   #else
-      pcb["pl_ctl_parity"] = 1;
+      pcb.pl_ctl_parity = 1;
   #endif
       // clang-format on
-      pcb["pl_ctl_even"] = 0;
-      pcb["pl_ctl_split"] = 0;
-      pcb["pl_select_offset"] = 0;
-      pcb["pl_select_row"] = pcbobj->y;
-      pcb["pl_select_col"] = pcbobj->x;
+      pcb.pl_ctl_even = 0;
+      pcb.pl_ctl_split = 0;
+      pcb.pl_select_offset = 0;
+      pcb.pl_select_row = pcbobj->y;
+      pcb.pl_select_col = pcbobj->x;
       // https://github.com/RapidSilicon/virgo/blob/main/DV/virgo_verif_env/bcpu_real_core_c_tests/IPs/PCB/program.h#L10-L13
-      pcb["pl_row_offset"] = row_offset;
-      pcb["pl_row_stride"] = row_stride;
-      pcb["pl_col_offset"] = col_offset;
-      pcb["pl_col_stride"] = col_stride;
+      pcb.pl_row_offset = row_offset;
+      pcb.pl_row_stride = row_stride;
+      pcb.pl_col_offset = col_offset;
+      pcb.pl_col_stride = col_stride;
       // clang-format off
   #if PCB_CONFIG_INCLUDE_PARITY
-      pcb["reserved"] = 0;
+      bop->actions.push_back(BitGen_JSON::gen_pcb_config_with_parity_action(
+          pcb, std::move(payloads[i])));
   #else
-      pcb["pl_extra_w32"] = 0;
-      pcb["pl_extra_w33"] = 0;
-      pcb["pl_extra_w34"] = 0;
-      pcb["pl_extra_w35"] = 0;
-  #endif
-      // clang-format on
-      pcb["payload"] = nlohmann::json(payload);
-      // clang-format off
-  #if PCB_CONFIG_INCLUDE_PARITY
       bop->actions.push_back(
-          BitGen_JSON::gen_pcb_config_with_parity_action(pcb));
-  #else
-      bop->actions.push_back(BitGen_JSON::gen_pcb_config_action(pcb));
+          BitGen_JSON::gen_pcb_config_action(pcb, std::move(payloads[i])));
   #endif
       // clang-format on
-      BitGen_JSON::zeroize_array_numbers(pcb["payload"]);
-      memset(&payload[0], 0, payload.size());
-      memset(&user_data[0], 0, user_data.size());
-      memset(&parity[0], 0, parity.size());
-      payload.clear();
-      user_data.clear();
-      parity.clear();
     }
 #endif
   }
@@ -298,7 +327,7 @@ void BitGen_GEMINI::icb_generate(BitGen_BITSTREAM_BOP*& bop,
                                  const std::vector<uint8_t>& data) {
   CFG_ASSERT(bits);
   CFG_ASSERT(data.size() == (size_t)((bits + 7) / 8));
-  nlohmann::json icb;
+  BitGen_ICB_CONFIG_FIELD icb;
 #if ICB_APPEND_AT_FRONT
   // This is to put the dummy bits at the front
   std::vector<uint8_t> payload((size_t)(((bits + 31) / 32) * 4), 0);
@@ -322,18 +351,40 @@ void BitGen_GEMINI::icb_generate(BitGen_BITSTREAM_BOP*& bop,
     payload.push_back(0);
   }
 #endif
-  icb["action"] = "icb_config";
-  icb["cfg_cmd"] = 0;
-  icb["bit_twist"] = 0;
-  icb["byte_twist"] = 0;
-  icb["is_data_or_not_cmd"] = 0;
-  icb["update"] = 1;
-  icb["capture"] = 0;
-  icb["payload"] = nlohmann::json(payload);
-  bop->actions.push_back(BitGen_JSON::gen_icb_config_action(icb));
-  BitGen_JSON::zeroize_array_numbers(icb["payload"]);
-  memset(&payload[0], 0, payload.size());
-  payload.clear();
+  icb.cfg_cmd = 0;
+  icb.bit_twist = 0;
+  icb.byte_twist = 0;
+  icb.is_data_or_not_cmd = 0;
+  icb.update = 1;
+  icb.capture = 0;
+  bop->actions.push_back(
+      BitGen_JSON::gen_icb_config_action(icb, std::move(payload)));
+}
+
+void BitGen_GEMINI::pcb_generate(const CFGObject_BITOBJ_PCB* pcbobj,
+                                 uint8_t* payload) {
+  CFG_ASSERT(pcbobj->bits == PCB_BIT_SIZE);
+  CFG_ASSERT(pcbobj->data.size() == (PCB_BIT_SIZE + 7) / 8);
+  std::vector<uint8_t> user_data;
+  std::vector<uint8_t> parity;
+  get_pcb_user_data_and_parity(pcbobj->data, user_data, parity);
+  CFG_ASSERT(user_data.size() == ((PCB_USER_DATA_BIT_SIZE + 7) / 8));
+  CFG_ASSERT(parity.size() == ((PCB_PARITY_BIT_SIZE + 7) / 8));
+#if PCB_CONFIG_INCLUDE_PARITY
+  adjust_data_bit_size(parity, PCB_UNIT_PARITY_BIT, PCB_UNIT_USER_DATA_BIT,
+                       PCB_UNIT_SIZE);
+  CFG_ASSERT(user_data.size() == parity.size());
+  // Only touch the bytes of this block, other blocks might be generated at the
+  // same time
+  BitGen_GEMINI_alternate_bits(payload, PCB_PAYLOAD_SIZE, 0, &user_data[0],
+                               &parity[0], user_data.size(),
+                               PCB_UNIT_USER_DATA_BIT, PCB_UNIT_SIZE);
+#else
+  CFG_ASSERT(user_data.size() == PCB_PAYLOAD_SIZE);
+  memcpy(payload, &user_data[0], user_data.size());
+#endif
+  memset(&user_data[0], 0, user_data.size());
+  memset(&parity[0], 0, parity.size());
 }
 
 std::vector<uint8_t> BitGen_GEMINI::genbits_line_by_line(
@@ -364,17 +415,23 @@ std::vector<uint8_t> BitGen_GEMINI::genbits_line_by_line(
     if (pad_reversed) {
       dest_index += padding_bits;
     }
-    for (uint64_t bit = 0; bit < line_bits; bit++) {
-      if (src_data[src_index >> 3] & (1 << (src_index & 7))) {
-        dest_data[dest_index >> 3] |= (1 << (dest_index & 7));
+    // Copy the line unit by unit (or as a whole if the unit is not reversed)
+    uint64_t remaining_bits = line_bits;
+    while (remaining_bits) {
+      uint64_t bits = remaining_bits;
+      if (unit_reversed) {
+        bits = std::min(bits, dest_unit_bits - (dest_index % dest_unit_bits));
       }
-      src_index++;
-      dest_index++;
-      if (unit_reversed && bit < (line_bits - 1) &&
-          (dest_index % dest_unit_bits) == 0) {
-        dest_index -= (2 * dest_unit_bits);
-        CFG_ASSERT(dest_index >= original_dest_index);
-        CFG_ASSERT(dest_index < end_dest_index);
+      CFG_ASSERT(dest_index >= original_dest_index);
+      CFG_ASSERT((dest_index + bits) <= end_dest_index);
+      BitGen_GEMINI_copy_bits(&dest_data[0], dest_data.size(), dest_index,
+                              &src_data[0], src_data.size(), src_index,
+                              size_t(bits));
+      src_index += size_t(bits);
+      dest_index += size_t(bits);
+      remaining_bits -= bits;
+      if (remaining_bits) {
+        dest_index -= size_t(2 * dest_unit_bits);
       }
     }
   }
@@ -382,7 +439,7 @@ std::vector<uint8_t> BitGen_GEMINI::genbits_line_by_line(
 }
 
 void BitGen_GEMINI::get_pcb_user_data_and_parity(
-    std::vector<uint8_t>& data, std::vector<uint8_t>& user_data,
+    const std::vector<uint8_t>& data, std::vector<uint8_t>& user_data,
     std::vector<uint8_t>& parity) {
   CFG_ASSERT(data.size() == (PCB_BIT_SIZE + 7) / 8);
   if (user_data.size()) {
@@ -399,50 +456,36 @@ void BitGen_GEMINI::get_pcb_user_data_and_parity(
   parity.resize((PCB_PARITY_BIT_SIZE + 7) / 8);
   memset(&user_data[0], 0, user_data.size());
   memset(&parity[0], 0, parity.size());
-  uint8_t* data0 = &data[0];
-  uint8_t* data1 = &data[((PCB_BIT_SIZE + 7) / 8) / 2];
-  uint32_t index = 0;
-  uint32_t half_index = 0;
-  uint32_t payload_index = 0;
-  uint32_t parity_index = 0;
-  for (uint32_t i = 0; i < PCB_UNIT_SIZE; i++) {
-    uint32_t temp = half_index;
-    for (uint32_t j = 0;
-         j < ((PCB_UNIT_USER_DATA_BIT + PCB_UNIT_PARITY_BIT) / 2);
-         j++, index++, temp++) {
-      if (j < (PCB_UNIT_USER_DATA_BIT / 2)) {
-        if (data0[temp >> 3] & (1 << (temp & 7))) {
-          user_data[payload_index >> 3] |= (1 << (payload_index & 7));
-        }
-        payload_index++;
-      } else {
-        if (data0[temp >> 3] & (1 << (temp & 7))) {
-          parity[parity_index >> 3] |= (1 << (parity_index & 7));
-        }
-        parity_index++;
-      }
-    }
-    temp = half_index;
-    for (uint32_t j = 0;
-         j < ((PCB_UNIT_USER_DATA_BIT + PCB_UNIT_PARITY_BIT) / 2);
-         j++, index++, temp++, half_index++) {
-      if (j < (PCB_UNIT_USER_DATA_BIT / 2)) {
-        if (data1[temp >> 3] & (1 << (temp & 7))) {
-          user_data[payload_index >> 3] |= (1 << (payload_index & 7));
-        }
-        payload_index++;
-      } else {
-        if (data1[temp >> 3] & (1 << (temp & 7))) {
-          parity[parity_index >> 3] |= (1 << (parity_index & 7));
-        }
-        parity_index++;
-      }
-    }
+  // Each unit is half user data + half parity from each of the two halves of
+  // the data. Gather them word by word
+  const size_t half_size = ((PCB_BIT_SIZE + 7) / 8) / 2;
+  const uint8_t* data0 = &data[0];
+  const uint8_t* data1 = &data[half_size];
+  const size_t half_unit_bits =
+      (PCB_UNIT_USER_DATA_BIT + PCB_UNIT_PARITY_BIT) / 2;
+  const size_t half_user_data_bits = PCB_UNIT_USER_DATA_BIT / 2;
+  const size_t half_parity_bits = PCB_UNIT_PARITY_BIT / 2;
+  size_t half_index = 0;
+  for (size_t i = 0; i < PCB_UNIT_SIZE; i++, half_index += half_unit_bits) {
+    uint64_t value0 =
+        BitGen_GEMINI_get_bits(data0, half_size, half_index, half_unit_bits);
+    uint64_t value1 =
+        BitGen_GEMINI_get_bits(data1, half_size, half_index, half_unit_bits);
+    uint64_t user_mask = (1ULL << half_user_data_bits) - 1;
+    uint64_t parity_mask = (1ULL << half_parity_bits) - 1;
+    BitGen_GEMINI_set_bits(
+        &user_data[0], user_data.size(), i * PCB_UNIT_USER_DATA_BIT,
+        PCB_UNIT_USER_DATA_BIT,
+        (value0 & user_mask) |
+            ((value1 & user_mask) << half_user_data_bits));
+    BitGen_GEMINI_set_bits(
+        &parity[0], parity.size(), i * PCB_UNIT_PARITY_BIT,
+        PCB_UNIT_PARITY_BIT,
+        ((value0 >> half_user_data_bits) & parity_mask) |
+            (((value1 >> half_user_data_bits) & parity_mask)
+             << half_parity_bits));
   }
-  CFG_ASSERT(index == PCB_BIT_SIZE);
   CFG_ASSERT(half_index == (PCB_BIT_SIZE / 2));
-  CFG_ASSERT(payload_index == PCB_USER_DATA_BIT_SIZE);
-  CFG_ASSERT(parity_index == PCB_PARITY_BIT_SIZE);
 }
 
 void BitGen_GEMINI::get_pcb_xy_offset_stride(
@@ -519,24 +562,6 @@ void BitGen_GEMINI::get_pcb_xy_offset_stride(
   }
 }
 
-void BitGen_GEMINI::append_assign_data_bit(std::vector<uint8_t>& data,
-                                           bool value, size_t index) {
-  while (index >= (data.size() * 8)) {
-    data.push_back(0);
-  }
-  CFG_ASSERT(index < (data.size() * 8));
-  if (value) {
-    data[index >> 3] |= (1 << (index & 7));
-  } else {
-    data[index >> 3] &= (uint8_t)(~(1 << (index & 7)));
-  }
-}
-
-bool BitGen_GEMINI::get_data_bit(std::vector<uint8_t>& data, size_t index) {
-  CFG_ASSERT(index < (data.size() * 8));
-  return (data[index >> 3] & (1 << (index & 7))) != 0;
-}
-
 void BitGen_GEMINI::adjust_data_bit_size(std::vector<uint8_t>& data,
                                          size_t original_size, size_t new_size,
                                          size_t count, bool value_to_adjust,
@@ -547,32 +572,26 @@ void BitGen_GEMINI::adjust_data_bit_size(std::vector<uint8_t>& data,
   CFG_ASSERT(count);
   size_t original_total_bits = original_size * count;
   CFG_ASSERT(original_total_bits <= (data.size() * 8));
-  std::vector<uint8_t> new_data;
-  for (size_t src = 0, dest = 0; src < (data.size() * 8); src++) {
-    if (src < original_total_bits) {
-      size_t src_unit_index = src % original_size;
-      if (src_unit_index < new_size) {
-        // get data from src
-        append_assign_data_bit(new_data, get_data_bit(data, src), dest);
-        dest++;
-      }
-      if (src_unit_index == (original_size - 1)) {
-        // hit the src unit boundary
-        if (new_size > original_size) {
-          // Start to append
-          for (uint32_t temp = original_size; temp < new_size; temp++, dest++) {
-            append_assign_data_bit(new_data, value_to_adjust, dest);
-          }
-        }
-      }
-    } else {
-      if (include_remaining) {
-        append_assign_data_bit(new_data, get_data_bit(data, src), dest);
-        dest++;
-      } else {
-        break;
-      }
+  size_t remaining_bits =
+      include_remaining ? ((data.size() * 8) - original_total_bits) : 0;
+  size_t new_total_bits = (new_size * count) + remaining_bits;
+  std::vector<uint8_t> new_data((new_total_bits + 7) / 8);
+  size_t copy_size = std::min(original_size, new_size);
+  size_t src = 0;
+  size_t dest = 0;
+  for (size_t i = 0; i < count; i++) {
+    BitGen_GEMINI_copy_bits(&new_data[0], new_data.size(), dest, &data[0],
+                            data.size(), src, copy_size);
+    if (new_size > original_size) {
+      BitGen_GEMINI_fill_bits(&new_data[0], new_data.size(), dest + copy_size,
+                              new_size - original_size, value_to_adjust);
     }
+    src += original_size;
+    dest += new_size;
+  }
+  if (remaining_bits) {
+    BitGen_GEMINI_copy_bits(&new_data[0], new_data.size(), dest, &data[0],
+                            data.size(), src, remaining_bits);
   }
   memset(&data[0], 0, data.size());
   data.clear();
@@ -592,16 +611,13 @@ void BitGen_GEMINI::append_alternate_data(std::vector<uint8_t>& data,
   CFG_ASSERT(data0.size() == data1.size());
   size_t total_bits = bit_size * count;
   CFG_ASSERT(total_bits <= (data0.size() * 8));
-  size_t src_index = 0;
-  for (size_t i = 0; i < count; i++) {
-    for (size_t j = 0, k = src_index; j < bit_size; j++, k++, dest_index++) {
-      append_assign_data_bit(data, get_data_bit(data0, k), dest_index);
-    }
-    for (size_t j = 0, k = src_index; j < bit_size; j++, k++, dest_index++) {
-      append_assign_data_bit(data, get_data_bit(data1, k), dest_index);
-    }
-    src_index += bit_size;
+  size_t end_index = dest_index + (2 * total_bits);
+  if (end_index > (data.size() * 8)) {
+    data.resize((end_index + 7) / 8, 0);
   }
+  BitGen_GEMINI_alternate_bits(&data[0], data.size(), dest_index, &data0[0],
+                               &data1[0], data0.size(), bit_size, count);
+  dest_index = end_index;
   if (check_byte_alignment) {
     CFG_ASSERT((dest_index % 8) == 0);
   }
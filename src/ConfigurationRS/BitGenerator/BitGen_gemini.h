@@ -7,11 +7,12 @@
 class BitGen_GEMINI {
  public:
   BitGen_GEMINI(const CFGObject_BITOBJ* bitobj);
-  void generate(std::vector<BitGen_BITSTREAM_BOP*>& data);
+  void generate(std::vector<BitGen_BITSTREAM_BOP*>& data, uint32_t jobs = 1);
 
  protected:
   void icb_generate(BitGen_BITSTREAM_BOP*& bop, const uint32_t bits,
                     const std::vector<uint8_t>& data);
+  void pcb_generate(const CFGObject_BITOBJ_PCB* pcbobj, uint8_t* payload);
   uint64_t convert_to(uint64_t value, uint64_t unit);
   uint64_t convert_to8(uint64_t value);
   uint64_t convert_to16(uint64_t value);
@@ -22,15 +23,12 @@ class BitGen_GEMINI {
       const std::vector<uint8_t>& src_data, uint64_t line_bits,
       uint64_t total_line, uint64_t src_unit_bits, uint64_t dest_unit_bits,
       bool pad_reversed, bool unit_reversed);
-  void get_pcb_user_data_and_parity(std::vector<uint8_t>& data,
+  void get_pcb_user_data_and_parity(const std::vector<uint8_t>& data,
                                     std::vector<uint8_t>& user_data,
                                     std::vector<uint8_t>& parity);
   void get_pcb_xy_offset_stride(const std::vector<CFGObject_BITOBJ_PCB*>& pcbs,
                                 uint32_t& row_offset, uint32_t& row_stride,
                                 uint32_t& col_offset, uint32_t& col_stride);
-  bool get_data_bit(std::vector<uint8_t>& data, size_t index);
-  void append_assign_data_bit(std::vector<uint8_t>& data, bool value,
-                              size_t index);
   void adjust_data_bit_size(std::vector<uint8_t>& data, size_t original_size,
                             size_t new_size, size_t count,
                             bool value_to_adjust = false,
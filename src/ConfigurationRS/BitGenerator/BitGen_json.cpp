@@ -325,15 +325,40 @@ static void BitGen_JSON_validate_action(const std::string& info,
   BitGen_JSON_ensure_dict_key_exists(info, json, keys);
 }
 
+static void BitGen_JSON_set_action_field(
+    std::vector<uint8_t>& data, std::vector<uint8_t>& mask,
+    const std::vector<uint8_t>& u8s,
+    const std::pair<uint32_t, uint32_t>& position) {
+  uint32_t start_index = position.first;
+  uint32_t size = position.second;
+  uint32_t need_byte_size = 0;
+  CFG_ASSERT(size);
+  CFG_ASSERT(size <= (uint32_t)(u8s.size() * 8));
+  for (uint32_t i = 0; i < size; i++, start_index++) {
+    need_byte_size = (start_index / 8) + 1;
+    CFG_ASSERT(need_byte_size);
+    // limit the field -- if too much, does not make sense
+    CFG_ASSERT(need_byte_size <= 128);
+    while (data.size() < need_byte_size) {
+      data.push_back(0);
+      mask.push_back(0);
+    }
+    // Make sure no collision
+    CFG_ASSERT((mask[start_index >> 3] & (1 << (start_index & 7))) == 0);
+    mask[start_index >> 3] |= (1 << (start_index & 7));
+    // Set bit
+    if (u8s[i >> 3] & (1 << (i & 7))) {
+      data[start_index >> 3] |= (1 << (start_index & 7));
+    }
+  }
+}
+
 static std::vector<uint8_t> BitGen_JSON_gen_action_field(
     const nlohmann::json& json, const BitGen_JSON_ACTION_FIELD* fields) {
   CFG_ASSERT(fields != nullptr);
   CFG_ASSERT(json.is_object());
   std::vector<uint8_t> data;
   std::vector<uint8_t> mask;
-  uint32_t start_index = 0;
-  uint32_t size = 0;
-  uint32_t need_byte_size = 0;
   for (auto& iter : *fields) {
     CFG_ASSERT_MSG(json.contains(iter.first),
                    "Expect key \"%s\" in the object but it is not found",
@@ -344,32 +369,34 @@ static std::vector<uint8_t> BitGen_JSON_gen_action_field(
     } else {
       uint64_t u64 = BitGen_JSON_to_u64(json[iter.first]);
       CFG_append_u64(u8s, u64);
+      CFG_ASSERT(iter.second.second <= 64);
     }
-    start_index = iter.second.first;
-    size = iter.second.second;
-    CFG_ASSERT(size);
-    if (!json[iter.first].is_array()) {
-      CFG_ASSERT(size <= 64);
-    }
-    CFG_ASSERT(size <= (uint32_t)(u8s.size() * 8));
-    for (uint32_t i = 0; i < size; i++, start_index++) {
-      need_byte_size = (start_index / 8) + 1;
-      CFG_ASSERT(need_byte_size);
-      // limit the field -- if too much, does not make sense
-      CFG_ASSERT(need_byte_size <= 128);
-      while (data.size() < need_byte_size) {
-        data.push_back(0);
-        mask.push_back(0);
-      }
-      // Make sure no collision
-      CFG_ASSERT((mask[start_index >> 3] & (1 << (start_index & 7))) == 0);
-      mask[start_index >> 3] |= (1 << (start_index & 7));
-      // Set bit
-      if (u8s[i >> 3] & (1 << (i & 7))) {
-        data[start_index >> 3] |= (1 << (start_index & 7));
-      }
-    }
+    BitGen_JSON_set_action_field(data, mask, u8s, iter.second);
+  }
+  CFG_ASSERT(data.size() <= 128);
+  while (data.size() % 4) {
+    data.push_back(0);
+  }
+  return data;
+}
+
+static std::vector<uint8_t> BitGen_JSON_gen_action_field(
+    const std::map<std::string, uint64_t>& values,
+    const BitGen_JSON_ACTION_FIELD* fields) {
+  CFG_ASSERT(fields != nullptr);
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> mask;
+  for (auto& iter : *fields) {
+    auto value = values.find(iter.first);
+    CFG_ASSERT_MSG(value != values.end(),
+                   "Expect field \"%s\" but it is not found",
+                   iter.first.c_str());
+    std::vector<uint8_t> u8s;
+    CFG_append_u64(u8s, value->second);
+    CFG_ASSERT(iter.second.second <= 64);
+    BitGen_JSON_set_action_field(data, mask, u8s, iter.second);
   }
+  CFG_ASSERT(values.size() == fields->size());
   CFG_ASSERT(data.size() <= 128);
   while (data.size() % 4) {
     data.push_back(0);
@@ -541,6 +568,93 @@ BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_pcb_config_with_parity_action(
                              false);
 }
 
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_standard_action(
+    const std::map<std::string, uint64_t>& values,
+    std::vector<uint8_t>&& payload, const std::string name, uint16_t cmd,
+    bool has_original_payload_size, bool has_checksum) {
+  const BitGen_JSON_ACTION_FIELD* fields =
+      BitGen_JSON_get_action_database(name);
+  CFG_ASSERT(fields != nullptr);
+  CFG_ASSERT(payload.size() && (payload.size() % 4) == 0);
+  BitGen_BITSTREAM_ACTION* action = CFG_MEM_NEW(BitGen_BITSTREAM_ACTION, cmd);
+  action->has_original_payload_size = has_original_payload_size;
+  action->has_checksum = has_checksum;
+  action->field = BitGen_JSON_gen_action_field(values, fields);
+  CFG_ASSERT((action->field.size() % 4) == 0);
+  action->payload = std::move(payload);
+  return action;
+}
+
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_fcb_config_action(
+    const BitGen_FCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload) {
+  return gen_standard_action({{"bitline_byte_size", field.bitline_byte_size},
+                              {"readback", field.readback}},
+                             std::move(payload), "fcb_config", 0x002, false,
+                             true);
+}
+
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_old_fcb_config_action(
+    const BitGen_OLD_FCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload) {
+  return gen_standard_action(
+      {{"cfg_cmd", field.cfg_cmd},
+       {"bit_twist_shift_reg", field.bit_twist_shift_reg},
+       {"bit_chain_connection", field.bit_chain_connection},
+       {"parallel_chains_count", field.parallel_chains_count}},
+      std::move(payload), "old_fcb_config", 0x802, false, true);
+}
+
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_icb_config_action(
+    const BitGen_ICB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload) {
+  return gen_standard_action({{"cfg_cmd", field.cfg_cmd},
+                              {"bit_twist", field.bit_twist},
+                              {"byte_twist", field.byte_twist},
+                              {"is_data_or_not_cmd", field.is_data_or_not_cmd},
+                              {"update", field.update},
+                              {"capture", field.capture}},
+                             std::move(payload), "icb_config", 0x003, true,
+                             true);
+}
+
+static std::map<std::string, uint64_t> BitGen_JSON_get_pcb_config_values(
+    const BitGen_PCB_CONFIG_FIELD& field, bool with_parity) {
+  std::map<std::string, uint64_t> values = {
+      {"ram_block_count", field.ram_block_count},
+      {"pl_ctl_skew", field.pl_ctl_skew},
+      {"pl_ctl_parity", field.pl_ctl_parity},
+      {"pl_ctl_even", field.pl_ctl_even},
+      {"pl_ctl_split", field.pl_ctl_split},
+      {"pl_select_offset", field.pl_select_offset},
+      {"pl_select_row", field.pl_select_row},
+      {"pl_select_col", field.pl_select_col},
+      {"pl_row_offset", field.pl_row_offset},
+      {"pl_row_stride", field.pl_row_stride},
+      {"pl_col_offset", field.pl_col_offset},
+      {"pl_col_stride", field.pl_col_stride}};
+  if (with_parity) {
+    values["reserved"] = field.reserved;
+  } else {
+    values["pl_extra_w32"] = field.pl_extra_w32;
+    values["pl_extra_w33"] = field.pl_extra_w33;
+    values["pl_extra_w34"] = field.pl_extra_w34;
+    values["pl_extra_w35"] = field.pl_extra_w35;
+  }
+  return values;
+}
+
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_pcb_config_action(
+    const BitGen_PCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload) {
+  return gen_standard_action(BitGen_JSON_get_pcb_config_values(field, false),
+                             std::move(payload), "pcb_config", 0x004, false,
+                             false);
+}
+
+BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_pcb_config_with_parity_action(
+    const BitGen_PCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload) {
+  return gen_standard_action(BitGen_JSON_get_pcb_config_values(field, true),
+                             std::move(payload), "pcb_config_with_parity",
+                             0x005, false, false);
+}
+
 BitGen_BITSTREAM_ACTION* BitGen_JSON::gen_auth_key_otp_programming_action(
     const nlohmann::json& json) {
   std::string info = "Authentication Key OTP Programming";
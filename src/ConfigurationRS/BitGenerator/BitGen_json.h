@@ -1,10 +1,56 @@
 #ifndef BITGEN_JSON_H
 #define BITGEN_JSON_H
 
+#include <map>
+
 #include "BitGen_packer.h"
 #include "CFGCommonRS/CFGCommonRS.h"
 #include "nlohmann_json/json.hpp"
 
+// Typed action fields, to build the actions without going through JSON.
+// Member names follow the JSON keys of BitGen_JSON_ACTION_DATABASE
+struct BitGen_FCB_CONFIG_FIELD {
+  uint64_t bitline_byte_size = 0;
+  uint64_t readback = 0;
+};
+
+struct BitGen_OLD_FCB_CONFIG_FIELD {
+  uint64_t cfg_cmd = 0;
+  uint64_t bit_twist_shift_reg = 0;
+  uint64_t bit_chain_connection = 0;
+  uint64_t parallel_chains_count = 0;
+};
+
+struct BitGen_ICB_CONFIG_FIELD {
+  uint64_t cfg_cmd = 0;
+  uint64_t bit_twist = 0;
+  uint64_t byte_twist = 0;
+  uint64_t is_data_or_not_cmd = 0;
+  uint64_t update = 0;
+  uint64_t capture = 0;
+};
+
+// pcb_config uses pl_extra_w32-35, pcb_config_with_parity uses reserved
+struct BitGen_PCB_CONFIG_FIELD {
+  uint64_t ram_block_count = 0;
+  uint64_t pl_ctl_skew = 0;
+  uint64_t pl_ctl_parity = 0;
+  uint64_t pl_ctl_even = 0;
+  uint64_t pl_ctl_split = 0;
+  uint64_t pl_select_offset = 0;
+  uint64_t pl_select_row = 0;
+  uint64_t pl_select_col = 0;
+  uint64_t pl_row_offset = 0;
+  uint64_t pl_row_stride = 0;
+  uint64_t pl_col_offset = 0;
+  uint64_t pl_col_stride = 0;
+  uint64_t pl_extra_w32 = 0;
+  uint64_t pl_extra_w33 = 0;
+  uint64_t pl_extra_w34 = 0;
+  uint64_t pl_extra_w35 = 0;
+  uint64_t reserved = 0;
+};
+
 class BitGen_JSON {
  public:
   static void zeroize_array_numbers(nlohmann::json& json);
@@ -22,6 +68,18 @@ class BitGen_JSON {
       const nlohmann::json& json);
   static BitGen_BITSTREAM_ACTION* gen_pcb_config_with_parity_action(
       const nlohmann::json& json);
+  // Typed version, payload is moved into the action
+  static BitGen_BITSTREAM_ACTION* gen_fcb_config_action(
+      const BitGen_FCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload);
+  static BitGen_BITSTREAM_ACTION* gen_old_fcb_config_action(
+      const BitGen_OLD_FCB_CONFIG_FIELD& field,
+      std::vector<uint8_t>&& payload);
+  static BitGen_BITSTREAM_ACTION* gen_icb_config_action(
+      const BitGen_ICB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload);
+  static BitGen_BITSTREAM_ACTION* gen_pcb_config_action(
+      const BitGen_PCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload);
+  static BitGen_BITSTREAM_ACTION* gen_pcb_config_with_parity_action(
+      const BitGen_PCB_CONFIG_FIELD& field, std::vector<uint8_t>&& payload);
   static BitGen_BITSTREAM_ACTION* gen_auth_key_otp_programming_action(
       const nlohmann::json& json);
   static BitGen_BITSTREAM_ACTION* gen_aes_key_otp_programming_action(
@@ -34,6 +92,10 @@ class BitGen_JSON {
       const nlohmann::json& json, const std::string& info,
       const std::string name, uint16_t cmd, bool has_payload,
       bool has_original_payload_size, bool has_checksum);
+  static BitGen_BITSTREAM_ACTION* gen_standard_action(
+      const std::map<std::string, uint64_t>& values,
+      std::vector<uint8_t>&& payload, const std::string name, uint16_t cmd,
+      bool has_original_payload_size, bool has_checksum);
 };
 
 #endif
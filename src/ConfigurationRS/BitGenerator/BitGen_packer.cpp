@@ -1,6 +1,7 @@
 #include "BitGen_packer.h"
 
 #include <map>
+#include <mutex>
 
 #include "CFGCrypto/CFGOpenSSL.h"
 
@@ -39,19 +40,39 @@ BitGen_BITSTREAM_BOP::~BitGen_BITSTREAM_BOP() {
   }
 }
 
-BitGen_BITSTREAM_BLOCK::BitGen_BITSTREAM_BLOCK(BitGen_BITSTREAM_BLOCK_TYPE t)
-    : type(t) {
-  data.resize(BitGen_BITSTREAM_BLOCK_SIZE);
-  memset(&data[0], 0, data.size());
-}
-
-BitGen_BITSTREAM_BLOCK::~BitGen_BITSTREAM_BLOCK() {
+BitGen_BITSTREAM_BOP_BUFFER::~BitGen_BITSTREAM_BOP_BUFFER() {
   if (data.size()) {
     memset(&data[0], 0, data.size());
     data.clear();
   }
 }
 
+void BitGen_BITSTREAM_BOP_BUFFER::reserve(size_t block_count) {
+  CFG_ASSERT(data.empty());
+  data.reserve(block_count * BitGen_BITSTREAM_BLOCK_SIZE);
+  blocks.reserve(block_count);
+}
+
+size_t BitGen_BITSTREAM_BOP_BUFFER::add_blocks(BitGen_BITSTREAM_BLOCK_TYPE type,
+                                               size_t count) {
+  CFG_ASSERT(count);
+  size_t size = count * BitGen_BITSTREAM_BLOCK_SIZE;
+  // never reallocate, it would invalidate the block data pointers and leave
+  // copies of the data behind
+  CFG_ASSERT((data.size() + size) <= data.capacity());
+  size_t index = blocks.size();
+  for (size_t i = 0; i < count; i++) {
+    blocks.push_back({type, data.size() + i * BitGen_BITSTREAM_BLOCK_SIZE});
+  }
+  data.resize(data.size() + size);
+  return index;
+}
+
+uint8_t* BitGen_BITSTREAM_BOP_BUFFER::get_block_data(size_t index) {
+  CFG_ASSERT(index < blocks.size());
+  return &data[blocks[index].offset];
+}
+
 const std::map<const std::string, const uint8_t> BitGen_PACKER_U8_ENUM_MAP = {
     // checksum
     {"flecther32", 0x10},
@@ -85,49 +106,46 @@ static void BitGen_PACKER_set_u8_enum(uint8_t* data,
 }
 
 static void BitGen_PACKER_gen_bop_header_basic_field(
-    BitGen_BITSTREAM_BOP_FIELD& field, BitGen_BITSTREAM_BLOCK*& header,
-    bool compress) {
+    BitGen_BITSTREAM_BOP_FIELD& field, uint8_t* header, bool compress) {
   // Identifier - byte [3:0]
   CFG_ASSERT(field.identifier.size());
   CFG_ASSERT(field.identifier.size() <= 4);
-  memcpy(&header->data[0], field.identifier.c_str(), field.identifier.size());
+  memcpy(&header[0], field.identifier.c_str(), field.identifier.size());
   // Version - byte [0x7:0x4]
-  memcpy(&header->data[0x4], (void*)(&field.version), sizeof(field.version));
+  memcpy(&header[0x4], (void*)(&field.version), sizeof(field.version));
   // Size - byte [0xF:0x8]
   // OPN Tool - byte [0x3F:0x10]
   CFG_ASSERT(field.opn_tool.size() <= 48);
-  memcpy(&header->data[0x10], field.opn_tool.c_str(), field.opn_tool.size());
+  memcpy(&header[0x10], field.opn_tool.c_str(), field.opn_tool.size());
   // JTAG ID - byte [0x43:0x40]
-  memcpy(&header->data[0x40], (void*)(&field.jtag_id), sizeof(field.jtag_id));
+  memcpy(&header[0x40], (void*)(&field.jtag_id), sizeof(field.jtag_id));
   // JTAG Mask - byte [0x47:0x44]
-  memcpy(&header->data[0x40], (void*)(&field.jtag_mask),
-         sizeof(field.jtag_mask));
+  memcpy(&header[0x40], (void*)(&field.jtag_mask), sizeof(field.jtag_mask));
   // Reserved - byte [0x4F:0x48]
   // Obscured Chipid - byte [0x50]
-  memcpy(&header->data[0x50], (void*)(&field.chipid), sizeof(field.chipid));
+  memcpy(&header[0x50], (void*)(&field.chipid), sizeof(field.chipid));
   // Obscured Reserved - byte [0x5B:0x51]
   // Obscured CRC - byte [0x5F:0x5C]
-  uint32_t crc32 = CFG_crc32(&header->data[0x50], 12);
-  memcpy(&header->data[0x5C], (void*)(&crc32), sizeof(crc32));
+  uint32_t crc32 = CFG_crc32(&header[0x50], 12);
+  memcpy(&header[0x5C], (void*)(&crc32), sizeof(crc32));
   // Checksum - byte [0x60]
-  memcpy(&header->data[0x60], (void*)(&field.checksum), sizeof(field.checksum));
+  memcpy(&header[0x60], (void*)(&field.checksum), sizeof(field.checksum));
   // Compression - byte [0x61] - currently only support DCMP0
   uint8_t compression = compress ? 0x10 : 0;
-  memcpy(&header->data[0x61], (void*)(&compression), sizeof(compression));
+  memcpy(&header[0x61], (void*)(&compression), sizeof(compression));
   // Integrity - byte [0x62] - impossible there is no interity
   CFG_ASSERT(field.integrity != 0);
-  memcpy(&header->data[0x62], (void*)(&field.integrity),
-         sizeof(field.integrity));
+  memcpy(&header[0x62], (void*)(&field.integrity), sizeof(field.integrity));
 }
 
 static void BitGen_PACKER_gen_bop_header_encryption_field(
-    BitGen_BITSTREAM_BOP_FIELD& field, BitGen_BITSTREAM_BLOCK*& header,
-    std::vector<uint8_t>& aes_key) {
+    BitGen_BITSTREAM_BOP_FIELD& field, uint8_t* header,
+    std::vector<uint8_t>& aes_key, CFGOpenSSL_CTR* ctr) {
   CFG_ASSERT(aes_key.size() == 0 || aes_key.size() == 16 ||
              aes_key.size() == 32);
   if (aes_key.size()) {
     // Encryption - byte [0x80]
-    header->data[0x80] = aes_key.size() == 16 ? 0x10 : 0x12;
+    header[0x80] = aes_key.size() == 16 ? 0x10 : 0x12;
     // Challenge
     std::vector<uint8_t> challenge(64);
     std::vector<uint8_t> encrypted_challenge(challenge.size());
@@ -142,14 +160,13 @@ static void BitGen_PACKER_gen_bop_header_encryption_field(
       CFGOpenSSL::generate_iv(field.iv, false);
     }
     // Encrypt
-    CFGOpenSSL::ctr_encrypt(&challenge[0], &encrypted_challenge[0],
-                            challenge.size(), &aes_key[0], aes_key.size(),
-                            field.iv, sizeof(field.iv));
+    CFG_ASSERT(ctr != nullptr);
+    ctr->set_iv(field.iv, sizeof(field.iv));
+    ctr->process(&challenge[0], &encrypted_challenge[0], challenge.size());
     // Challenge - random data - byte [0x27F:0x240]
-    memcpy(&header->data[0x240], &encrypted_challenge[0],
-           encrypted_challenge.size());
+    memcpy(&header[0x240], &encrypted_challenge[0], encrypted_challenge.size());
     // IV - byte [0x28F:0x280]
-    memcpy(&header->data[0x280], field.iv, sizeof(field.iv));
+    memcpy(&header[0x280], field.iv, sizeof(field.iv));
     // Increment IV
     uint32_t iv = 0;
     memcpy((void*)(&iv), field.iv, sizeof(iv));
@@ -158,9 +175,10 @@ static void BitGen_PACKER_gen_bop_header_encryption_field(
   }
 }
 
-static void BitGen_PACKER_update_action(
-    std::vector<BitGen_BITSTREAM_BLOCK*>& blocks, uint8_t* data, size_t size,
-    uint8_t*& action_data, size_t& action_remaining_size) {
+static void BitGen_PACKER_update_action(BitGen_BITSTREAM_BOP_BUFFER& buffer,
+                                        uint8_t* data, size_t size,
+                                        uint8_t*& action_data,
+                                        size_t& action_remaining_size) {
   if (action_remaining_size >= size) {
     // We have enough space
     memcpy(action_data, data, size);
@@ -168,59 +186,23 @@ static void BitGen_PACKER_update_action(
     action_remaining_size -= size;
   } else {
     // We do not have enough space, create new one
-    BitGen_BITSTREAM_BLOCK* action =
-        CFG_MEM_NEW(BitGen_BITSTREAM_BLOCK, BitGen_BITSTREAM_ACTION_BLOCK);
+    size_t index = buffer.add_blocks(BitGen_BITSTREAM_ACTION_BLOCK);
     // To prevent unlimited recursive
-    CFG_ASSERT(size <= action->data.size());
+    CFG_ASSERT(size <= BitGen_BITSTREAM_BLOCK_SIZE);
     // Action data has new pointer now
-    action_data = &action->data[0];
+    action_data = buffer.get_block_data(index);
     // New remaining value as well
-    action_remaining_size = action->data.size();
-    blocks.push_back(action);
-    BitGen_PACKER_update_action(blocks, data, size, action_data,
+    action_remaining_size = BitGen_BITSTREAM_BLOCK_SIZE;
+    BitGen_PACKER_update_action(buffer, data, size, action_data,
                                 action_remaining_size);
   }
 }
 
-static void BitGen_PACKER_update_hash(
-    std::vector<BitGen_BITSTREAM_BLOCK*>& blocks, BitGen_BITSTREAM_BLOCK* block,
-    size_t hash_size, uint8_t*& hash_data, size_t& hash_remaining_size,
-    bool is_last_block) {
-  CFG_ASSERT(block != nullptr);
-  CFG_ASSERT(block->data.size());
-  CFG_ASSERT(hash_remaining_size >= hash_size);
-  if (hash_remaining_size >= (2 * hash_size) || is_last_block) {
-    // We have enough space
-    CFGOpenSSL::sha((uint8_t)(hash_size), &block->data[0], block->data.size(),
-                    hash_data);
-    hash_data += hash_size;
-    hash_remaining_size -= hash_size;
-    blocks.push_back(block);
-  } else {
-    // We do not have enough space, create new one
-    // But at this point the hash block is still empty, hence we store the
-    // pointer of last hash addr, and only update hash block's hash pointer at
-    // the very end
-    BitGen_BITSTREAM_BLOCK* hash =
-        CFG_MEM_NEW(BitGen_BITSTREAM_BLOCK, BitGen_BITSTREAM_HASH_BLOCK);
-    hash->hash_block_hash_data_ptr = hash_data;
-    // To prevent unlimited recursive
-    CFG_ASSERT(hash->data.size() >= (2 * hash_size));
-    // Hash data has new pointer now
-    hash_data = &hash->data[0];
-    // New remaining value as well
-    hash_remaining_size = hash->data.size();
-    blocks.push_back(hash);
-    BitGen_PACKER_update_hash(blocks, block, hash_size, hash_data,
-                              hash_remaining_size, is_last_block);
-  }
-}
-
 static void BitGen_PACKER_gen_action(
     BitGen_BITSTREAM_BOP*& bop, BitGen_BITSTREAM_ACTION*& action,
-    std::vector<BitGen_BITSTREAM_BLOCK*>& blocks, uint8_t*& action_data,
+    BitGen_BITSTREAM_BOP_BUFFER& buffer, uint8_t*& action_data,
     size_t& action_remaining_size, uint8_t checksum, bool compress,
-    std::vector<uint8_t>& aes_key) {
+    uint8_t compress_version, CFGOpenSSL_CTR* ctr) {
   CFG_ASSERT(action != nullptr);
   CFG_ASSERT(action->action);
   CFG_ASSERT((action->action & 0xF000) == 0);
@@ -231,7 +213,8 @@ static void BitGen_PACKER_gen_action(
   // Prepare payload so we will know the size
   if (action->payload.size()) {
     if (compress) {
-      CFG_compress(&action->payload[0], action->payload.size(), payload);
+      CFG_compress(&action->payload[0], action->payload.size(), payload,
+                   nullptr, false, true, compress_version);
       size_t compressed_block_count =
           (payload.size() + BitGen_BITSTREAM_BLOCK_SIZE - 1) /
           BitGen_BITSTREAM_BLOCK_SIZE;
@@ -250,23 +233,16 @@ static void BitGen_PACKER_gen_action(
     }
   }
   // Encrypt
-  if (payload.size() > 0 && aes_key.size() > 0) {
-    CFG_ASSERT(aes_key.size() == 16 || aes_key.size() == 32);
-    std::vector<uint8_t> encrypted_payload(payload.size());
+  if (payload.size() > 0 && ctr != nullptr) {
     if (action->iv.size()) {
       cmd_is_forced_to_use_dedicated_iv = true;
       CFG_ASSERT(action->iv.size() == 16);
-      CFGOpenSSL::ctr_encrypt(&payload[0], &encrypted_payload[0],
-                              payload.size(), &aes_key[0], aes_key.size(),
-                              &action->iv[0], action->iv.size());
+      ctr->set_iv(&action->iv[0], action->iv.size());
     } else {
-      CFGOpenSSL::ctr_encrypt(&payload[0], &encrypted_payload[0],
-                              payload.size(), &aes_key[0], aes_key.size(),
-                              bop->field.iv, sizeof(bop->field.iv));
+      ctr->set_iv(bop->field.iv, sizeof(bop->field.iv));
     }
-    // Copy to payload
-    memcpy(&payload[0], &encrypted_payload[0], payload.size());
-    memset(&encrypted_payload[0], 0, encrypted_payload.size());
+    // In place
+    ctr->process(&payload[0], &payload[0], payload.size());
     // Increment IV
     if (!cmd_is_forced_to_use_dedicated_iv) {
       uint32_t iv = 0;
@@ -334,148 +310,205 @@ static void BitGen_PACKER_gen_action(
   }
   uint16_t action_size = action_header.size();
   memcpy(&action_header[2], (void*)(&action_size), sizeof(action_size));
-  BitGen_PACKER_update_action(blocks, &action_header[0], action_header.size(),
+  BitGen_PACKER_update_action(buffer, &action_header[0], action_header.size(),
                               action_data, action_remaining_size);
   memset(&action_header[0], 0, action_header.size());
   action_header.clear();
-  // Create payload
-  while (payload.size()) {
-    BitGen_BITSTREAM_BLOCK* data =
-        CFG_MEM_NEW(BitGen_BITSTREAM_BLOCK, BitGen_BITSTREAM_DATA_BLOCK);
-    size_t data_size = payload.size();
-    if (data_size > data->data.size()) {
-      data_size = data->data.size();
-    }
-    memcpy(&data->data[0], &payload[0], data_size);
-    memset(&payload[0], 0, data_size);
-    payload.erase(payload.begin(), payload.begin() + data_size);
-    blocks.push_back(data);
+  // Create payload, its data blocks are contiguous in the BOP buffer so it
+  // is copied in one go (the buffer is zero filled, so is the last block)
+  if (payload.size()) {
+    size_t index = buffer.add_blocks(
+        BitGen_BITSTREAM_DATA_BLOCK,
+        (payload.size() + BitGen_BITSTREAM_BLOCK_SIZE - 1) /
+            BitGen_BITSTREAM_BLOCK_SIZE);
+    memcpy(buffer.get_block_data(index), &payload[0], payload.size());
+    memset(&payload[0], 0, payload.size());
+    payload.clear();
   }
 }
 
 static void BitGen_PACKER_gen_actions(
-    BitGen_BITSTREAM_BOP*& bop, std::vector<BitGen_BITSTREAM_BLOCK*>& blocks,
+    BitGen_BITSTREAM_BOP*& bop, BitGen_BITSTREAM_BOP_BUFFER& buffer,
     uint8_t* action_data, size_t action_remaining_size, uint8_t checksum,
-    bool compress, std::vector<uint8_t>& aes_key) {
+    bool compress, uint8_t compress_version, CFGOpenSSL_CTR* ctr) {
   CFG_ASSERT(bop->actions.size());
   // Version
   const uint32_t ACTION_VERSION = 0;
-  BitGen_PACKER_update_action(blocks, (uint8_t*)(&ACTION_VERSION),
+  BitGen_PACKER_update_action(buffer, (uint8_t*)(&ACTION_VERSION),
                               sizeof(ACTION_VERSION), action_data,
                               action_remaining_size);
   // Total action
   uint32_t action_count = (uint32_t)(bop->actions.size());
-  BitGen_PACKER_update_action(blocks, (uint8_t*)(&action_count),
+  BitGen_PACKER_update_action(buffer, (uint8_t*)(&action_count),
                               sizeof(action_count), action_data,
                               action_remaining_size);
   // Loop through the action
   for (auto& action : bop->actions) {
-    BitGen_PACKER_gen_action(bop, action, blocks, action_data,
+    BitGen_PACKER_gen_action(bop, action, buffer, action_data,
                              action_remaining_size, checksum, compress,
-                             aes_key);
+                             compress_version, ctr);
   }
 }
 
-static void BitGen_PACKER_update_hash(
-    std::vector<BitGen_BITSTREAM_BLOCK*>& blocks) {
+static bool BitGen_PACKER_need_hash_block(size_t hash_size,
+                                          size_t hash_remaining_size,
+                                          bool is_last_block) {
+  CFG_ASSERT(hash_remaining_size >= hash_size);
+  return hash_remaining_size < (2 * hash_size) && !is_last_block;
+}
+
+static void BitGen_PACKER_update_hash(BitGen_BITSTREAM_BOP_BUFFER& buffer) {
+  std::vector<BitGen_BITSTREAM_BLOCK>& blocks = buffer.blocks;
   CFG_ASSERT(blocks.size());
   // first block must be header
-  CFG_ASSERT(blocks.front()->type == BitGen_BITSTREAM_HEADER_BLOCK);
-  std::vector<BitGen_BITSTREAM_BLOCK*> temp;
-  for (auto& block : blocks) {
-    temp.push_back(block);
-  }
-  blocks.clear();
-  BitGen_BITSTREAM_BLOCK* header = temp.front();
-  temp.erase(temp.begin());
-  blocks.push_back(header);
-  CFG_ASSERT(header->data[0x62] == 0x10 || header->data[0x62] == 0x11 ||
-             header->data[0x62] == 0x12);
+  CFG_ASSERT(blocks.front().type == BitGen_BITSTREAM_HEADER_BLOCK);
+  uint8_t* header = buffer.get_block_data(0);
+  CFG_ASSERT(header[0x62] == 0x10 || header[0x62] == 0x11 ||
+             header[0x62] == 0x12);
   size_t hash_size =
-      header->data[0x62] == 0x10 ? 32 : (header->data[0x62] == 0x11 ? 48 : 64);
-  uint8_t* hash_data = &header->data[0x200];
+      header[0x62] == 0x10 ? 32 : (header[0x62] == 0x11 ? 48 : 64);
+  CFG_ASSERT(BitGen_BITSTREAM_BLOCK_SIZE >= (2 * hash_size));
+  size_t block_count = blocks.size() - 1;
+  if (block_count == 0) {
+    // special case, there is no block other than header
+    CFGOpenSSL::sha((uint8_t)(hash_size), &header[0xC0], 0x140,
+                    &header[0x200]);
+    return;
+  }
+  // The hash chain starts in the header. Whenever it runs out of space, a hash
+  // block is inserted in front of the next block. The first pass only counts
+  // the hash blocks so that they are added to the buffer at once
   size_t hash_remaining_size = hash_size;
-  if (temp.size()) {
-    while (temp.size()) {
-      BitGen_BITSTREAM_BLOCK* block = temp.front();
-      temp.erase(temp.begin());
-      CFG_ASSERT(block->type == BitGen_BITSTREAM_ACTION_BLOCK ||
-                 block->type == BitGen_BITSTREAM_DATA_BLOCK);
-      BitGen_PACKER_update_hash(blocks, block, hash_size, hash_data,
-                                hash_remaining_size, temp.empty());
+  size_t hash_block_count = 0;
+  for (size_t i = 0; i < block_count; i++) {
+    if (BitGen_PACKER_need_hash_block(hash_size, hash_remaining_size,
+                                      i + 1 == block_count)) {
+      hash_block_count++;
+      hash_remaining_size = BitGen_BITSTREAM_BLOCK_SIZE;
     }
-    for (auto iter = blocks.rbegin(); iter != blocks.rend(); iter++) {
-      BitGen_BITSTREAM_BLOCK* block = *iter;
-      if (block->type == BitGen_BITSTREAM_HASH_BLOCK) {
-        CFG_ASSERT(block->hash_block_hash_data_ptr != nullptr);
-        CFGOpenSSL::sha((uint8_t)(hash_size), &block->data[0],
-                        block->data.size(), block->hash_block_hash_data_ptr);
-        block->hash_block_hash_data_ptr = nullptr;
-      }
+    hash_remaining_size -= hash_size;
+  }
+  size_t hash_index = hash_block_count
+                          ? buffer.add_blocks(BitGen_BITSTREAM_HASH_BLOCK,
+                                              hash_block_count)
+                          : blocks.size();
+  // Second pass hashes the blocks in the final order. A hash block is still
+  // empty when it is inserted, hence we store the pointer of last hash addr,
+  // and only update hash block's hash at the very end
+  std::vector<BitGen_BITSTREAM_BLOCK> ordered;
+  std::vector<uint8_t*> hash_block_hash_data_ptrs;
+  ordered.reserve(blocks.size());
+  ordered.push_back(blocks.front());
+  uint8_t* hash_data = &header[0x200];
+  hash_remaining_size = hash_size;
+  for (size_t i = 0; i < block_count; i++) {
+    if (BitGen_PACKER_need_hash_block(hash_size, hash_remaining_size,
+                                      i + 1 == block_count)) {
+      hash_block_hash_data_ptrs.push_back(hash_data);
+      hash_data = buffer.get_block_data(hash_index);
+      hash_remaining_size = BitGen_BITSTREAM_BLOCK_SIZE;
+      ordered.push_back(blocks[hash_index++]);
     }
-  } else {
-    // special case, there is no block other than header
-    CFGOpenSSL::sha((uint8_t)(hash_size), &header->data[0xC0], 0x140,
-                    &header->data[0x200]);
+    const BitGen_BITSTREAM_BLOCK& block = blocks[i + 1];
+    CFG_ASSERT(block.type == BitGen_BITSTREAM_ACTION_BLOCK ||
+               block.type == BitGen_BITSTREAM_DATA_BLOCK);
+    CFGOpenSSL::sha((uint8_t)(hash_size), buffer.get_block_data(i + 1),
+                    BitGen_BITSTREAM_BLOCK_SIZE, hash_data);
+    hash_data += hash_size;
+    hash_remaining_size -= hash_size;
+    ordered.push_back(block);
+  }
+  CFG_ASSERT(ordered.size() == blocks.size());
+  CFG_ASSERT(hash_block_hash_data_ptrs.size() == hash_block_count);
+  // Every hash block holds the hash of the next one, do it from the back
+  for (size_t i = hash_block_count; i > 0; i--) {
+    CFGOpenSSL::sha((uint8_t)(hash_size),
+                    buffer.get_block_data(blocks.size() - hash_block_count +
+                                          i - 1),
+                    BitGen_BITSTREAM_BLOCK_SIZE,
+                    hash_block_hash_data_ptrs[i - 1]);
   }
+  blocks.swap(ordered);
 }
 
 static void BitGen_PACKER_update_bitstream_size(
-    std::vector<BitGen_BITSTREAM_BLOCK*>& blocks) {
-  CFG_ASSERT(blocks.size());
+    BitGen_BITSTREAM_BOP_BUFFER& buffer) {
+  CFG_ASSERT(buffer.blocks.size());
   // first block must be header
-  BitGen_BITSTREAM_BLOCK* header = blocks.front();
-  CFG_ASSERT(header->type == BitGen_BITSTREAM_HEADER_BLOCK);
-  size_t block_size = header->data.size();
-  CFG_ASSERT(block_size);
-  for (auto& block : blocks) {
-    CFG_ASSERT(block_size == block->data.size());
-  }
-  uint64_t size = (uint64_t)(blocks.size() * block_size);
-  memcpy(&header->data[0x8], (void*)(&size), sizeof(size));
+  CFG_ASSERT(buffer.blocks.front().type == BitGen_BITSTREAM_HEADER_BLOCK);
+  uint8_t* header = buffer.get_block_data(0);
+  uint64_t size =
+      (uint64_t)(buffer.blocks.size() * BitGen_BITSTREAM_BLOCK_SIZE);
+  memcpy(&header[0x8], (void*)(&size), sizeof(size));
 }
 
-static void BitGen_PACKER_sign(BitGen_BITSTREAM_BLOCK*& header,
-                               CFGCrypto_KEY*& key) {
-  CFG_ASSERT(header->type == BitGen_BITSTREAM_HEADER_BLOCK);
+static void BitGen_PACKER_sign(uint8_t* header, CFGCrypto_KEY*& key) {
+  CFG_ASSERT(header != nullptr);
   if (key != nullptr) {
+    // the signing key is shared by all BOPs, serialize its use when BOPs are
+    // packed in parallel
+    static std::mutex sign_mutex;
+    std::lock_guard<std::mutex> lock(sign_mutex);
     // Authentication - byte [0x81]
-    header->data[0x81] = key->get_bitstream_signing_algo();
+    header[0x81] = key->get_bitstream_signing_algo();
     std::vector<uint8_t> public_key;
     key->get_public_key(public_key, 4);
     CFG_ASSERT(public_key.size());
     CFG_ASSERT(public_key.size() <= 272);
-    memcpy(&header->data[0x570], &public_key[0], public_key.size());
+    memcpy(&header[0x570], &public_key[0], public_key.size());
     size_t signature_size = CFGOpenSSL::sign_message(
-        &header->data[0], 0x680, &header->data[0x680], 0x100, key);
+        &header[0], 0x680, &header[0x680], 0x100, key);
     CFG_ASSERT(signature_size <= 0x100);
     memset(&public_key[0], 0, public_key.size());
     public_key.clear();
   }
 }
 
-static void BitGen_PACKER_finalize(BitGen_BITSTREAM_BLOCK*& header) {
-  CFG_ASSERT(header->type == BitGen_BITSTREAM_HEADER_BLOCK);
+static void BitGen_PACKER_finalize(uint8_t* header) {
+  CFG_ASSERT(header != nullptr);
   uint32_t crc32 = 0;
-  crc32 = CFG_crc32(&header->data[0], header->data.size() - sizeof(crc32));
-  memcpy(&header->data[header->data.size() - sizeof(crc32)], (void*)(&crc32),
+  crc32 = CFG_crc32(&header[0], BitGen_BITSTREAM_BLOCK_SIZE - sizeof(crc32));
+  memcpy(&header[BitGen_BITSTREAM_BLOCK_SIZE - sizeof(crc32)], (void*)(&crc32),
          sizeof(crc32));
 }
 
 static void BitGen_PACKER_gen_bop_bitstream(
-    BitGen_BITSTREAM_BOP*& bop, std::vector<BitGen_BITSTREAM_BLOCK*>& blocks,
-    bool compress, std::vector<uint8_t>& aes_key, CFGCrypto_KEY*& key) {
+    BitGen_BITSTREAM_BOP*& bop, BitGen_BITSTREAM_BOP_BUFFER& buffer,
+    bool compress, uint8_t compress_version, std::vector<uint8_t>& aes_key,
+    CFGCrypto_KEY*& key) {
   CFG_ASSERT(bop->actions.size());
-  BitGen_BITSTREAM_BLOCK* header =
-      CFG_MEM_NEW(BitGen_BITSTREAM_BLOCK, BitGen_BITSTREAM_HEADER_BLOCK);
-  blocks.push_back(header);
+  // Reserve the worst case: every action may start a new action block, its
+  // payload never takes more blocks than the original payload (compression
+  // is dropped otherwise) and a hash block covers at least 31 blocks
+  size_t block_count = 0;
+  for (auto& action : bop->actions) {
+    block_count += 1 + (action->payload.size() + BitGen_BITSTREAM_BLOCK_SIZE -
+                        1) / BitGen_BITSTREAM_BLOCK_SIZE;
+  }
+  block_count += 1 + (block_count / 31) + 1;
+  buffer.reserve(block_count);
+  buffer.add_blocks(BitGen_BITSTREAM_HEADER_BLOCK);
+  uint8_t* header = buffer.get_block_data(0);
   BitGen_PACKER_gen_bop_header_basic_field(bop->field, header, compress);
-  BitGen_PACKER_gen_bop_header_encryption_field(bop->field, header, aes_key);
-  BitGen_PACKER_gen_actions(bop, blocks, &header->data[0xC0], 0x140,
-                            header->data[0x60], compress, aes_key);
-  BitGen_PACKER_update_hash(blocks);
-  BitGen_PACKER::obscure(&header->data[0x50], &header->data[0x200]);
-  BitGen_PACKER_update_bitstream_size(blocks);
+  // Key the AES session once for the whole BOP
+  CFGOpenSSL_CTR* ctr = nullptr;
+  if (aes_key.size()) {
+    ctr = CFG_MEM_NEW(CFGOpenSSL_CTR, &aes_key[0], aes_key.size());
+  }
+  try {
+    BitGen_PACKER_gen_bop_header_encryption_field(bop->field, header, aes_key,
+                                                  ctr);
+    BitGen_PACKER_gen_actions(bop, buffer, &header[0xC0], 0x140, header[0x60],
+                              compress, compress_version, ctr);
+  } catch (...) {
+    // Release the session before the failure goes up
+    CFG_MEM_DELETE(ctr);
+    throw;
+  }
+  CFG_MEM_DELETE(ctr);
+  BitGen_PACKER_update_hash(buffer);
+  BitGen_PACKER::obscure(&header[0x50], &header[0x200]);
+  BitGen_PACKER_update_bitstream_size(buffer);
   BitGen_PACKER_sign(header, key);
   BitGen_PACKER_finalize(header);
 }
@@ -505,27 +538,37 @@ void BitGen_PACKER::generate_bitstream(std::vector<BitGen_BITSTREAM_BOP*>& bops,
                                        std::vector<uint8_t>& data,
                                        bool compress,
                                        std::vector<uint8_t>& aes_key,
-                                       CFGCrypto_KEY*& key) {
+                                       CFGCrypto_KEY*& key, uint32_t jobs,
+                                       uint8_t compress_version) {
   CFG_ASSERT(bops.size());
+  // BOPs are independent of each other until the end size is updated, so
+  // their blocks can be generated by a pool of workers (jobs = 0 means one
+  // worker per CPU core) and then concatenated in order
+  std::vector<BitGen_BITSTREAM_BOP_BUFFER> bop_buffers(bops.size());
+  // OpenSSL is initialized once before the workers use it
+  CFGOpenSSL::init_openssl();
+  CFG_parallel_for(bops.size(), jobs, [&](size_t i) {
+    BitGen_PACKER_gen_bop_bitstream(bops[i], bop_buffers[i], compress,
+                                    compress_version, aes_key, key);
+  });
   // Track each BOP size
   size_t start_index = data.size();
+  size_t total_size = 0;
   std::vector<size_t> tracking_size;
-  for (BitGen_BITSTREAM_BOP*& bop : bops) {
-    size_t temp_start_index = data.size();
-    std::vector<BitGen_BITSTREAM_BLOCK*> bop_blocks;
-    BitGen_PACKER_gen_bop_bitstream(bop, bop_blocks, compress, aes_key, key);
-    CFG_ASSERT(bop_blocks.size());
-    for (BitGen_BITSTREAM_BLOCK*& block : bop_blocks) {
-      CFG_ASSERT(block != nullptr);
-      data.insert(data.end(), block->data.begin(), block->data.end());
-    }
-    while (bop_blocks.size()) {
-      CFG_MEM_DELETE(bop_blocks.back());
-      bop_blocks.pop_back();
+  for (auto& buffer : bop_buffers) {
+    CFG_ASSERT(buffer.blocks.size());
+    tracking_size.push_back(buffer.blocks.size() *
+                            BitGen_BITSTREAM_BLOCK_SIZE);
+    total_size += tracking_size.back();
+  }
+  data.resize(start_index + total_size);
+  uint8_t* dest = &data[start_index];
+  for (auto& buffer : bop_buffers) {
+    for (size_t i = 0; i < buffer.blocks.size(); i++) {
+      memcpy(dest, buffer.get_block_data(i), BitGen_BITSTREAM_BLOCK_SIZE);
+      dest += BitGen_BITSTREAM_BLOCK_SIZE;
     }
-    tracking_size.push_back(data.size() - temp_start_index);
   }
-  size_t total_size = data.size() - start_index;
   for (size_t i = 0, j = tracking_size.size() - 1; i < tracking_size.size();
        i++, j--) {
     update_bitstream_end_size(&data[start_index], total_size, j == 0);
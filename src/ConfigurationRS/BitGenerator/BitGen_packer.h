@@ -44,12 +44,21 @@ enum BitGen_BITSTREAM_BLOCK_TYPE {
   BitGen_BITSTREAM_DATA_BLOCK
 };
 
+// A block is a view of BitGen_BITSTREAM_BLOCK_SIZE bytes in the BOP buffer
 struct BitGen_BITSTREAM_BLOCK {
-  BitGen_BITSTREAM_BLOCK(BitGen_BITSTREAM_BLOCK_TYPE t);
-  ~BitGen_BITSTREAM_BLOCK();
-  const BitGen_BITSTREAM_BLOCK_TYPE type;
+  BitGen_BITSTREAM_BLOCK_TYPE type;
+  size_t offset;
+};
+
+// All the blocks of a BOP live in one buffer which is reserved up front, so
+// block data pointers stay valid while the BOP is generated
+struct BitGen_BITSTREAM_BOP_BUFFER {
+  ~BitGen_BITSTREAM_BOP_BUFFER();
+  void reserve(size_t block_count);
+  size_t add_blocks(BitGen_BITSTREAM_BLOCK_TYPE type, size_t count = 1);
+  uint8_t* get_block_data(size_t index);
+  std::vector<BitGen_BITSTREAM_BLOCK> blocks;
   std::vector<uint8_t> data;
-  uint8_t* hash_block_hash_data_ptr = nullptr;
 };
 
 class BitGen_PACKER {
@@ -58,7 +67,8 @@ class BitGen_PACKER {
   static void generate_bitstream(std::vector<BitGen_BITSTREAM_BOP*>& bops,
                                  std::vector<uint8_t>& data, bool compress,
                                  std::vector<uint8_t>& aes_key,
-                                 CFGCrypto_KEY*& key);
+                                 CFGCrypto_KEY*& key, uint32_t jobs = 1,
+                                 uint8_t compress_version = 0);
   static void update_bitstream_end_size(uint8_t* const data,
                                         uint64_t ending_size, bool is_last_bop);
   static uint8_t get_feature_u8_enum(const std::string& feature);
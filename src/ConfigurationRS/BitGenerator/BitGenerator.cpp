@@ -49,8 +49,25 @@ bool BitGenerator_entry(const CFGCommon_ARG* cmdarg) {
           "and output should be in .cfgbit extension");
       status = false;
     }
+    if (subarg->jobs < 0) {
+      CFG_POST_ERR(
+          "BITGEN: gen_bitstream:: --jobs should be 0 (one job per CPU core) "
+          "or a positive number, but found %d",
+          subarg->jobs);
+      status = false;
+    }
+    if (subarg->compress_version != 0 && subarg->compress_version != 1) {
+      CFG_POST_ERR(
+          "BITGEN: gen_bitstream:: --compress_version should be 0 or 1, but "
+          "found %d",
+          subarg->compress_version);
+      status = false;
+    }
     status = status && read_aes_key(subarg->aes_key, aes_key);
     if (status) {
+      // Validated above, the worker pools never use more jobs than there is
+      // work (BOPs to pack, PCBs to generate)
+      uint32_t jobs = (uint32_t)(subarg->jobs);
       // Signing key
       CFGCrypto_KEY key;
       CFGCrypto_KEY* key_ptr = nullptr;
@@ -68,7 +85,7 @@ bool BitGenerator_entry(const CFGCommon_ARG* cmdarg) {
                 {"Gemini", "Internal-Gemini", "Virgo", "Internal-Virgo"},
                 bitobj.configuration.family) >= 0) {
           BitGen_GEMINI gemini(&bitobj);
-          gemini.generate(bops);
+          gemini.generate(bops, jobs);
         } else {
           CFG_INTERNAL_ERROR("Unsupported device %s family %s",
                              bitobj.device.c_str(),
@@ -81,7 +98,8 @@ bool BitGenerator_entry(const CFGCommon_ARG* cmdarg) {
       std::vector<uint8_t> data;
       std::string bitstream_error_msg = "";
       BitGen_PACKER::generate_bitstream(bops, data, subarg->compress, aes_key,
-                                        key_ptr);
+                                        key_ptr, jobs,
+                                        (uint8_t)(subarg->compress_version));
       BitGen_ANALYZER::parse(data, true, true, bitstream_error_msg, false);
       CFG_ASSERT_MSG(bitstream_error_msg.empty(), bitstream_error_msg.c_str());
       CFG_write_binary_file(subarg->m_args[1], &data[0], data.size());
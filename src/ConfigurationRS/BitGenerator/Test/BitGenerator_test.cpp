@@ -1,6 +1,858 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "BitGen_analyzer.h"
+#include "BitGen_decompress_engine.h"
+#include "BitGen_gemini.h"
+#include "BitGen_json.h"
 #include "CFGCommonRS/CFGCommonRS.h"
+#include "CFGCommonRS/CFGCompress.h"
+
+static std::vector<uint8_t> test_pack_json(const std::string& json_filepath,
+                                           uint32_t jobs, double& elapsed) {
+  std::vector<BitGen_BITSTREAM_BOP*> bops;
+  BitGen_JSON::parse_bitstream(json_filepath, bops);
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> aes_key;
+  CFGCrypto_KEY* key = nullptr;
+  auto start = std::chrono::steady_clock::now();
+  BitGen_PACKER::generate_bitstream(bops, data, true, aes_key, key, jobs);
+  elapsed = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  while (bops.size()) {
+    CFG_MEM_DELETE(bops.back());
+    bops.pop_back();
+  }
+  return data;
+}
+
+void test_parallel_packing() {
+  CFG_POST_MSG("Parallel BOP Packing Test");
+  // multi BOP JSON input, each BOP has its own compressible payload. the IV
+  // is fixed and there is no encryption so the output is deterministic
+  const uint32_t bop_count = 8;
+  const size_t payload_size = 256 * 1024;
+  std::string json = "[";
+  for (uint32_t i = 0; i < bop_count; i++) {
+    std::vector<uint8_t> payload(payload_size);
+    for (size_t j = 0; j < payload.size(); j++) {
+      payload[j] = (uint8_t)((j / (i + 3)) ^ (j % 7 == 0 ? i : 0));
+    }
+    std::string payload_filepath = CFG_print("bitgen_test_payload%d.bin", i);
+    CFG_write_binary_file(payload_filepath, &payload[0], payload.size());
+    json = CFG_print(
+        "%s%s{\"fields\": {\"identifier\": \"FPGA\", \"iv\": "
+        "\"000102030405060708090A0B0C0D0E0F\"}, \"actions\": [{\"action\": "
+        "\"generic\", \"cmd\": %d, \"checksum\": true, \"payload\": \"%s\"}]}",
+        json.c_str(), i ? ", " : "", i + 1, payload_filepath.c_str());
+  }
+  json += "]";
+  std::string json_filepath = "bitgen_test_bops.json";
+  CFG_write_binary_file(json_filepath, (const uint8_t*)(json.c_str()),
+                        json.size());
+  double serial_time = 0;
+  double parallel_time = 0;
+  std::vector<uint8_t> serial = test_pack_json(json_filepath, 1, serial_time);
+  std::vector<uint8_t> parallel =
+      test_pack_json(json_filepath, bop_count, parallel_time);
+  CFG_ASSERT(serial.size());
+  CFG_ASSERT(serial == parallel);
+  std::string error_msg = "";
+  std::vector<size_t> sizes =
+      BitGen_ANALYZER::parse(parallel, true, true, error_msg, false);
+  CFG_ASSERT(error_msg.empty());
+  CFG_ASSERT(sizes.size() == bop_count);
+  CFG_POST_MSG("!!! Result: %d BOPs packed in %.3f ms (1 job) vs %.3f ms (%d "
+               "jobs)",
+               bop_count, serial_time, parallel_time, bop_count);
+  for (uint32_t i = 0; i < bop_count; i++) {
+    std::remove(CFG_print("bitgen_test_payload%d.bin", i).c_str());
+  }
+  std::remove(json_filepath.c_str());
+}
+
+void test_large_payload_packing() {
+  CFG_POST_MSG("Large Payload Packing Test");
+  // one uncompressed 64MB payload, it is split into 32K data blocks
+  const size_t payload_size = 64 * 1024 * 1024;
+  std::vector<BitGen_BITSTREAM_BOP*> bops;
+  bops.push_back(CFG_MEM_NEW(BitGen_BITSTREAM_BOP));
+  bops.back()->field.identifier = "FPGA";
+  bops.back()->field.integrity = 0x10;
+  BitGen_BITSTREAM_ACTION* action =
+      CFG_MEM_NEW(BitGen_BITSTREAM_ACTION, (uint16_t)(1));
+  action->payload.resize(payload_size);
+  for (size_t i = 0; i < payload_size; i++) {
+    action->payload[i] = (uint8_t)(i ^ (i >> 11));
+  }
+  bops.back()->actions.push_back(action);
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> aes_key;
+  CFGCrypto_KEY* key = nullptr;
+  auto start = std::chrono::steady_clock::now();
+  BitGen_PACKER::generate_bitstream(bops, data, false, aes_key, key);
+  double elapsed = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  CFG_ASSERT(data.size() > payload_size);
+  std::string error_msg = "";
+  std::vector<size_t> sizes =
+      BitGen_ANALYZER::parse(data, false, true, error_msg, false);
+  CFG_ASSERT(error_msg.empty());
+  CFG_ASSERT(sizes.size() == 1 && sizes[0] == data.size());
+  CFG_POST_MSG("!!! Result: %ld MB payload packed in %.3f ms",
+               payload_size / (1024 * 1024), elapsed);
+  CFG_MEM_DELETE(bops.back());
+}
+
+static std::vector<uint8_t> test_engine_decompress(
+    const std::vector<uint8_t>& input, size_t input_chunk, size_t output_chunk,
+    bool bulk = false) {
+  // feed the engine like the firmware does, few bytes at a time
+  BitGen_DECOMPRESS_ENGINE engine;
+  engine.reset();
+  std::vector<uint8_t> output;
+  std::vector<uint8_t> buffer(output_chunk);
+  size_t index = 0;
+  size_t size = std::min(input_chunk, input.size());
+  BitGen_DECOMPRESS_ENGINE_STATUS status = BitGen_DECOMPRESS_ENGINE_GOOD_STATUS;
+  while (status != BitGen_DECOMPRESS_ENGINE_DONE_STATUS) {
+    size_t output_size = 0;
+    if (bulk) {
+      status = engine.process_block(&input[index], size, &buffer[0],
+                                    buffer.size(), output_size);
+    } else {
+      status = engine.process(&input[index], size, &buffer[0], buffer.size(),
+                              output_size);
+    }
+    CFG_ASSERT(status != BitGen_DECOMPRESS_ENGINE_ERROR_STATUS);
+    output.insert(output.end(), buffer.begin(), buffer.begin() + output_size);
+    if (status == BitGen_DECOMPRESS_ENGINE_NEED_INPUT_STATUS) {
+      index += size;
+      CFG_ASSERT(index < input.size());
+      size = std::min(input_chunk, input.size() - index);
+    }
+  }
+  return output;
+}
+
+void test_decompress_engine() {
+  CFG_POST_MSG("Decompress Engine Test");
+  std::vector<uint8_t> input(7 * 2048 + 300, 0);
+  uint32_t seed = 0x2545F491;
+  for (size_t i = 0; i < input.size(); i++) {
+    seed = seed * 1664525 + 1013904223;
+    if ((seed >> 24) < 32) {
+      input[i] = (uint8_t)(seed >> 8);
+    } else if ((seed >> 24) < 40) {
+      input[i] = 0xFF;
+    }
+  }
+  std::vector<uint8_t> version0;
+  std::vector<uint8_t> version1;
+  CFG_compress(&input[0], input.size(), version0);
+  CFG_COMPRESS::compress_segments(&input[0], input.size(), version1, nullptr,
+                                  true, 2048, 2);
+  for (auto& cmp : {version0, version1}) {
+    for (size_t chunk : {1, 7, 64, 4096}) {
+      CFG_ASSERT(test_engine_decompress(cmp, chunk, 13) == input);
+      CFG_ASSERT(test_engine_decompress(cmp, 13, chunk) == input);
+      CFG_ASSERT(test_engine_decompress(cmp, chunk, 13, true) == input);
+      CFG_ASSERT(test_engine_decompress(cmp, 13, chunk, true) == input);
+    }
+  }
+  // version 1 segment which does not match its compressed size
+  size_t index = 8;
+  CFG_read_variable_u64(&version1[0], version1.size(), index);
+  CFG_read_variable_u64(&version1[0], version1.size(), index);
+  CFG_read_variable_u64(&version1[0], version1.size(), index);
+  version1[index]++;
+  BitGen_DECOMPRESS_ENGINE engine;
+  engine.reset();
+  std::vector<uint8_t> buffer(input.size());
+  size_t output_size = 0;
+  CFG_ASSERT(engine.process(&version1[0], version1.size(), &buffer[0],
+                            buffer.size(), output_size) ==
+             BitGen_DECOMPRESS_ENGINE_ERROR_STATUS);
+}
+
+void test_decompress_engine_benchmark() {
+  CFG_POST_MSG("Decompress Engine Benchmark");
+  // 2KB payload blocks in, 2KB decompressed data out
+  const size_t size = 32 * 1024 * 1024;
+  std::vector<uint8_t> input(size, 0);
+  uint32_t seed = 0x6A09E667;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1664525 + 1013904223;
+    if ((seed >> 24) < 16) {
+      input[i] = (uint8_t)(seed >> 8);
+    }
+  }
+  std::vector<uint8_t> cmp;
+  CFG_compress(&input[0], input.size(), cmp);
+  auto start = std::chrono::steady_clock::now();
+  CFG_ASSERT(test_engine_decompress(cmp, BitGen_BITSTREAM_BLOCK_SIZE,
+                                    BitGen_BITSTREAM_BLOCK_SIZE) == input);
+  auto middle = std::chrono::steady_clock::now();
+  CFG_ASSERT(test_engine_decompress(cmp, BitGen_BITSTREAM_BLOCK_SIZE,
+                                    BitGen_BITSTREAM_BLOCK_SIZE,
+                                    true) == input);
+  auto end = std::chrono::steady_clock::now();
+  double process_time =
+      std::chrono::duration<double, std::milli>(middle - start).count();
+  double block_time =
+      std::chrono::duration<double, std::milli>(end - middle).count();
+  CFG_POST_MSG("!!! Result: %ld Bytes decompressed to %ld MB in %.3f ms "
+               "(byte by byte %.3f ms)",
+               cmp.size(), size / (1024 * 1024), block_time, process_time);
+}
+
+static void test_compare_action(BitGen_BITSTREAM_ACTION* json_action,
+                                BitGen_BITSTREAM_ACTION* typed_action) {
+  CFG_ASSERT(json_action->action == typed_action->action);
+  CFG_ASSERT(json_action->has_original_payload_size ==
+             typed_action->has_original_payload_size);
+  CFG_ASSERT(json_action->has_checksum == typed_action->has_checksum);
+  CFG_ASSERT(json_action->field == typed_action->field);
+  CFG_ASSERT(json_action->iv == typed_action->iv);
+  CFG_ASSERT(json_action->payload == typed_action->payload);
+  CFG_MEM_DELETE(json_action);
+  CFG_MEM_DELETE(typed_action);
+}
+
+void test_typed_action() {
+  CFG_POST_MSG("Typed Action Test");
+  std::vector<uint8_t> payload(1024);
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = (uint8_t)(i * 7 + (i >> 8));
+  }
+  nlohmann::json json;
+  json["payload"] = nlohmann::json(payload);
+  // fcb_config
+  json["action"] = "fcb_config";
+  json["bitline_byte_size"] = 0x1234;
+  json["readback"] = 1;
+  BitGen_FCB_CONFIG_FIELD fcb;
+  fcb.bitline_byte_size = 0x1234;
+  fcb.readback = 1;
+  test_compare_action(
+      BitGen_JSON::gen_fcb_config_action(json),
+      BitGen_JSON::gen_fcb_config_action(fcb, std::vector<uint8_t>(payload)));
+  // old_fcb_config
+  json.erase("bitline_byte_size");
+  json.erase("readback");
+  json["action"] = "old_fcb_config";
+  json["cfg_cmd"] = 1;
+  json["bit_twist_shift_reg"] = 1;
+  json["bit_chain_connection"] = 0;
+  json["parallel_chains_count"] = 37;
+  BitGen_OLD_FCB_CONFIG_FIELD old_fcb;
+  old_fcb.cfg_cmd = 1;
+  old_fcb.bit_twist_shift_reg = 1;
+  old_fcb.bit_chain_connection = 0;
+  old_fcb.parallel_chains_count = 37;
+  test_compare_action(BitGen_JSON::gen_old_fcb_config_action(json),
+                      BitGen_JSON::gen_old_fcb_config_action(
+                          old_fcb, std::vector<uint8_t>(payload)));
+  // icb_config
+  json.erase("bit_twist_shift_reg");
+  json.erase("bit_chain_connection");
+  json.erase("parallel_chains_count");
+  json["action"] = "icb_config";
+  json["cfg_cmd"] = 0;
+  json["bit_twist"] = 1;
+  json["byte_twist"] = 0;
+  json["is_data_or_not_cmd"] = 1;
+  json["update"] = 1;
+  json["capture"] = 0;
+  BitGen_ICB_CONFIG_FIELD icb;
+  icb.cfg_cmd = 0;
+  icb.bit_twist = 1;
+  icb.byte_twist = 0;
+  icb.is_data_or_not_cmd = 1;
+  icb.update = 1;
+  icb.capture = 0;
+  test_compare_action(
+      BitGen_JSON::gen_icb_config_action(json),
+      BitGen_JSON::gen_icb_config_action(icb, std::vector<uint8_t>(payload)));
+  // pcb_config and pcb_config_with_parity
+  for (bool parity : {false, true}) {
+    nlohmann::json pcb_json;
+    pcb_json["payload"] = nlohmann::json(payload);
+    pcb_json["action"] = parity ? "pcb_config_with_parity" : "pcb_config";
+    BitGen_PCB_CONFIG_FIELD pcb;
+    std::vector<std::pair<std::string, uint64_t*>> values = {
+        {"ram_block_count", &pcb.ram_block_count},
+        {"pl_ctl_skew", &pcb.pl_ctl_skew},
+        {"pl_ctl_parity", &pcb.pl_ctl_parity},
+        {"pl_ctl_even", &pcb.pl_ctl_even},
+        {"pl_ctl_split", &pcb.pl_ctl_split},
+        {"pl_select_offset", &pcb.pl_select_offset},
+        {"pl_select_row", &pcb.pl_select_row},
+        {"pl_select_col", &pcb.pl_select_col},
+        {"pl_row_offset", &pcb.pl_row_offset},
+        {"pl_row_stride", &pcb.pl_row_stride},
+        {"pl_col_offset", &pcb.pl_col_offset},
+        {"pl_col_stride", &pcb.pl_col_stride}};
+    if (parity) {
+      values.push_back({"reserved", &pcb.reserved});
+    } else {
+      values.push_back({"pl_extra_w32", &pcb.pl_extra_w32});
+      values.push_back({"pl_extra_w33", &pcb.pl_extra_w33});
+      values.push_back({"pl_extra_w34", &pcb.pl_extra_w34});
+      values.push_back({"pl_extra_w35", &pcb.pl_extra_w35});
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+      // alternate 0 and 1 so that the values fit even the 1-bit fields
+      *values[i].second = (i % 2);
+      pcb_json[values[i].first] = (i % 2);
+    }
+    if (parity) {
+      test_compare_action(BitGen_JSON::gen_pcb_config_with_parity_action(
+                              pcb_json),
+                          BitGen_JSON::gen_pcb_config_with_parity_action(
+                              pcb, std::vector<uint8_t>(payload)));
+    } else {
+      test_compare_action(BitGen_JSON::gen_pcb_config_action(pcb_json),
+                          BitGen_JSON::gen_pcb_config_action(
+                              pcb, std::vector<uint8_t>(payload)));
+    }
+  }
+}
+
+void test_typed_action_benchmark() {
+  CFG_POST_MSG("Typed Action Benchmark");
+  // the way BitGen_GEMINI used to build a FCB action vs the typed builder
+  const size_t payload_size = 16 * 1024 * 1024;
+  std::vector<uint8_t> payload(payload_size);
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = (uint8_t)(i ^ (i >> 9));
+  }
+  auto start = std::chrono::steady_clock::now();
+  nlohmann::json json;
+  json["action"] = "fcb_config";
+  json["bitline_byte_size"] = 1024;
+  json["readback"] = 0;
+  json["payload"] = nlohmann::json(payload);
+  BitGen_BITSTREAM_ACTION* json_action =
+      BitGen_JSON::gen_fcb_config_action(json);
+  BitGen_JSON::zeroize_array_numbers(json["payload"]);
+  double json_time = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  start = std::chrono::steady_clock::now();
+  BitGen_FCB_CONFIG_FIELD fcb;
+  fcb.bitline_byte_size = 1024;
+  fcb.readback = 0;
+  BitGen_BITSTREAM_ACTION* typed_action =
+      BitGen_JSON::gen_fcb_config_action(fcb, std::vector<uint8_t>(payload));
+  double typed_time = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  test_compare_action(json_action, typed_action);
+  CFG_POST_MSG("!!! Result: %ld MB payload action in %.3f ms (JSON) vs %.3f "
+               "ms (typed)",
+               payload_size / (1024 * 1024), json_time, typed_time);
+}
+
+// Expose the bit kernels of BitGen_GEMINI
+class BitGen_GEMINI_TEST : public BitGen_GEMINI {
+ public:
+  BitGen_GEMINI_TEST(const CFGObject_BITOBJ* bitobj) : BitGen_GEMINI(bitobj) {}
+  using BitGen_GEMINI::adjust_data_bit_size;
+  using BitGen_GEMINI::append_alternate_data;
+  using BitGen_GEMINI::genbits_line_by_line;
+  using BitGen_GEMINI::get_pcb_user_data_and_parity;
+};
+
+// Bit by bit reference of the BitGen_GEMINI kernels
+static bool test_get_bit(const std::vector<uint8_t>& data, size_t index) {
+  CFG_ASSERT(index < (data.size() * 8));
+  return (data[index >> 3] & (1 << (index & 7))) != 0;
+}
+
+static void test_assign_bit(std::vector<uint8_t>& data, bool value,
+                            size_t index) {
+  while (index >= (data.size() * 8)) {
+    data.push_back(0);
+  }
+  if (value) {
+    data[index >> 3] |= (1 << (index & 7));
+  } else {
+    data[index >> 3] &= (uint8_t)(~(1 << (index & 7)));
+  }
+}
+
+static std::vector<uint8_t> test_genbits_line_by_line(
+    const std::vector<uint8_t>& src_data, uint64_t line_bits,
+    uint64_t total_line, uint64_t src_unit_bits, uint64_t dest_unit_bits,
+    bool pad_reversed, bool unit_reversed) {
+  uint64_t src_line_aligned_bits =
+      ((line_bits + src_unit_bits - 1) / src_unit_bits) * src_unit_bits;
+  uint64_t dest_line_aligned_bits =
+      ((line_bits + dest_unit_bits - 1) / dest_unit_bits) * dest_unit_bits;
+  uint64_t padding_bits = dest_line_aligned_bits - line_bits;
+  std::vector<uint8_t> dest_data((dest_line_aligned_bits * total_line + 7) /
+                                 8);
+  for (uint64_t line = 0; line < total_line; line++) {
+    size_t src_index = size_t(line * src_line_aligned_bits);
+    size_t dest_index = size_t(line * dest_line_aligned_bits);
+    if (unit_reversed) {
+      dest_index += (dest_line_aligned_bits - dest_unit_bits);
+    }
+    if (pad_reversed) {
+      dest_index += padding_bits;
+    }
+    for (uint64_t bit = 0; bit < line_bits; bit++) {
+      if (test_get_bit(src_data, src_index)) {
+        dest_data[dest_index >> 3] |= (1 << (dest_index & 7));
+      }
+      src_index++;
+      dest_index++;
+      if (unit_reversed && bit < (line_bits - 1) &&
+          (dest_index % dest_unit_bits) == 0) {
+        dest_index -= (2 * dest_unit_bits);
+      }
+    }
+  }
+  return dest_data;
+}
+
+static void test_get_pcb_user_data_and_parity(std::vector<uint8_t>& data,
+                                              std::vector<uint8_t>& user_data,
+                                              std::vector<uint8_t>& parity) {
+  user_data.resize(32 * 1024 / 8);
+  parity.resize(4 * 1024 / 8);
+  const uint8_t* halves[2] = {&data[0], &data[data.size() / 2]};
+  size_t payload_index = 0;
+  size_t parity_index = 0;
+  for (size_t i = 0, half_index = 0; i < 1024; i++, half_index += 18) {
+    for (auto half : halves) {
+      for (size_t j = 0, temp = half_index; j < 18; j++, temp++) {
+        bool bit = (half[temp >> 3] & (1 << (temp & 7))) != 0;
+        if (j < 16) {
+          test_assign_bit(user_data, bit, payload_index++);
+        } else {
+          test_assign_bit(parity, bit, parity_index++);
+        }
+      }
+    }
+  }
+}
+
+static void test_adjust_data_bit_size(std::vector<uint8_t>& data,
+                                      size_t original_size, size_t new_size,
+                                      size_t count, bool value_to_adjust,
+                                      bool include_remaining) {
+  size_t original_total_bits = original_size * count;
+  std::vector<uint8_t> new_data;
+  for (size_t src = 0, dest = 0; src < (data.size() * 8); src++) {
+    if (src < original_total_bits) {
+      size_t src_unit_index = src % original_size;
+      if (src_unit_index < new_size) {
+        test_assign_bit(new_data, test_get_bit(data, src), dest++);
+      }
+      if (src_unit_index == (original_size - 1)) {
+        for (size_t temp = original_size; temp < new_size; temp++, dest++) {
+          test_assign_bit(new_data, value_to_adjust, dest);
+        }
+      }
+    } else if (include_remaining) {
+      test_assign_bit(new_data, test_get_bit(data, src), dest++);
+    } else {
+      break;
+    }
+  }
+  data = new_data;
+}
+
+static void test_append_alternate_data(std::vector<uint8_t>& data,
+                                       std::vector<uint8_t>& data0,
+                                       std::vector<uint8_t>& data1,
+                                       size_t bit_size, size_t count,
+                                       size_t dest_index) {
+  for (size_t i = 0, src_index = 0; i < count; i++, src_index += bit_size) {
+    for (size_t j = 0; j < bit_size; j++, dest_index++) {
+      test_assign_bit(data, test_get_bit(data0, src_index + j), dest_index);
+    }
+    for (size_t j = 0; j < bit_size; j++, dest_index++) {
+      test_assign_bit(data, test_get_bit(data1, src_index + j), dest_index);
+    }
+  }
+}
+
+static std::vector<uint8_t> test_random_data(size_t size, uint32_t& seed) {
+  std::vector<uint8_t> data(size);
+  for (auto& d : data) {
+    seed = seed * 1664525 + 1013904223;
+    d = (uint8_t)(seed >> 24);
+  }
+  return data;
+}
+
+void test_gemini_bit_kernels() {
+  CFG_POST_MSG("Gemini Bit Kernels Test");
+  CFGObject_BITOBJ bitobj;
+  BitGen_GEMINI_TEST gemini(&bitobj);
+  uint32_t seed = 0x9E3779B9;
+  // genbits_line_by_line
+  for (uint64_t line_bits : {1, 7, 8, 31, 32, 33, 63, 64, 65, 100, 517, 1237}) {
+    for (uint64_t src_unit : {1, 8, 16}) {
+      for (uint64_t dest_unit : {8, 16, 32, 64}) {
+        for (int flags = 0; flags < 4; flags++) {
+          uint64_t total_line = 1 + (line_bits % 5);
+          uint64_t src_aligned =
+              ((line_bits + src_unit - 1) / src_unit) * src_unit;
+          if (((src_aligned * total_line) % 8) != 0) {
+            continue;
+          }
+          std::vector<uint8_t> src =
+              test_random_data(src_aligned * total_line / 8, seed);
+          CFG_ASSERT(gemini.genbits_line_by_line(src, line_bits, total_line,
+                                                 src_unit, dest_unit,
+                                                 flags & 1, flags & 2) ==
+                     test_genbits_line_by_line(src, line_bits, total_line,
+                                               src_unit, dest_unit, flags & 1,
+                                               flags & 2));
+        }
+      }
+    }
+  }
+  // get_pcb_user_data_and_parity
+  for (int i = 0; i < 4; i++) {
+    std::vector<uint8_t> data = test_random_data(36 * 1024 / 8, seed);
+    std::vector<uint8_t> user_data = {1, 2, 3};
+    std::vector<uint8_t> parity;
+    std::vector<uint8_t> ref_user_data;
+    std::vector<uint8_t> ref_parity;
+    gemini.get_pcb_user_data_and_parity(data, user_data, parity);
+    test_get_pcb_user_data_and_parity(data, ref_user_data, ref_parity);
+    CFG_ASSERT(user_data == ref_user_data);
+    CFG_ASSERT(parity == ref_parity);
+  }
+  // adjust_data_bit_size
+  for (size_t original_size : {1, 3, 4, 8, 17, 32, 70}) {
+    for (size_t new_size : {2, 4, 5, 32, 36, 100}) {
+      if (original_size == new_size) {
+        continue;
+      }
+      for (int flags = 0; flags < 4; flags++) {
+        size_t count = 1 + (original_size * new_size) % 37;
+        std::vector<uint8_t> data =
+            test_random_data((original_size * count + 7) / 8 + 3, seed);
+        std::vector<uint8_t> ref_data = data;
+        gemini.adjust_data_bit_size(data, original_size, new_size, count,
+                                    flags & 1, flags & 2);
+        test_adjust_data_bit_size(ref_data, original_size, new_size, count,
+                                  flags & 1, flags & 2);
+        CFG_ASSERT(data == ref_data);
+      }
+    }
+  }
+  // append_alternate_data
+  for (size_t bit_size : {1, 4, 8, 13, 32, 64, 100}) {
+    for (size_t dest_index : {0, 5, 16, 200}) {
+      size_t count = 1 + bit_size % 11;
+      std::vector<uint8_t> data0 =
+          test_random_data((bit_size * count + 7) / 8, seed);
+      std::vector<uint8_t> data1 =
+          test_random_data((bit_size * count + 7) / 8, seed);
+      std::vector<uint8_t> data = test_random_data(20, seed);
+      std::vector<uint8_t> ref_data = data;
+      gemini.append_alternate_data(data, data0, data1, bit_size, count,
+                                   dest_index, false);
+      test_append_alternate_data(ref_data, data0, data1, bit_size, count,
+                                 dest_index);
+      CFG_ASSERT(data == ref_data);
+    }
+  }
+}
+
+void test_gemini_bit_kernels_benchmark() {
+  CFG_POST_MSG("Gemini Bit Kernels Benchmark");
+  CFGObject_BITOBJ bitobj;
+  BitGen_GEMINI_TEST gemini(&bitobj);
+  uint32_t seed = 0x7F4A7C15;
+  // scan chain FCB of 8K chains x 4K bits, twisted
+  const uint64_t line_bits = 8191;
+  const uint64_t total_line = 4096;
+  std::vector<uint8_t> src =
+      test_random_data(((line_bits + 7) / 8) * total_line, seed);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> fcb = gemini.genbits_line_by_line(
+      src, line_bits, total_line, 8, 32, true, true);
+  double fcb_time = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> ref_fcb = test_genbits_line_by_line(
+      src, line_bits, total_line, 8, 32, true, true);
+  double ref_fcb_time = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  CFG_ASSERT(fcb == ref_fcb);
+  CFG_POST_MSG("!!! Result: %ld x %ld FCB bits in %.3f ms (bit by bit %.3f "
+               "ms)",
+               line_bits, total_line, fcb_time, ref_fcb_time);
+  // 256 PCB of 36K BRAM, the way BitGen_GEMINI::generate() does
+  const size_t pcb_count = 256;
+  std::vector<std::vector<uint8_t>> pcbs;
+  for (size_t i = 0; i < pcb_count; i++) {
+    pcbs.push_back(test_random_data(36 * 1024 / 8, seed));
+  }
+  std::vector<uint8_t> payload;
+  start = std::chrono::steady_clock::now();
+  for (auto& pcb : pcbs) {
+    std::vector<uint8_t> user_data;
+    std::vector<uint8_t> parity;
+    gemini.get_pcb_user_data_and_parity(pcb, user_data, parity);
+    gemini.adjust_data_bit_size(parity, 4, 32, 1024);
+    gemini.append_alternate_data(payload, user_data, parity, 32, 1024,
+                                 payload.size() * 8, true);
+  }
+  double pcb_time = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  std::vector<uint8_t> ref_payload;
+  start = std::chrono::steady_clock::now();
+  for (auto& pcb : pcbs) {
+    std::vector<uint8_t> user_data;
+    std::vector<uint8_t> parity;
+    test_get_pcb_user_data_and_parity(pcb, user_data, parity);
+    test_adjust_data_bit_size(parity, 4, 32, 1024, false, false);
+    test_append_alternate_data(ref_payload, user_data, parity, 32, 1024,
+                               ref_payload.size() * 8);
+  }
+  double ref_pcb_time = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  CFG_ASSERT(payload == ref_payload);
+  CFG_POST_MSG("!!! Result: %ld PCB payload in %.3f ms (bit by bit %.3f ms)",
+               pcb_count, pcb_time, ref_pcb_time);
+}
+
+static void test_gemini_pcb_bitobj(CFGObject_BITOBJ& bitobj, size_t count,
+                                   uint32_t& seed) {
+  bitobj.configuration.write_str("family", "Gemini");
+  bitobj.configuration.write_str("protocol", "scan_chain");
+  bitobj.scan_chain_fcb.write_u32("length", 4);
+  bitobj.scan_chain_fcb.write_u32("width", 32);
+  bitobj.scan_chain_fcb.write_u8s("data", test_random_data(16, seed));
+  for (size_t i = 0; i < count; i++) {
+    bitobj.create_child("pcb");
+    bitobj.pcb.back()->write_u32("x", (uint32_t)(2 + 3 * (i % 8)));
+    bitobj.pcb.back()->write_u32("y", (uint32_t)(1 + 2 * (i / 8)));
+    bitobj.pcb.back()->write_u32("bits", 36 * 1024);
+    bitobj.pcb.back()->write_u8s("data", test_random_data(36 * 1024 / 8, seed));
+  }
+}
+
+static std::vector<uint8_t> test_gemini_generate_pcb(
+    const CFGObject_BITOBJ& bitobj, uint32_t jobs, double& elapsed) {
+  BitGen_GEMINI gemini(&bitobj);
+  std::vector<BitGen_BITSTREAM_BOP*> bops;
+  auto start = std::chrono::steady_clock::now();
+  gemini.generate(bops, jobs);
+  elapsed = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  CFG_ASSERT(bops.size() == 1);
+  // FCB action is followed by the PCB action(s)
+  CFG_ASSERT(bops[0]->actions.size() >= 2);
+  std::vector<uint8_t> payload;
+  for (size_t i = 1; i < bops[0]->actions.size(); i++) {
+    payload.insert(payload.end(), bops[0]->actions[i]->payload.begin(),
+                   bops[0]->actions[i]->payload.end());
+  }
+  CFG_MEM_DELETE(bops[0]);
+  return payload;
+}
+
+void test_gemini_parallel_pcb() {
+  CFG_POST_MSG("Gemini Parallel PCB Test");
+  uint32_t seed = 0x2545F491;
+  CFGObject_BITOBJ bitobj;
+  test_gemini_pcb_bitobj(bitobj, 37, seed);
+  double elapsed = 0;
+  std::vector<uint8_t> serial = test_gemini_generate_pcb(bitobj, 1, elapsed);
+  // Bit by bit reference of every block
+  std::vector<uint8_t> ref_payload;
+  for (auto& pcb : bitobj.pcb) {
+    std::vector<uint8_t> user_data;
+    std::vector<uint8_t> parity;
+    test_get_pcb_user_data_and_parity(pcb->data, user_data, parity);
+    test_adjust_data_bit_size(parity, 4, 32, 1024, false, false);
+    test_append_alternate_data(ref_payload, user_data, parity, 32, 1024,
+                               ref_payload.size() * 8);
+  }
+  CFG_ASSERT(serial == ref_payload);
+  for (uint32_t jobs : {0, 2, 5, 64}) {
+    CFG_ASSERT(test_gemini_generate_pcb(bitobj, jobs, elapsed) == serial);
+  }
+}
+
+void test_gemini_parallel_pcb_benchmark() {
+  CFG_POST_MSG("Gemini Parallel PCB Benchmark");
+  uint32_t seed = 0x6A09E667;
+  const size_t count = 1024;
+  // Nothing to compare against on a single core
+  uint32_t jobs = std::thread::hardware_concurrency();
+  if (jobs <= 1) {
+    CFG_POST_MSG("!!! Result: skipped, single CPU core");
+    return;
+  }
+  CFGObject_BITOBJ bitobj;
+  test_gemini_pcb_bitobj(bitobj, count, seed);
+  double serial_time = 0;
+  double parallel_time = 0;
+  std::vector<uint8_t> serial =
+      test_gemini_generate_pcb(bitobj, 1, serial_time);
+  std::vector<uint8_t> parallel =
+      test_gemini_generate_pcb(bitobj, jobs, parallel_time);
+  CFG_ASSERT(serial == parallel);
+  CFG_POST_MSG("!!! Result: %ld PCB generated in %.3f ms (1 job) vs %.3f ms "
+               "(%d jobs)",
+               count, serial_time, parallel_time, jobs);
+}
+
+void test_encrypted_packing() {
+  CFG_POST_MSG("Encrypted Packing Test");
+  // pack encrypted payloads (one using the BOP IV, one using its own IV) and
+  // check that the analyzer decrypts them back
+  std::vector<BitGen_BITSTREAM_BOP*> bops;
+  bops.push_back(CFG_MEM_NEW(BitGen_BITSTREAM_BOP));
+  bops.back()->field.identifier = "FPGA";
+  bops.back()->field.checksum = 0x10;
+  bops.back()->field.integrity = 0x10;
+  std::vector<std::vector<uint8_t>> payloads;
+  for (size_t i = 0; i < 2; i++) {
+    BitGen_BITSTREAM_ACTION* action =
+        CFG_MEM_NEW(BitGen_BITSTREAM_ACTION, (uint16_t)(1 + i));
+    action->payload.resize(100 * 1024 + 20 + i * 4);
+    for (size_t j = 0; j < action->payload.size(); j++) {
+      action->payload[j] = (uint8_t)(j * (i + 3) + (j >> 10));
+    }
+    if (i == 1) {
+      action->iv.resize(16);
+      CFGOpenSSL::generate_iv(&action->iv[0], false);
+    }
+    payloads.push_back(action->payload);
+    bops.back()->actions.push_back(action);
+  }
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> aes_key(32);
+  CFGOpenSSL::generate_random_data(&aes_key[0], aes_key.size());
+  CFGCrypto_KEY* key = nullptr;
+  BitGen_PACKER::generate_bitstream(bops, data, false, aes_key, key);
+  CFG_MEM_DELETE(bops.back());
+  CFG_write_binary_file("bitgen_test_encrypted.cfgbit", &data[0], data.size());
+  BitGen_ANALYZER::parse_debug("bitgen_test_encrypted.cfgbit",
+                               "bitgen_test_encrypted.txt", aes_key);
+  for (size_t i = 0; i < payloads.size(); i++) {
+    std::string filepath =
+        CFG_print("bitgen_test_encrypted.bop0.payload%ld.bin", i);
+    std::vector<uint8_t> payload;
+    CFG_read_binary_file(filepath, payload);
+    CFG_ASSERT(payload == payloads[i]);
+    std::remove(filepath.c_str());
+  }
+  std::remove("bitgen_test_encrypted.cfgbit");
+  std::remove("bitgen_test_encrypted.txt");
+}
+
+void test_compressed_packing() {
+  CFG_POST_MSG("Compressed Packing Test");
+  // pack compressed payloads in both stream versions, plain and encrypted,
+  // and check that the analyzer decompresses them back. Long runs expand a 2K
+  // block beyond the analyzer decompression buffer
+  for (size_t test = 0; test < 4; test++) {
+    uint8_t compress_version = (uint8_t)(test & 1);
+    size_t key_size = test & 2 ? 32 : 0;
+    std::vector<BitGen_BITSTREAM_BOP*> bops;
+    bops.push_back(CFG_MEM_NEW(BitGen_BITSTREAM_BOP));
+    bops.back()->field.identifier = "FPGA";
+    bops.back()->field.checksum = 0x10;
+    bops.back()->field.integrity = 0x10;
+    std::vector<std::vector<uint8_t>> payloads;
+    for (size_t i = 0; i < 2; i++) {
+      BitGen_BITSTREAM_ACTION* action =
+          CFG_MEM_NEW(BitGen_BITSTREAM_ACTION, (uint16_t)(1 + i));
+      action->payload.resize(300 * 1024 + i * 4);
+      for (size_t j = 0; j < action->payload.size(); j++) {
+        if (j < 200 * 1024) {
+          action->payload[j] = 0;
+        } else if ((j >> 12) & 1) {
+          action->payload[j] = 0xFF;
+        } else {
+          action->payload[j] = (uint8_t)(j * (i + 3) + (j >> 10));
+        }
+      }
+      payloads.push_back(action->payload);
+      bops.back()->actions.push_back(action);
+    }
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> aes_key(key_size);
+    if (key_size) {
+      CFGOpenSSL::generate_random_data(&aes_key[0], aes_key.size());
+    }
+    CFGCrypto_KEY* key = nullptr;
+    BitGen_PACKER::generate_bitstream(bops, data, true, aes_key, key, 1,
+                                      compress_version);
+    if (key_size == 0) {
+      const uint8_t magic[] = {'C', 'F', 'G', '_', 'C', 'M', 'P',
+                               compress_version};
+      CFG_ASSERT(std::search(data.begin(), data.end(), magic,
+                             magic + sizeof(magic)) != data.end());
+    }
+    CFG_MEM_DELETE(bops.back());
+    CFG_write_binary_file("bitgen_test_compressed.cfgbit", &data[0],
+                          data.size());
+    BitGen_ANALYZER::parse_debug("bitgen_test_compressed.cfgbit",
+                                 "bitgen_test_compressed.txt", aes_key);
+    // the payloads really went through the decompress engine
+    std::vector<uint8_t> txt;
+    CFG_read_binary_file("bitgen_test_compressed.txt", txt);
+    std::string done = "[DCMP: DONE]";
+    CFG_ASSERT(std::search(txt.begin(), txt.end(), done.begin(), done.end()) !=
+               txt.end());
+    for (size_t i = 0; i < payloads.size(); i++) {
+      std::string filepath =
+          CFG_print("bitgen_test_compressed.bop0.payload%ld.bin", i);
+      std::vector<uint8_t> payload;
+      CFG_read_binary_file(filepath, payload);
+      CFG_ASSERT(payload == payloads[i]);
+      std::remove(filepath.c_str());
+    }
+    std::remove("bitgen_test_compressed.cfgbit");
+    std::remove("bitgen_test_compressed.txt");
+  }
+}
 
 int main(int argc, const char** argv) {
   CFG_POST_MSG("This is BITGEN unit test");
+  // Benchmarks only run on request: bitgen_test --benchmark
+  bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
+  test_parallel_packing();
+  test_large_payload_packing();
+  test_encrypted_packing();
+  test_compressed_packing();
+  test_decompress_engine();
+  if (benchmark) {
+    test_decompress_engine_benchmark();
+  }
+  test_typed_action();
+  if (benchmark) {
+    test_typed_action_benchmark();
+  }
+  test_gemini_bit_kernels();
+  if (benchmark) {
+    test_gemini_bit_kernels_benchmark();
+  }
+  test_gemini_parallel_pcb();
+  if (benchmark) {
+    test_gemini_parallel_pcb_benchmark();
+  }
   return 0;
 }
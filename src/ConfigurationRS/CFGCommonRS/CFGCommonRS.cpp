@@ -1,17 +1,39 @@
 #include "CFGCommonRS.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
 #include <windows.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
 #include <unistd.h>
 #endif
 #include "CFGCompress.h"
 
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define CFGCOMMONRS_PCLMUL
+#define CFGCOMMONRS_PCLMUL_TARGET __attribute__((target("pclmul,sse2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <emmintrin.h>
+#include <intrin.h>
+#include <wmmintrin.h>
+#define CFGCOMMONRS_PCLMUL
+#define CFGCOMMONRS_PCLMUL_TARGET
+#endif
+
 struct CFG_MEM_TRACKER {
   CFG_MEM_TRACKER(void* p, const char* f, size_t l)
       : ptr(p), filename(f), line(l) {
@@ -24,6 +46,8 @@ struct CFG_MEM_TRACKER {
 };
 
 static std::vector<CFG_MEM_TRACKER*> CFG_MEM_TRACKER_LIST;
+// CFG_MEM_NEW/CFG_MEM_DELETE may be called from worker threads
+static std::mutex CFG_MEM_TRACKER_MUTEX;
 
 static class CFG_MANAGER {
  public:
@@ -253,19 +277,55 @@ std::string CFG_print_strings_to_string(const std::vector<std::string>& strings,
 
 void CFG_compress(const uint8_t* input, const size_t input_size,
                   std::vector<uint8_t>& output, size_t* header_size,
-                  const bool debug, const bool retry) {
+                  const bool debug, const bool retry, const uint8_t version) {
   CFG_ASSERT(input != nullptr);
   CFG_ASSERT(input_size > 0);
+  CFG_ASSERT(version == 0 || version == 1);
+  if (version == 1) {
+    // Segmented stream, the segments are compressed in parallel
+    CFG_COMPRESS::compress_segments(input, input_size, output, header_size,
+                                    retry);
+    return;
+  }
 
   std::vector<uint8_t> cmp_output0;
   size_t header_size0 = 0;
   std::vector<uint8_t> cmp_output1;
   size_t header_size1 = 0;
-  CFG_COMPRESS::compress(input, input_size, cmp_output0, &header_size0, true,
-                         debug);
-  if (retry) {
-    CFG_COMPRESS::compress(input, input_size, cmp_output1, &header_size1, false,
+  // Both strategies are independent scans of the whole input, so the one
+  // without followup byte support runs on its own thread. Keep them
+  // sequential in debug mode, otherwise the messages interleave
+  std::thread retry_thread;
+  std::exception_ptr retry_error = nullptr;
+  if (retry && !debug) {
+    retry_thread = std::thread([&]() {
+      try {
+        CFG_COMPRESS::compress(input, input_size, cmp_output1, &header_size1,
+                               false, debug);
+      } catch (...) {
+        retry_error = std::current_exception();
+      }
+    });
+  }
+  try {
+    CFG_COMPRESS::compress(input, input_size, cmp_output0, &header_size0, true,
                            debug);
+  } catch (...) {
+    if (retry_thread.joinable()) {
+      retry_thread.join();
+    }
+    throw;
+  }
+  if (retry) {
+    if (retry_thread.joinable()) {
+      retry_thread.join();
+      if (retry_error != nullptr) {
+        std::rethrow_exception(retry_error);
+      }
+    } else {
+      CFG_COMPRESS::compress(input, input_size, cmp_output1, &header_size1,
+                             false, debug);
+    }
     if (debug) {
       CFG_POST_DBG("Compressed size (with followup byte support): %ld",
                    cmp_output0.size());
@@ -273,17 +333,15 @@ void CFG_compress(const uint8_t* input, const size_t input_size,
                    cmp_output1.size());
     }
   }
-  if (retry && (cmp_output0.size() > cmp_output1.size())) {
-    output.insert(output.end(), cmp_output1.begin(), cmp_output1.end());
+  bool use_output1 = retry && (cmp_output0.size() > cmp_output1.size());
+  std::vector<uint8_t>& cmp_output = use_output1 ? cmp_output1 : cmp_output0;
+  if (output.empty()) {
+    output.swap(cmp_output);
   } else {
-    output.insert(output.end(), cmp_output0.begin(), cmp_output0.end());
+    output.insert(output.end(), cmp_output.begin(), cmp_output.end());
   }
   if (header_size != nullptr) {
-    if (retry && (cmp_output0.size() > cmp_output1.size())) {
-      (*header_size) = header_size1;
-    } else {
-      (*header_size) = header_size0;
-    }
+    (*header_size) = use_output1 ? header_size1 : header_size0;
   }
 }
 
@@ -294,16 +352,156 @@ void CFG_decompress(const uint8_t* input, const size_t input_size,
   CFG_COMPRESS::decompress(input, input_size, output, debug);
 }
 
+size_t CFG_decompress_size(const uint8_t* input, const size_t input_size) {
+  CFG_ASSERT(input != nullptr);
+  CFG_ASSERT(input_size > 0);
+  return CFG_COMPRESS::get_original_size(input, input_size);
+}
+
+void CFG_decompress(const uint8_t* input, const size_t input_size,
+                    uint8_t* output, const size_t output_size,
+                    const bool debug) {
+  CFG_ASSERT(input != nullptr);
+  CFG_ASSERT(input_size > 0);
+  CFG_COMPRESS::decompress(input, input_size, output, output_size, debug);
+}
+
+// Slicing-by-8 tables of a reflected CRC table. TABLE[k][i] is the CRC of
+// byte i followed by k zero bytes, which only holds for a linear table (all
+// the built-in tables are)
+template <typename T>
+struct CFGCommonRS_CRC_SLICING {
+  CFGCommonRS_CRC_SLICING(const T* table) {
+    memcpy(TABLE[0], table, sizeof(TABLE[0]));
+    for (size_t k = 1; k < 8; k++) {
+      for (size_t i = 0; i < 256; i++) {
+        T crc = TABLE[k - 1][i];
+        TABLE[k][i] = TABLE[0][uint8_t(crc)] ^ (T)(crc >> 8);
+      }
+    }
+  }
+  T TABLE[8][256];
+};
+
+template <typename T>
+static T CFGCommonRS_crc_by_byte(const uint8_t* addr, size_t size, T crc,
+                                 const T* TABLE) {
+  for (size_t i = 0; i < size; i++) {
+    crc = TABLE[(uint8_t(crc) ^ addr[i]) & 0xFF] ^ (T)(crc >> 8);
+  }
+  return crc;
+}
+
+// CRC (16 or 32 bits) of eight bytes per iteration, same result as
+// CFGCommonRS_crc_by_byte() with TABLE[0]
+template <typename T>
+static T CFGCommonRS_crc_by_slicing(const uint8_t* addr, size_t size, T crc,
+                                    const CFGCommonRS_CRC_SLICING<T>& slicing) {
+  const T(*TABLE)[256] = slicing.TABLE;
+  while (size >= 8) {
+    uint32_t low = (uint32_t)(crc) ^ ((uint32_t)(addr[0]) |
+                                      ((uint32_t)(addr[1]) << 8) |
+                                      ((uint32_t)(addr[2]) << 16) |
+                                      ((uint32_t)(addr[3]) << 24));
+    crc = TABLE[7][low & 0xFF] ^ TABLE[6][(low >> 8) & 0xFF] ^
+          TABLE[5][(low >> 16) & 0xFF] ^ TABLE[4][low >> 24] ^
+          TABLE[3][addr[4]] ^ TABLE[2][addr[5]] ^ TABLE[1][addr[6]] ^
+          TABLE[0][addr[7]];
+    addr += 8;
+    size -= 8;
+  }
+  return CFGCommonRS_crc_by_byte(addr, size, crc, TABLE[0]);
+}
+
+#if defined(CFGCOMMONRS_PCLMUL)
+static bool CFGCommonRS_support_pclmul() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // EDX bit 26 is SSE2, ECX bit 1 is PCLMULQDQ
+  return (info[3] & (1 << 26)) != 0 && (info[2] & (1 << 1)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2") && __builtin_cpu_supports("pclmul");
+#endif
+}
+
+// Fold 64 bytes per iteration with carry-less multiplication (Intel "Fast CRC
+// Computation Using PCLMULQDQ Instruction"). The constants are
+// (x^n mod P) bit reflected and shifted left by one, with n = 4*128+32,
+// 4*128-32, 128+32 and 128-32, where P is the normal form (0x1EDB88320) of
+// the reflected 0x04C11DB7 table, so they differ from the ones of the
+// standard CRC32. The folded 128 bits have the same CRC as the input, it is
+// reduced with the table instead of Barrett reduction.
+// Size must be a multiple of 16 and at least 64.
+CFGCOMMONRS_PCLMUL_TARGET static uint32_t CFGCommonRS_crc32_by_pclmul(
+    const uint8_t* addr, size_t size, uint32_t crc) {
+  const __m128i k1k2 = _mm_set_epi32(0, 0x094E01E6, 0, 0x07DBE810);
+  const __m128i k3k4 = _mm_set_epi32(0, 0x0862C3FC, 0, 0x0E22D4DC);
+  const __m128i* data = reinterpret_cast<const __m128i*>(addr);
+  __m128i x1 = _mm_loadu_si128(data);
+  __m128i x2 = _mm_loadu_si128(data + 1);
+  __m128i x3 = _mm_loadu_si128(data + 2);
+  __m128i x4 = _mm_loadu_si128(data + 3);
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)(crc)));
+  data += 4;
+  size -= 64;
+  while (size >= 64) {
+    __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(data));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(data + 1));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(data + 2));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(data + 3));
+    data += 4;
+    size -= 64;
+  }
+  // Fold 4 x 128 bits into 128 bits, then the remaining 16 bytes blocks
+  __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x2);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x3);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x4);
+  while (size >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(data));
+    data++;
+    size -= 16;
+  }
+  CFG_ASSERT(size == 0);
+  uint8_t folded[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), x1);
+  return CFGCommonRS_crc_by_byte(folded, sizeof(folded), uint32_t(0),
+                                 CFGCommonRS_CRC_04C11DB7_TABLE);
+}
+#endif
+
 uint16_t CFG_crc16(const uint8_t* addr, size_t size, uint16_t lfsr_init,
                    bool final_xor, const uint16_t* custom_table) {
   CFG_ASSERT(addr != nullptr && size > 0);
   uint16_t crc(lfsr_init);
-  uint8_t table_index = 0;
-  const uint16_t* TABLE =
-      custom_table == nullptr ? CFGCommonRS_CRC_8408_TABLE : custom_table;
-  for (size_t i = 0; i < size; i++) {
-    table_index = (uint8_t(crc) ^ addr[i]) & 0xFF;
-    crc = TABLE[table_index] ^ (crc >> 8);
+  if (custom_table == nullptr || custom_table == CFGCommonRS_CRC_8408_TABLE) {
+    static const CFGCommonRS_CRC_SLICING<uint16_t> slicing(
+        CFGCommonRS_CRC_8408_TABLE);
+    crc = CFGCommonRS_crc_by_slicing(addr, size, crc, slicing);
+  } else if (custom_table == CFGCommonRS_CRC_A001_TABLE) {
+    static const CFGCommonRS_CRC_SLICING<uint16_t> slicing(
+        CFGCommonRS_CRC_A001_TABLE);
+    crc = CFGCommonRS_crc_by_slicing(addr, size, crc, slicing);
+  } else {
+    // Custom table might not be linear, stay with one byte at a time
+    crc = CFGCommonRS_crc_by_byte(addr, size, crc, custom_table);
   }
   if (final_xor) {
     crc ^= 0xFFFF;
@@ -323,12 +521,23 @@ uint32_t CFG_crc32(const uint8_t* addr, size_t size, uint32_t lfsr_init,
                    bool final_xor, const uint32_t* custom_table) {
   CFG_ASSERT(addr != nullptr && size > 0);
   uint32_t crc(lfsr_init);
-  uint8_t table_index = 0;
-  const uint32_t* TABLE =
-      custom_table == nullptr ? CFGCommonRS_CRC_04C11DB7_TABLE : custom_table;
-  for (size_t i = 0; i < size; i++) {
-    table_index = (uint8_t(crc) ^ addr[i]) & 0xFF;
-    crc = TABLE[table_index] ^ (crc >> 8);
+  if (custom_table == nullptr ||
+      custom_table == CFGCommonRS_CRC_04C11DB7_TABLE) {
+#if defined(CFGCOMMONRS_PCLMUL)
+    static const bool pclmul = CFGCommonRS_support_pclmul();
+    if (pclmul && size >= 64) {
+      size_t fold_size = size & ~(size_t)(15);
+      crc = CFGCommonRS_crc32_by_pclmul(addr, fold_size, crc);
+      addr += fold_size;
+      size -= fold_size;
+    }
+#endif
+    static const CFGCommonRS_CRC_SLICING<uint32_t> slicing(
+        CFGCommonRS_CRC_04C11DB7_TABLE);
+    crc = CFGCommonRS_crc_by_slicing(addr, size, crc, slicing);
+  } else {
+    // Custom table might not be linear, stay with one byte at a time
+    crc = CFGCommonRS_crc_by_byte(addr, size, crc, custom_table);
   }
   if (final_xor) {
     crc ^= 0xFFFFFFFF;
@@ -408,6 +617,48 @@ bool CFG_check_all_zeros(const uint8_t* data, size_t size) {
   return zero;
 }
 
+void CFG_parallel_for(size_t count, uint32_t jobs,
+                      const std::function<void(size_t)>& function) {
+  if (jobs == 0) {
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (jobs > count) {
+    jobs = (uint32_t)(count);
+  }
+  if (jobs <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      function(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next(0);
+  std::exception_ptr error = nullptr;
+  std::mutex error_mutex;
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      try {
+        function(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < jobs; i++) {
+    threads.push_back(std::thread(worker));
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
 void CFG_print_hex(std::ofstream& file, const uint8_t* data,
                    const uint64_t data_size, const uint8_t unit_size,
                    const std::string space, bool detail) {
@@ -620,6 +871,9 @@ uint64_t CFG_get_nano_time() {
 }
 
 uint64_t CFG_get_unique_nano_time() {
+  // Parallel BOP packing generates IVs from it on several threads
+  static std::mutex backup_mutex;
+  std::lock_guard<std::mutex> lock(backup_mutex);
   static uint64_t backup_time = CFG_get_nano_time();
   uint64_t time = CFG_get_nano_time();
   if (backup_time >= time) {
@@ -629,7 +883,88 @@ uint64_t CFG_get_unique_nano_time() {
   return time;
 }
 
+CFG_MMAP_FILE::CFG_MMAP_FILE(const std::string& filepath) {
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return;
+  }
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return;
+  }
+  m_file = file;
+  m_mapping = mapping;
+  m_data = (const uint8_t*)(data);
+  m_size = (size_t)(size.QuadPart);
+#else
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return;
+  }
+  void* data =
+      mmap(nullptr, (size_t)(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return;
+  }
+  madvise(data, (size_t)(st.st_size), MADV_SEQUENTIAL);
+  m_data = (const uint8_t*)(data);
+  m_size = (size_t)(st.st_size);
+#endif
+}
+
+CFG_MMAP_FILE::~CFG_MMAP_FILE() {
+  if (m_data == nullptr) {
+    return;
+  }
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  UnmapViewOfFile(m_data);
+  CloseHandle((HANDLE)(m_mapping));
+  CloseHandle((HANDLE)(m_file));
+#else
+  munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+void CFG_MMAP_FILE::release(size_t offset, size_t size) {
+  CFG_ASSERT(offset <= m_size && size <= (m_size - offset));
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  // clean file backed pages are trimmed from the working set by the system
+#else
+  // only whole pages inside the range can be dropped
+  size_t page_size = (size_t)(sysconf(_SC_PAGESIZE));
+  size_t start = ((offset + page_size - 1) / page_size) * page_size;
+  size_t end = ((offset + size) / page_size) * page_size;
+  if (m_data != nullptr && end > start) {
+    madvise(const_cast<uint8_t*>(m_data) + start, end - start, MADV_DONTNEED);
+  }
+#endif
+}
+
 void CFG_TRACK_MEM(void* ptr, const char* filename, size_t line) {
+  std::lock_guard<std::mutex> lock(CFG_MEM_TRACKER_MUTEX);
   bool status = true;
   for (CFG_MEM_TRACKER* tracker : CFG_MEM_TRACKER_LIST) {
     if (tracker->ptr == ptr) {
@@ -647,6 +982,7 @@ void CFG_TRACK_MEM(void* ptr, const char* filename, size_t line) {
 }
 
 void CFG_UNTRACK_MEM(void* ptr, const char* filename, size_t line) {
+  std::lock_guard<std::mutex> lock(CFG_MEM_TRACKER_MUTEX);
   CFG_MEM_TRACKER* tracker = nullptr;
   for (CFG_MEM_TRACKER* t : CFG_MEM_TRACKER_LIST) {
     if (t->ptr == ptr) {
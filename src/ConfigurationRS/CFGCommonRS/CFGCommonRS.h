@@ -2,6 +2,7 @@
 #define CFGCommonRS_H
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <vector>
 
@@ -25,11 +26,18 @@ std::string CFG_print_strings_to_string(const std::vector<std::string>& strings,
 
 void CFG_compress(const uint8_t* input, const size_t input_size,
                   std::vector<uint8_t>& output, size_t* header_size = nullptr,
-                  const bool debug = false, const bool retry = true);
+                  const bool debug = false, const bool retry = true,
+                  const uint8_t version = 0);
 
 void CFG_decompress(const uint8_t* input, const size_t input_size,
                     std::vector<uint8_t>& output, const bool debug = false);
 
+size_t CFG_decompress_size(const uint8_t* input, const size_t input_size);
+
+void CFG_decompress(const uint8_t* input, const size_t input_size,
+                    uint8_t* output, const size_t output_size,
+                    const bool debug = false);
+
 uint16_t CFG_crc16(const uint8_t* addr, size_t size,
                    uint16_t lfsr_init = static_cast<uint16_t>(-1),
                    bool final_xor = true,
@@ -60,6 +68,13 @@ int CFG_check_file_extensions(const std::string& filepath,
 
 bool CFG_check_all_zeros(const uint8_t* data, size_t size);
 
+// Run function(0) ... function(count - 1) on a pool of at most count workers,
+// the calling thread being one of them (jobs = 0 means one worker per CPU
+// core). The first exception of any worker is raised again once all of them
+// are joined
+void CFG_parallel_for(size_t count, uint32_t jobs,
+                      const std::function<void(size_t)>& function);
+
 void CFG_print_hex(std::ofstream& file, const uint8_t* data,
                    const uint64_t data_size, const uint8_t unit_size,
                    const std::string space, bool detail);
@@ -84,6 +99,31 @@ uint64_t CFG_get_nano_time();
 
 uint64_t CFG_get_unique_nano_time();
 
+// Read-only memory mapping of a whole file. The content is paged in on access
+// so huge files can be walked without reading them into memory first.
+// data() is nullptr if the file can not be mapped (or is empty).
+class CFG_MMAP_FILE {
+ public:
+  CFG_MMAP_FILE(const std::string& filepath);
+  ~CFG_MMAP_FILE();
+  const uint8_t* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool is_open() const { return m_data != nullptr; }
+  // hint that [offset, offset + size) will not be accessed again so the
+  // pages can be dropped
+  void release(size_t offset, size_t size);
+
+ private:
+  CFG_MMAP_FILE(const CFG_MMAP_FILE&) = delete;
+  CFG_MMAP_FILE& operator=(const CFG_MMAP_FILE&) = delete;
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#endif
+};
+
 void CFG_TRACK_MEM(void* ptr, const char* filename, size_t line);
 void CFG_UNTRACK_MEM(void* ptr, const char* filename, size_t line);
 
@@ -1,5 +1,6 @@
 #include "CFGCompress.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "CFGCommonRS.h"
@@ -18,15 +19,11 @@
 #define CFG_CMP_VAR (7)
 #define CFG_CMP_INVALID (8)
 
-void CFG_COMPRESS::analyze_repeat(const uint8_t* input, const size_t input_size,
-                                  size_t index, size_t& length, size_t& repeat,
-                                  const uint8_t debug) {
-  length = 0;
-  repeat = 0;
+size_t CFG_COMPRESS::analyze_repeat_length_by_memcmp(const uint8_t* input,
+                                                     const size_t input_size,
+                                                     size_t index) {
+  size_t length = 0;
   size_t total_length = input_size - index;
-  if (total_length < (2 * CFG_CMP_MIN_REPEAT_LENGTH_SEARCH)) {
-    return;
-  }
   size_t temp_length = CFG_CMP_MIN_REPEAT_LENGTH_SEARCH;
   uint8_t repeated_check_seq = 0;
   uint8_t repeated_byte = input[index];
@@ -57,7 +54,6 @@ void CFG_COMPRESS::analyze_repeat(const uint8_t* input, const size_t input_size,
         repeated_check_size += 2;
         if (repeated_check_size >= CFG_CMP_MAX_REPEAT_SAME_PATTERN) {
           length = 0;
-          repeat = 0;
           break;
         }
       } else {
@@ -71,6 +67,75 @@ void CFG_COMPRESS::analyze_repeat(const uint8_t* input, const size_t input_size,
     }
     temp_length++;
   }
+  return length;
+}
+
+size_t CFG_COMPRESS::analyze_repeat_length(const uint8_t* input,
+                                           const size_t input_size,
+                                           size_t index) {
+  // Same result as analyze_repeat_length_by_memcmp(). A run of the same byte
+  // which is long enough is left to compress_none_repeat()
+  const uint8_t* data = &input[index];
+  size_t total_length = input_size - index;
+  size_t run_length = 1;
+  while (run_length < CFG_CMP_MAX_REPEAT_SAME_PATTERN &&
+         run_length < total_length && data[run_length] == data[0]) {
+    run_length++;
+  }
+  if (run_length >= CFG_CMP_MAX_REPEAT_SAME_PATTERN) {
+    return 0;
+  }
+  // Rolling polynomial hash of chunk0 (data[0, t)) and chunk1 (data[t, 2t)),
+  // only a hash match is confirmed by memcmp
+  const uint64_t base = 0x100000001B3;
+  uint64_t hash0 = 0;
+  uint64_t hash1 = 0;
+  size_t temp_length = CFG_CMP_MIN_REPEAT_LENGTH_SEARCH;
+  for (size_t i = 0; i < temp_length; i++) {
+    hash0 = (hash0 * base) + data[i];
+    hash1 = (hash1 * base) + data[temp_length + i];
+  }
+  // base^(temp_length - 1)
+  uint64_t power = base * base;
+  size_t length = 0;
+  size_t max_length = total_length / 2;
+  while (temp_length <= max_length) {
+    if (length == 0 && temp_length > CFG_CMP_MAX_REPEAT_LENGTH_SEARCH) {
+      break;
+    }
+    if (hash0 == hash1 &&
+        ((2 * temp_length) <= run_length ||
+         memcmp(data, &data[temp_length], temp_length) == 0)) {
+      length = temp_length;
+    } else if (length) {
+      break;
+    }
+    if (temp_length < max_length) {
+      hash0 = (hash0 * base) + data[temp_length];
+      hash1 = (hash1 - (data[temp_length] * power)) * base * base +
+              (data[2 * temp_length] * base) + data[2 * temp_length + 1];
+      power *= base;
+    }
+    temp_length++;
+  }
+  return length;
+}
+
+void CFG_COMPRESS::analyze_repeat(const uint8_t* input, const size_t input_size,
+                                  size_t index, size_t& length, size_t& repeat,
+                                  const bool hash_repeat_finder,
+                                  const uint8_t debug) {
+  length = 0;
+  repeat = 0;
+  size_t total_length = input_size - index;
+  if (total_length < (2 * CFG_CMP_MIN_REPEAT_LENGTH_SEARCH)) {
+    return;
+  }
+  if (hash_repeat_finder) {
+    length = analyze_repeat_length(input, input_size, index);
+  } else {
+    length = analyze_repeat_length_by_memcmp(input, input_size, index);
+  }
   if (length) {
     // We found repeated pattern
     size_t chunk0_start = index;
@@ -195,9 +260,7 @@ void CFG_COMPRESS::compress_repeat_chunk(const uint8_t* input,
         repeat, length, (repeat + 1) * new_length);
     flag = ((uint64_t)(new_length) << 4) | 0x08 | (uint64_t)(pattern);
     CFG_write_variable_u64(output, flag);
-    for (size_t i = 0; i < new_length; i++, index++) {
-      output.push_back(input[index]);
-    }
+    output.insert(output.end(), input + index, input + index + new_length);
   } else {
     if (pattern == CFG_CMP_NONE) {
       flag = ((uint64_t)(length) << 4) | 0x08 | (uint64_t)(pattern);
@@ -211,9 +274,7 @@ void CFG_COMPRESS::compress_repeat_chunk(const uint8_t* input,
       output.push_back(input[index + length - 1]);
     } else {
       CFG_ASSERT(pattern == CFG_CMP_NONE);
-      for (size_t i = 0; i < length; i++, index++) {
-        output.push_back(input[index]);
-      }
+      output.insert(output.end(), input + index, input + index + length);
     }
     CFG_write_variable_u64(output, (uint64_t)(repeat));
   }
@@ -228,10 +289,8 @@ void CFG_COMPRESS::pack_data(const uint8_t* input, const size_t input_size,
   }
   uint64_t flag = ((uint64_t)(length) << 4) | (uint64_t)(CFG_CMP_NONE);
   CFG_write_variable_u64(output, flag);
-  for (size_t i = 0; i < length; i++, index++) {
-    CFG_ASSERT(index < input_size);
-    output.push_back(input[index]);
-  }
+  CFG_ASSERT((index + length) <= input_size);
+  output.insert(output.end(), input + index, input + index + length);
 }
 
 size_t CFG_COMPRESS::compress_none_repeat(const uint8_t* input,
@@ -340,17 +399,19 @@ size_t CFG_COMPRESS::compress_none_repeat(const uint8_t* input,
   return end_index;
 }
 
-void CFG_COMPRESS::compress(const uint8_t* input, const size_t input_size,
-                            std::vector<uint8_t>& output, size_t* header_size,
-                            const bool support_followup_byte,
-                            const uint8_t debug) {
+void CFG_COMPRESS::compress_tokens(const uint8_t* input,
+                                   const size_t input_size,
+                                   std::vector<uint8_t>& output,
+                                   const bool support_followup_byte,
+                                   const bool hash_repeat_finder,
+                                   const uint8_t debug) {
   CFG_ASSERT(input != nullptr && input_size > 0);
-  std::vector<uint8_t> temp_output;
   size_t index = 0;
   while (index < input_size) {
     size_t length = 0;
     size_t repeat = 0;
-    analyze_repeat(input, input_size, index, length, repeat, debug);
+    analyze_repeat(input, input_size, index, length, repeat,
+                   hash_repeat_finder, debug);
     if (length) {
       CFG_ASSERT(repeat > 0);
       size_t chunk_pattern =
@@ -381,11 +442,11 @@ void CFG_COMPRESS::compress(const uint8_t* input, const size_t input_size,
             break;
           }
         }
-        compress_data(temp_output, compress_byte, length, followup_byte, debug,
+        compress_data(output, compress_byte, length, followup_byte, debug,
                       "   ");
       } else {
-        compress_repeat_chunk(input, input_size, temp_output, index,
-                              chunk_pattern, length, repeat);
+        compress_repeat_chunk(input, input_size, output, index, chunk_pattern,
+                              length, repeat);
         index += (length * (repeat + 1));
         CFG_ASSERT(index <= input_size);
         if (debug) {
@@ -394,11 +455,21 @@ void CFG_COMPRESS::compress(const uint8_t* input, const size_t input_size,
       }
     } else {
       CFG_ASSERT(repeat == 0);
-      index =
-          compress_none_repeat(input, input_size, temp_output, index, debug);
+      index = compress_none_repeat(input, input_size, output, index, debug);
     }
   }
   CFG_ASSERT(index == input_size);
+}
+
+void CFG_COMPRESS::compress(const uint8_t* input, const size_t input_size,
+                            std::vector<uint8_t>& output, size_t* header_size,
+                            const bool support_followup_byte,
+                            const uint8_t debug,
+                            const bool hash_repeat_finder) {
+  CFG_ASSERT(input != nullptr && input_size > 0);
+  std::vector<uint8_t> temp_output;
+  compress_tokens(input, input_size, temp_output, support_followup_byte,
+                  hash_repeat_finder, debug);
   // Finalize
   const std::vector<uint8_t> header = {'C', 'F', 'G', '_', 'C', 'M', 'P', 0};
   size_t original_output_size = output.size();
@@ -411,35 +482,78 @@ void CFG_COMPRESS::compress(const uint8_t* input, const size_t input_size,
   output.insert(output.end(), temp_output.begin(), temp_output.end());
 }
 
-void CFG_COMPRESS::decompress(const uint8_t* input, const size_t input_size,
-                              std::vector<uint8_t>& output,
-                              const uint8_t debug) {
-  CFG_ASSERT(input != nullptr && input_size > 10);
-  const std::vector<uint8_t> header = {'C', 'F', 'G', '_', 'C', 'M', 'P'};
-  CFG_ASSERT(memcmp(input, &header[0], 7) == 0);
-  uint8_t version = input[7];
-  CFG_ASSERT(version == 0);  // currently only support version 0
-  size_t index = 8;
-  size_t original_size = CFG_read_variable_u64(input, input_size, index);
-  size_t compress_size = CFG_read_variable_u64(input, input_size, index);
-  CFG_ASSERT(original_size > 0);
-  CFG_ASSERT(compress_size > 0);
-  CFG_ASSERT((index + compress_size) <= input_size);
-  // Do not use std::vector, so that firmware can implement the same
-  size_t output_original_size = output.size();
-  size_t end_index = index + compress_size;
+void CFG_COMPRESS::compress_segments(const uint8_t* input,
+                                     const size_t input_size,
+                                     std::vector<uint8_t>& output,
+                                     size_t* header_size, const bool retry,
+                                     const size_t segment_size,
+                                     uint32_t jobs) {
+  CFG_ASSERT(input != nullptr && input_size > 0);
+  CFG_ASSERT(segment_size > 0);
+  CFG_ASSERT((segment_size % CFG_CMP_SEGMENT_ALIGNMENT) == 0);
+  // Every segment is compressed on its own, a token never crosses a segment
+  // boundary, so the segments can be compressed by a pool of workers (jobs =
+  // 0 means one worker per CPU core)
+  size_t segment_count = (input_size + segment_size - 1) / segment_size;
+  std::vector<std::vector<uint8_t>> segments(segment_count);
+  auto compress_segment = [&](size_t i) {
+    const uint8_t* segment_input = &input[i * segment_size];
+    size_t segment_input_size =
+        std::min(segment_size, input_size - (i * segment_size));
+    compress_tokens(segment_input, segment_input_size, segments[i], true,
+                    true, 0);
+    if (retry) {
+      std::vector<uint8_t> temp;
+      compress_tokens(segment_input, segment_input_size, temp, false, true, 0);
+      if (segments[i].size() > temp.size()) {
+        segments[i].swap(temp);
+      }
+    }
+  };
+  CFG_parallel_for(segment_count, jobs, compress_segment);
+  // Finalize: compress size covers the segment size and all the segments,
+  // each one is prefixed by its own compress size
+  std::vector<uint8_t> sizes;
+  size_t compress_size = CFG_write_variable_u64(sizes, segment_size);
+  for (auto& segment : segments) {
+    CFG_ASSERT(segment.size());
+    compress_size +=
+        CFG_write_variable_u64(sizes, segment.size()) + segment.size();
+  }
+  const std::vector<uint8_t> header = {'C', 'F', 'G', '_', 'C', 'M', 'P', 1};
+  size_t original_output_size = output.size();
+  output.insert(output.end(), header.begin(), header.end());
+  CFG_write_variable_u64(output, (uint64_t)(input_size));
+  CFG_write_variable_u64(output, (uint64_t)(compress_size));
+  size_t compress_start = output.size();
+  CFG_write_variable_u64(output, (uint64_t)(segment_size));
+  if (header_size != nullptr) {
+    (*header_size) = output.size() - original_output_size;
+  }
+  output.reserve(compress_start + compress_size);
+  for (auto& segment : segments) {
+    CFG_write_variable_u64(output, (uint64_t)(segment.size()));
+    output.insert(output.end(), segment.begin(), segment.end());
+  }
+  CFG_ASSERT((output.size() - compress_start) == compress_size);
+}
+
+void CFG_COMPRESS::decompress_tokens(const uint8_t* input, size_t& index,
+                                     const size_t end_index, uint8_t* output,
+                                     size_t& output_index,
+                                     const size_t output_size) {
   while (index < end_index) {
     uint64_t flag = CFG_read_variable_u64(input, end_index, index);
     uint64_t pattern = flag & 0x7;
     uint64_t repeat = (flag & 0x8) != 0;
     size_t length = (size_t)(flag >> 4);
-    size_t temp_output_index = output.size();
+    size_t temp_output_index = output_index;
     if (pattern == CFG_CMP_NONE) {
-      for (uint64_t i = 0; i < length; i++) {
-        CFG_ASSERT(index < end_index);
-        output.push_back(input[index]);
-        index++;
-      }
+      CFG_ASSERT(length <= (end_index - index));
+      CFG_ASSERT(length <= (output_size - output_index));
+      memcpy(&output[output_index], &input[index], length);
+      index += length;
+      output_index += length;
     } else {
       uint8_t compress_byte = 0;
       if (pattern == CFG_CMP_VAR) {
@@ -452,15 +566,17 @@ void CFG_COMPRESS::decompress(const uint8_t* input, const size_t input_size,
       }
       if (pattern == CFG_CMP_VAR_ZERO || pattern == CFG_CMP_VAR_HIGH) {
         CFG_ASSERT(index < end_index);
-        output.push_back(input[index]);
+        CFG_ASSERT(output_index < output_size);
+        output[output_index++] = input[index];
         index++;
       }
-      for (size_t i = 0; i < length; i++) {
-        output.push_back(compress_byte);
-      }
+      CFG_ASSERT(length <= (output_size - output_index));
+      memset(&output[output_index], compress_byte, length);
+      output_index += length;
       if (pattern == CFG_CMP_ZERO_VAR || pattern == CFG_CMP_HIGH_VAR) {
         CFG_ASSERT(index < end_index);
-        output.push_back(input[index]);
+        CFG_ASSERT(output_index < output_size);
+        output[output_index++] = input[index];
         index++;
       }
       if (pattern == CFG_CMP_VAR_ZERO || pattern == CFG_CMP_VAR_HIGH ||
@@ -468,17 +584,102 @@ void CFG_COMPRESS::decompress(const uint8_t* input, const size_t input_size,
         length++;
       }
     }
-    CFG_ASSERT(length == (output.size() - temp_output_index));
+    CFG_ASSERT(length == (output_index - temp_output_index));
     if (repeat) {
       size_t repeat_size =
           (size_t)(CFG_read_variable_u64(input, end_index, index));
-      for (uint64_t i = 0; i < repeat_size; i++) {
-        output.insert(output.end(), output.begin() + temp_output_index,
-                      output.begin() + temp_output_index + length);
+      CFG_ASSERT(length == 0 ||
+                 repeat_size <= ((output_size - output_index) / length));
+      // Copy from the chunk and what had been repeated so far, the copy size
+      // doubles every time
+      size_t repeat_length = length * repeat_size;
+      size_t copied_length = 0;
+      while (copied_length < repeat_length) {
+        size_t copy_length = std::min(length + copied_length,
+                                      repeat_length - copied_length);
+        memcpy(&output[output_index + copied_length],
+               &output[temp_output_index], copy_length);
+        copied_length += copy_length;
       }
+      output_index += repeat_length;
     }
   }
   CFG_ASSERT(index == end_index);
-  size_t uncompress_size = output.size() - output_original_size;
-  CFG_ASSERT(uncompress_size == original_size);
-}
\ No newline at end of file
+}
+
+uint8_t CFG_COMPRESS::read_header(const uint8_t* input,
+                                  const size_t input_size, size_t& index,
+                                  size_t& original_size,
+                                  size_t& compress_size) {
+  CFG_ASSERT(input != nullptr && input_size > 10);
+  const std::vector<uint8_t> header = {'C', 'F', 'G', '_', 'C', 'M', 'P'};
+  CFG_ASSERT(memcmp(input, &header[0], 7) == 0);
+  uint8_t version = input[7];
+  CFG_ASSERT(version == 0 || version == 1);
+  index = 8;
+  original_size = CFG_read_variable_u64(input, input_size, index);
+  compress_size = CFG_read_variable_u64(input, input_size, index);
+  CFG_ASSERT(original_size > 0);
+  CFG_ASSERT(compress_size > 0);
+  CFG_ASSERT((index + compress_size) <= input_size);
+  return version;
+}
+
+size_t CFG_COMPRESS::get_original_size(const uint8_t* input,
+                                       const size_t input_size) {
+  size_t index = 0;
+  size_t original_size = 0;
+  size_t compress_size = 0;
+  read_header(input, input_size, index, original_size, compress_size);
+  return original_size;
+}
+
+void CFG_COMPRESS::decompress(const uint8_t* input, const size_t input_size,
+                              uint8_t* output, const size_t output_size,
+                              const uint8_t debug) {
+  size_t index = 0;
+  size_t original_size = 0;
+  size_t compress_size = 0;
+  uint8_t version =
+      read_header(input, input_size, index, original_size, compress_size);
+  CFG_ASSERT(output != nullptr);
+  CFG_ASSERT(output_size == original_size);
+  // Do not use std::vector, so that firmware can implement the same
+  size_t output_index = 0;
+  size_t end_index = index + compress_size;
+  if (version == 0) {
+    decompress_tokens(input, index, end_index, output, output_index,
+                      output_size);
+  } else {
+    // Version 1: every segment decompresses to segment size bytes (the last
+    // one may be shorter) and is prefixed by its own compress size
+    size_t segment_size = CFG_read_variable_u64(input, end_index, index);
+    CFG_ASSERT(segment_size > 0);
+    CFG_ASSERT((segment_size % CFG_CMP_SEGMENT_ALIGNMENT) == 0);
+    size_t segment_output_size = 0;
+    while (index < end_index) {
+      size_t segment_compress_size =
+          CFG_read_variable_u64(input, end_index, index);
+      CFG_ASSERT(segment_compress_size > 0);
+      CFG_ASSERT((index + segment_compress_size) <= end_index);
+      segment_output_size = output_index;
+      decompress_tokens(input, index, index + segment_compress_size, output,
+                        output_index, output_size);
+      segment_output_size = output_index - segment_output_size;
+      CFG_ASSERT(segment_output_size == segment_size ||
+                 (index == end_index && segment_output_size < segment_size));
+    }
+  }
+  CFG_ASSERT(index == end_index);
+  CFG_ASSERT(output_index == original_size);
+}
+
+void CFG_COMPRESS::decompress(const uint8_t* input, const size_t input_size,
+                              std::vector<uint8_t>& output,
+                              const uint8_t debug) {
+  // The header tells the exact size, output is only resized once
+  size_t output_original_size = output.size();
+  output.resize(output_original_size + get_original_size(input, input_size));
+  decompress(input, input_size, &output[output_original_size],
+             output.size() - output_original_size, debug);
+}
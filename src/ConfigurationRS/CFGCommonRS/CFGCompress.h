@@ -5,19 +5,52 @@
 #include <string>
 #include <vector>
 
+// Segments of a version 1 stream are multiple of 2KB
+#define CFG_CMP_SEGMENT_ALIGNMENT (2048)
+#define CFG_CMP_SEGMENT_SIZE (128 * CFG_CMP_SEGMENT_ALIGNMENT)
+
 class CFG_COMPRESS {
  public:
   static void compress(const uint8_t* input, const size_t input_size,
                        std::vector<uint8_t>& output,
                        size_t* header_size = nullptr,
                        const bool support_followup_byte = false,
-                       const uint8_t debug = 0);
+                       const uint8_t debug = 0,
+                       const bool hash_repeat_finder = true);
+  static void compress_segments(
+      const uint8_t* input, const size_t input_size,
+      std::vector<uint8_t>& output, size_t* header_size = nullptr,
+      const bool retry = true, const size_t segment_size = CFG_CMP_SEGMENT_SIZE,
+      uint32_t jobs = 0);
+  static size_t get_original_size(const uint8_t* input,
+                                  const size_t input_size);
+  static void decompress(const uint8_t* input, const size_t input_size,
+                         uint8_t* output, const size_t output_size,
+                         const uint8_t debug = 0);
   static void decompress(const uint8_t* input, const size_t input_size,
                          std::vector<uint8_t>& output, const uint8_t debug = 0);
 
  private:
+  static void compress_tokens(const uint8_t* input, const size_t input_size,
+                              std::vector<uint8_t>& output,
+                              const bool support_followup_byte,
+                              const bool hash_repeat_finder,
+                              const uint8_t debug);
+  static uint8_t read_header(const uint8_t* input, const size_t input_size,
+                             size_t& index, size_t& original_size,
+                             size_t& compress_size);
+  static void decompress_tokens(const uint8_t* input, size_t& index,
+                                const size_t end_index, uint8_t* output,
+                                size_t& output_index,
+                                const size_t output_size);
+  static size_t analyze_repeat_length(const uint8_t* input,
+                                      const size_t input_size, size_t index);
+  static size_t analyze_repeat_length_by_memcmp(const uint8_t* input,
+                                                const size_t input_size,
+                                                size_t index);
   static void analyze_repeat(const uint8_t* input, const size_t input_size,
                              size_t index, size_t& length, size_t& repeat,
+                             const bool hash_repeat_finder,
                              const uint8_t debug);
   static size_t analyze_chunk_pattern(const uint8_t* input,
                                       const size_t input_size, size_t index,
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 #include "CFGCommonRS.h"
+#include "CFGCompress.h"
 
 void test_case_compression(uint32_t& index, std::vector<uint8_t> input) {
   CFG_POST_MSG("********************** Test Case #%d **********************",
@@ -11,6 +16,11 @@ void test_case_compression(uint32_t& index, std::vector<uint8_t> input) {
   CFG_decompress(&output[0], output.size(), output_output, true);
   CFG_ASSERT(input.size() == output_output.size());
   CFG_ASSERT(memcmp(&input[0], &output_output[0], input.size()) == 0);
+  // straight into an exactly sized buffer
+  CFG_ASSERT(CFG_decompress_size(&output[0], output.size()) == input.size());
+  std::vector<uint8_t> buffer(input.size());
+  CFG_decompress(&output[0], output.size(), &buffer[0], buffer.size());
+  CFG_ASSERT(buffer == input);
   CFG_POST_MSG("!!! Result: Input (%ld) vs Output (%ld) [Header Size: %ld]",
                input.size(), output.size() - header_size, header_size);
   CFG_POST_MSG("***********************************************************");
@@ -47,6 +57,197 @@ void test_compression() {
       index, {1, 2, 3, 3, 4, 5, 6, 0, 0, 1, 2, 3, 4, 4, 5, 6, 6, 0, 0});
 }
 
+static std::vector<uint8_t> test_fcb_payload(size_t size) {
+  // mostly zero with sparse configuration bytes and some all-one bytes, like
+  // a fabric configuration payload
+  std::vector<uint8_t> data(size, 0);
+  uint32_t seed = 0x12345678;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1664525 + 1013904223;
+    if ((seed >> 24) < 16) {
+      data[i] = (uint8_t)(seed >> 8);
+    } else if ((seed >> 24) < 20) {
+      data[i] = 0xFF;
+    }
+  }
+  return data;
+}
+
+static void test_compress_two_passes(const std::vector<uint8_t>& input,
+                                     std::vector<uint8_t>& expected) {
+  // reference: both strategies one after the other, keep the smaller
+  std::vector<uint8_t> output0;
+  std::vector<uint8_t> output1;
+  CFG_COMPRESS::compress(&input[0], input.size(), output0, nullptr, true);
+  CFG_COMPRESS::compress(&input[0], input.size(), output1, nullptr, false);
+  expected = output0.size() > output1.size() ? output1 : output0;
+}
+
+void test_concurrent_compression() {
+  CFG_POST_MSG("Concurrent Compression Test");
+  // small inputs made of zero, all-one and random runs
+  uint32_t seed = 0x9E3779B9;
+  for (uint32_t i = 0; i < 1000; i++) {
+    std::vector<uint8_t> input;
+    while (input.size() < 256) {
+      seed = seed * 1664525 + 1013904223;
+      uint8_t type = (uint8_t)(seed >> 30);
+      size_t length = 1 + ((seed >> 16) & 0xF);
+      for (size_t j = 0; j < length; j++) {
+        seed = seed * 1664525 + 1013904223;
+        input.push_back(type == 0 ? 0 : (type == 1 ? 0xFF : (seed >> 24)));
+      }
+    }
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> output;
+    test_compress_two_passes(input, expected);
+    CFG_compress(&input[0], input.size(), output);
+    CFG_ASSERT(output == expected);
+  }
+}
+
+void test_compression_benchmark() {
+  CFG_POST_MSG("Compression Benchmark");
+  std::vector<uint8_t> input = test_fcb_payload(32 * 1024 * 1024);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> expected;
+  test_compress_two_passes(input, expected);
+  auto middle = std::chrono::steady_clock::now();
+  std::vector<uint8_t> output;
+  CFG_compress(&input[0], input.size(), output);
+  auto end = std::chrono::steady_clock::now();
+  CFG_ASSERT(output == expected);
+  double two_passes_time =
+      std::chrono::duration<double, std::milli>(middle - start).count();
+  double elapsed =
+      std::chrono::duration<double, std::milli>(end - middle).count();
+  CFG_POST_MSG("!!! Result: %ld MB compressed to %ld Bytes in %.3f ms "
+               "(two passes %.3f ms)",
+               input.size() / (1024 * 1024), output.size(), elapsed,
+               two_passes_time);
+}
+
+void test_segmented_compression() {
+  CFG_POST_MSG("Segmented Compression Test");
+  // multiple segments with a shorter last one, and a single partial segment
+  for (size_t size : {5 * 2048 + 100, 100}) {
+    std::vector<uint8_t> input = test_fcb_payload(size);
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> output_output;
+    size_t header_size = 0;
+    CFG_COMPRESS::compress_segments(&input[0], input.size(), output,
+                                    &header_size, true, 2048, 4);
+    CFG_ASSERT(output[7] == 1);
+    CFG_ASSERT(header_size < output.size());
+    CFG_decompress(&output[0], output.size(), output_output);
+    CFG_ASSERT(output_output == input);
+  }
+}
+
+void test_segmented_compression_benchmark() {
+  CFG_POST_MSG("Segmented Compression Benchmark");
+  std::vector<uint8_t> input = test_fcb_payload(32 * 1024 * 1024);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> output0;
+  CFG_compress(&input[0], input.size(), output0);
+  auto middle = std::chrono::steady_clock::now();
+  std::vector<uint8_t> output1;
+  CFG_compress(&input[0], input.size(), output1, nullptr, false, true, 1);
+  auto end = std::chrono::steady_clock::now();
+  CFG_ASSERT(output0[7] == 0);
+  CFG_ASSERT(output1[7] == 1);
+  std::vector<uint8_t> output_output;
+  CFG_decompress(&output1[0], output1.size(), output_output);
+  CFG_ASSERT(output_output == input);
+  double version0_time =
+      std::chrono::duration<double, std::milli>(middle - start).count();
+  double version1_time =
+      std::chrono::duration<double, std::milli>(end - middle).count();
+  CFG_POST_MSG("!!! Result: %ld MB compressed to %ld Bytes in %.3f ms "
+               "(version 0: %ld Bytes in %.3f ms)",
+               input.size() / (1024 * 1024), output1.size(), version1_time,
+               output0.size(), version0_time);
+}
+
+static double test_compress_time(const std::vector<uint8_t>& input,
+                                 std::vector<uint8_t>& output,
+                                 bool hash_repeat_finder) {
+  auto start = std::chrono::steady_clock::now();
+  CFG_COMPRESS::compress(&input[0], input.size(), output, nullptr, true, 0,
+                         hash_repeat_finder);
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void test_repeat_finder() {
+  CFG_POST_MSG("Repeat Finder Test");
+  // short periodic chunks mixed with runs around the same-byte limit and
+  // random bytes, both finders must give the same stream
+  uint32_t seed = 0xC0FFEE11;
+  for (uint32_t i = 0; i < 500; i++) {
+    std::vector<uint8_t> input;
+    while (input.size() < 1024) {
+      seed = seed * 1664525 + 1013904223;
+      uint32_t type = seed >> 30;
+      size_t length = 1 + ((seed >> 8) & 0x7F);
+      if (type == 0) {
+        input.insert(input.end(), length, (seed & 1) ? 0xFF : 0);
+      } else if (type == 1) {
+        size_t period = 1 + ((seed >> 16) % 60);
+        size_t start = input.size();
+        for (size_t j = 0; j < length + period; j++) {
+          seed = seed * 1664525 + 1013904223;
+          input.push_back(j < period ? (uint8_t)(seed >> 24)
+                                     : input[start + j - period]);
+        }
+      } else {
+        for (size_t j = 0; j < length; j++) {
+          seed = seed * 1664525 + 1013904223;
+          input.push_back((uint8_t)(seed >> 24));
+        }
+      }
+    }
+    for (bool followup : {true, false}) {
+      std::vector<uint8_t> expected;
+      std::vector<uint8_t> output;
+      CFG_COMPRESS::compress(&input[0], input.size(), expected, nullptr,
+                             followup, 0, false);
+      CFG_COMPRESS::compress(&input[0], input.size(), output, nullptr,
+                             followup, 0, true);
+      CFG_ASSERT(output == expected);
+    }
+  }
+}
+
+void test_repeat_finder_benchmark() {
+  CFG_POST_MSG("Repeat Finder Benchmark");
+  uint32_t seed = 0xC0FFEE11;
+  const size_t size = 8 * 1024 * 1024;
+  std::vector<uint8_t> random(size);
+  std::vector<uint8_t> zero(size, 0);
+  std::vector<uint8_t> periodic(size);
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1664525 + 1013904223;
+    random[i] = (uint8_t)(seed >> 24);
+    // period of 37 bytes (8 data bytes and zeros) with a change every 4KB
+    periodic[i] = (i % 37) < 8 ? (uint8_t)((i % 37) + 1 + (i >> 12)) : 0;
+  }
+  for (auto& data : {std::make_pair("random", &random),
+                     std::make_pair("all-zero", &zero),
+                     std::make_pair("periodic", &periodic)}) {
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> output;
+    double memcmp_time = test_compress_time(*data.second, expected, false);
+    double hash_time = test_compress_time(*data.second, output, true);
+    CFG_ASSERT(output == expected);
+    CFG_POST_MSG("!!! Result: %ld MB %s data compressed to %ld Bytes in %.3f "
+                 "ms (memcmp finder %.3f ms)",
+                 size / (1024 * 1024), data.first, output.size(), hash_time,
+                 memcmp_time);
+  }
+}
+
 void test_crc() {
   CFG_POST_MSG("CRC Test");
   uint16_t expected_crc16 = 0xA161;
@@ -59,9 +260,223 @@ void test_crc() {
   CFG_ASSERT(crc16 == expected_crc16);
 }
 
+// Reference CRC: reflected table generated from the polynomial, one byte at
+// a time
+template <typename T>
+static void test_crc_table(T poly, T* table) {
+  for (uint32_t i = 0; i < 256; i++) {
+    T crc = (T)(i);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (T)((crc >> 1) ^ poly) : (T)(crc >> 1);
+    }
+    table[i] = crc;
+  }
+}
+
+template <typename T>
+static T test_crc_by_byte(const uint8_t* addr, size_t size, T crc,
+                          bool final_xor, const T* table) {
+  for (size_t i = 0; i < size; i++) {
+    crc = table[uint8_t(crc) ^ addr[i]] ^ (T)(crc >> 8);
+  }
+  return final_xor ? (T)(~crc) : crc;
+}
+
+void test_crc_equivalence() {
+  CFG_POST_MSG("CRC Equivalence Test");
+  uint16_t table_8408[256];
+  uint16_t table_a001[256];
+  uint32_t table_04c11db7[256];
+  uint32_t table_custom[256];
+  test_crc_table<uint16_t>(0x8408, table_8408);
+  test_crc_table<uint16_t>(0xA001, table_a001);
+  test_crc_table<uint32_t>(0x04C11DB7, table_04c11db7);
+  // Not linear, must still be used as it is
+  for (uint32_t i = 0; i < 256; i++) {
+    table_custom[i] = i * 0x9E3779B9 + 0x7F4A7C15;
+  }
+  std::vector<uint8_t> data(5000);
+  uint32_t seed = 0x12345678;
+  for (auto& d : data) {
+    seed = seed * 1664525 + 1013904223;
+    d = uint8_t(seed >> 24);
+  }
+  for (size_t size = 1; size < 300; size++) {
+    for (size_t offset : {0, 1, 3, 7, 1000}) {
+      const uint8_t* addr = &data[offset];
+      for (uint32_t init : {0x00000000U, 0xFFFFFFFFU, 0x1D0F5A3CU}) {
+        for (bool final_xor : {false, true}) {
+          uint16_t init16 = uint16_t(init);
+          CFG_ASSERT(CFG_crc16(addr, size, init16, final_xor) ==
+                     test_crc_by_byte(addr, size, init16, final_xor,
+                                      table_8408));
+          CFG_ASSERT(CFG_bop_A001_crc16(addr, size, init16, final_xor) ==
+                     test_crc_by_byte(addr, size, init16, final_xor,
+                                      table_a001));
+          CFG_ASSERT(CFG_crc32(addr, size, init, final_xor) ==
+                     test_crc_by_byte(addr, size, init, final_xor,
+                                      table_04c11db7));
+          CFG_ASSERT(CFG_crc32(addr, size, init, final_xor, table_custom) ==
+                     test_crc_by_byte(addr, size, init, final_xor,
+                                      table_custom));
+        }
+      }
+    }
+  }
+  // Big buffer in one call or in pieces (running CRC)
+  uint32_t crc32 = test_crc_by_byte(&data[0], data.size(), 0xFFFFFFFFU, true,
+                                    table_04c11db7);
+  CFG_ASSERT(CFG_crc32(&data[0], data.size()) == crc32);
+  uint32_t running = CFG_crc32(&data[0], 1234, 0xFFFFFFFF, false);
+  running = CFG_crc32(&data[1234], data.size() - 1234, running, true);
+  CFG_ASSERT(running == crc32);
+  uint16_t crc16 =
+      test_crc_by_byte(&data[0], data.size(), uint16_t(0), false, table_a001);
+  CFG_ASSERT(CFG_bop_A001_crc16(&data[0], data.size()) == crc16);
+}
+
+void test_crc_benchmark() {
+  CFG_POST_MSG("CRC Benchmark");
+  uint16_t table_a001[256];
+  uint32_t table_04c11db7[256];
+  test_crc_table<uint16_t>(0xA001, table_a001);
+  test_crc_table<uint32_t>(0x04C11DB7, table_04c11db7);
+  std::vector<uint8_t> data(64 * 1024 * 1024);
+  uint32_t seed = 0x87654321;
+  for (auto& d : data) {
+    seed = seed * 1664525 + 1013904223;
+    d = uint8_t(seed >> 24);
+  }
+  // Whole buffer and BOP sized (0x7FC) chunks
+  for (size_t chunk : {data.size(), (size_t)(0x7FC)}) {
+    uint32_t ref32 = 0;
+    uint32_t crc32 = 0;
+    uint16_t ref16 = 0;
+    uint16_t crc16 = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + chunk <= data.size(); i += chunk) {
+      ref32 ^= test_crc_by_byte(&data[i], chunk, 0xFFFFFFFFU, true,
+                                table_04c11db7);
+    }
+    auto ref32_end = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + chunk <= data.size(); i += chunk) {
+      crc32 ^= CFG_crc32(&data[i], chunk);
+    }
+    auto crc32_end = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + chunk <= data.size(); i += chunk) {
+      ref16 ^= test_crc_by_byte(&data[i], chunk, uint16_t(0), false,
+                                table_a001);
+    }
+    auto ref16_end = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + chunk <= data.size(); i += chunk) {
+      crc16 ^= CFG_bop_A001_crc16(&data[i], chunk);
+    }
+    auto crc16_end = std::chrono::steady_clock::now();
+    CFG_ASSERT(crc32 == ref32);
+    CFG_ASSERT(crc16 == ref16);
+    CFG_POST_MSG(
+        "!!! Result: %ld MB in %ld Bytes chunk: CRC32 %.3f ms (by byte %.3f "
+        "ms), CRC16 %.3f ms (by byte %.3f ms)",
+        data.size() / (1024 * 1024), chunk,
+        std::chrono::duration<double, std::milli>(crc32_end - ref32_end)
+            .count(),
+        std::chrono::duration<double, std::milli>(ref32_end - start).count(),
+        std::chrono::duration<double, std::milli>(crc16_end - ref16_end)
+            .count(),
+        std::chrono::duration<double, std::milli>(ref16_end - crc32_end)
+            .count());
+  }
+}
+
+void test_mmap_file() {
+  CFG_POST_MSG("Memory Map File Test");
+  std::vector<uint8_t> data(3 * 4096 + 100);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = uint8_t(i * 7);
+  }
+  std::string filepath = "cfgcommonrs_mmap_test.bin";
+  CFG_write_binary_file(filepath, &data[0], data.size());
+  {
+    CFG_MMAP_FILE file(filepath);
+    CFG_ASSERT(file.is_open());
+    CFG_ASSERT(file.size() == data.size());
+    CFG_ASSERT(memcmp(file.data(), &data[0], data.size()) == 0);
+    // released pages are read back from the file
+    file.release(0, data.size());
+    CFG_ASSERT(memcmp(file.data(), &data[0], data.size()) == 0);
+  }
+  std::remove(filepath.c_str());
+  CFG_MMAP_FILE missing_file("cfgcommonrs_mmap_test_missing.bin");
+  CFG_ASSERT(!missing_file.is_open());
+  CFG_ASSERT(missing_file.size() == 0);
+}
+
+void test_parallel_for() {
+  CFG_POST_MSG("Parallel For Test");
+  const size_t count = 1000;
+  for (uint32_t jobs : {0, 1, 3, 2000}) {
+    // Every index is run exactly once
+    std::vector<std::atomic<uint32_t>> runs(count);
+    CFG_parallel_for(count, jobs, [&](size_t i) { runs[i]++; });
+    for (auto& run : runs) {
+      CFG_ASSERT(run == 1);
+    }
+    // In parallel other indexes still run, the exception is raised after the
+    // join (jobs 0 may mean a single worker)
+    std::atomic<size_t> total(0);
+    bool caught = false;
+    try {
+      CFG_parallel_for(count, jobs, [&](size_t i) {
+        total++;
+        CFG_ASSERT(i != 500);
+      });
+    } catch (const std::exception&) {
+      caught = true;
+    }
+    CFG_ASSERT(caught);
+    CFG_ASSERT(jobs <= 1 || total == count);
+  }
+  CFG_parallel_for(0, 0, [](size_t) { CFG_INTERNAL_ERROR("Unexpected"); });
+}
+
+void test_unique_nano_time() {
+  CFG_POST_MSG("Unique Nano Time Test");
+  // No two callers get the same time, even from different threads
+  const size_t count = 4 * 10000;
+  std::vector<uint64_t> times(count);
+  CFG_parallel_for(4, 4, [&](size_t i) {
+    for (size_t j = i; j < count; j += 4) {
+      times[j] = CFG_get_unique_nano_time();
+    }
+  });
+  std::sort(times.begin(), times.end());
+  CFG_ASSERT(std::adjacent_find(times.begin(), times.end()) == times.end());
+}
+
 int main(int argc, const char** argv) {
   CFG_POST_MSG("This is CFGCommon unit test");
+  // Benchmarks only run on request: cfgcommonrs_test --benchmark
+  bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
   test_compression();
+  test_concurrent_compression();
+  if (benchmark) {
+    test_compression_benchmark();
+  }
+  test_segmented_compression();
+  if (benchmark) {
+    test_segmented_compression_benchmark();
+  }
+  test_repeat_finder();
+  if (benchmark) {
+    test_repeat_finder_benchmark();
+  }
   test_crc();
+  test_crc_equivalence();
+  if (benchmark) {
+    test_crc_benchmark();
+  }
+  test_mmap_file();
+  test_parallel_for();
+  test_unique_nano_time();
   return 0;
 }
@@ -1,5 +1,6 @@
 #include "CFGOpenSSL.h"
 
+#include <algorithm>
 #include <fstream>
 #include <streambuf>
 #include <string>
@@ -202,56 +203,81 @@ void CFGOpenSSL::ctr_encrypt(const uint8_t* plain_data, uint8_t* cipher_data,
   CFG_ASSERT(key_size == 16 || key_size == 32);
   CFG_ASSERT(iv != nullptr);
   CFG_ASSERT(iv_size == 16);
-  init_openssl();
-
-  // encrypt
-#if APP_USE_1_1_x_OPENSSL
-  AES_KEY aes_key;
-  unsigned char ecount_buf[16] = {0};
-  unsigned char internal_iv[16] = {0};
-  unsigned int aes_num(0);
-  CFG_ASSERT(sizeof(internal_iv) == iv_size);
-  memcpy(internal_iv, iv, sizeof(internal_iv));
-  CFG_ASSERT(AES_set_encrypt_key(key, key_size * 8, &aes_key) == 0);
-  CRYPTO_ctr128_encrypt(plain_data, cipher_data, data_size, &aes_key,
-                        internal_iv, ecount_buf, &aes_num,
-                        (block128_f)AES_encrypt);
+  CFGOpenSSL_CTR ctr(key, key_size);
+  ctr.set_iv(iv, iv_size);
+  ctr.process(plain_data, cipher_data, data_size);
   if (returned_iv != nullptr) {
-    memcpy(returned_iv, internal_iv, iv_size);
+    ctr.get_iv(returned_iv, iv_size);
   }
-  memset(internal_iv, 0, sizeof(internal_iv));
-#else
-  // This piece of code is written (and tested working) which is compatible
-  // with 3.0
+}
+
+CFGOpenSSL_CTR::CFGOpenSSL_CTR(const uint8_t* key, size_t key_size) {
+  CFG_ASSERT(key != nullptr);
+  CFG_ASSERT(key_size == 16 || key_size == 32);
+  CFGOpenSSL::init_openssl();
   EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
   CFG_ASSERT(ctx != nullptr);
-  unsigned char internal_iv[16] = {0};
-  CFG_ASSERT(sizeof(internal_iv) == iv_size);
-  memcpy(internal_iv, iv, sizeof(internal_iv));
-  // Init
+  // Key schedule is only done here
   if (key_size == 16) {
-    CFG_ASSERT(EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, key, iv));
+    CFG_ASSERT(EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, key, NULL));
   } else {
-    CFG_ASSERT(EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv));
-  }
-  // Update (should be able to check overflow if the data_size is too big
-  int cipher_data_size = 0;
-  CFG_ASSERT(EVP_EncryptUpdate(ctx, cipher_data, &cipher_data_size, plain_data,
-                               int(data_size)));
-  CFG_ASSERT((size_t)(cipher_data_size) == data_size);
-  // Finalize
-  // Pernally do not think CTR has any final size (unlike GCM)
-  // Hence make sure final_data_size == 0
-  int final_data_size = 0;
-  unsigned char final_dummy[128] = {0};
-  CFG_ASSERT(EVP_EncryptFinal_ex(ctx, final_dummy, &final_data_size));
-  CFG_ASSERT(final_data_size == 0);
-  if (returned_iv != nullptr) {
-    memcpy(returned_iv, internal_iv, iv_size);
+    CFG_ASSERT(EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, NULL));
+  }
+  m_ctx = ctx;
+}
+
+CFGOpenSSL_CTR::~CFGOpenSSL_CTR() {
+  EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)(m_ctx));
+  memset(m_iv, 0, sizeof(m_iv));
+}
+
+void CFGOpenSSL_CTR::set_iv(const uint8_t* iv, size_t iv_size) {
+  CFG_ASSERT(iv != nullptr);
+  CFG_ASSERT(iv_size == sizeof(m_iv));
+  if (m_has_iv && m_offset == 0 && memcmp(m_iv, iv, sizeof(m_iv)) == 0) {
+    return;
+  }
+  // Key is kept, only the IV is changed
+  CFG_ASSERT(
+      EVP_EncryptInit_ex((EVP_CIPHER_CTX*)(m_ctx), NULL, NULL, NULL, iv));
+  memcpy(m_iv, iv, sizeof(m_iv));
+  m_has_iv = true;
+  m_offset = 0;
+}
+
+void CFGOpenSSL_CTR::get_iv(uint8_t* iv, size_t iv_size) const {
+  CFG_ASSERT(m_has_iv);
+  CFG_ASSERT(iv != nullptr);
+  CFG_ASSERT(iv_size == sizeof(m_iv));
+  memcpy(iv, m_iv, sizeof(m_iv));
+}
+
+void CFGOpenSSL_CTR::process(const uint8_t* input, uint8_t* output,
+                             size_t size) {
+  CFG_ASSERT(m_has_iv);
+  CFG_ASSERT(input != nullptr);
+  CFG_ASSERT(output != nullptr);
+  CFG_ASSERT(size > 0);
+  // Track the counter (128 bits big endian) of the next keystream block
+  uint64_t blocks = (uint64_t)((m_offset + size + 15) / 16) -
+                    (uint64_t)((m_offset + 15) / 16);
+  m_offset = (m_offset + size) % 16;
+  for (int i = 15; i >= 0 && blocks; i--) {
+    blocks += m_iv[i];
+    m_iv[i] = (uint8_t)(blocks);
+    blocks >>= 8;
+  }
+  // EVP takes int size
+  while (size) {
+    int chunk = (int)(std::min(size, (size_t)(1 << 30)));
+    int output_size = 0;
+    CFG_ASSERT(EVP_EncryptUpdate((EVP_CIPHER_CTX*)(m_ctx), output,
+                                 &output_size, input, chunk));
+    CFG_ASSERT(output_size == chunk);
+    input += chunk;
+    output += chunk;
+    size -= chunk;
   }
-  memset(internal_iv, 0, sizeof(internal_iv));
-  EVP_CIPHER_CTX_free(ctx);
-#endif
 }
 
 void CFGOpenSSL::gen_private_pem(const std::string& key_type,
@@ -29,6 +29,29 @@ struct CFGOpenSSL_KEY_INFO {
 
 class CFGCrypto_KEY;
 
+// AES-CTR session. It is keyed once, then encrypts (or decrypts, which is the
+// same operation) a stream of data through EVP. The running IV is the counter
+// of the next unused keystream block, same as returned_iv of ctr_encrypt()
+class CFGOpenSSL_CTR {
+ public:
+  CFGOpenSSL_CTR(const uint8_t* key, size_t key_size);
+  ~CFGOpenSSL_CTR();
+  // Restart the stream, nothing is done if it continues the running IV
+  void set_iv(const uint8_t* iv, size_t iv_size);
+  void get_iv(uint8_t* iv, size_t iv_size) const;
+  // input and output can be the same buffer
+  void process(const uint8_t* input, uint8_t* output, size_t size);
+
+ private:
+  CFGOpenSSL_CTR(const CFGOpenSSL_CTR&) = delete;
+  CFGOpenSSL_CTR& operator=(const CFGOpenSSL_CTR&) = delete;
+  void* m_ctx = nullptr;
+  uint8_t m_iv[16] = {0};
+  bool m_has_iv = false;
+  // Bytes used of the last keystream block
+  size_t m_offset = 0;
+};
+
 class CFGOpenSSL {
  public:
   static void init_openssl();
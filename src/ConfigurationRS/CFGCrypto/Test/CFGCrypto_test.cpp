@@ -1,3 +1,5 @@
+#include <chrono>
+
 #include "CFGCommonRS/CFGCommonRS.h"
 #include "CFGCrypto_key.h"
 #include "CFGOpenSSL.h"
@@ -104,10 +106,109 @@ void test_signing() {
   }
 }
 
+void test_ctr_session() {
+  CFG_POST_MSG("CTR Session Test");
+  std::vector<uint8_t> data(5000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i * 13 + (i >> 8));
+  }
+  for (size_t key_size : {16, 32}) {
+    std::vector<uint8_t> key(key_size);
+    CFGOpenSSL::generate_random_data(&key[0], key.size());
+    // Counter carry into the upper bytes of the IV
+    std::vector<uint8_t> iv(16, 0xFF);
+    iv[0] = 0x5A;
+    std::vector<uint8_t> expected(data.size());
+    std::vector<uint8_t> expected_iv(16);
+    CFGOpenSSL::ctr_encrypt(&data[0], &expected[0], data.size(), &key[0],
+                            key.size(), &iv[0], iv.size(), &expected_iv[0]);
+    // Stream it in odd sized pieces, in place
+    CFGOpenSSL_CTR ctr(&key[0], key.size());
+    std::vector<uint8_t> cipher = data;
+    ctr.set_iv(&iv[0], iv.size());
+    for (size_t i = 0, size = 1; i < cipher.size(); i += size, size += 7) {
+      size = std::min(size, cipher.size() - i);
+      ctr.process(&cipher[i], &cipher[i], size);
+    }
+    std::vector<uint8_t> running_iv(16);
+    ctr.get_iv(&running_iv[0], running_iv.size());
+    CFG_ASSERT(cipher == expected);
+    CFG_ASSERT(running_iv == expected_iv);
+    // Block by block like the analyzer, IV is carried from block to block
+    std::vector<uint8_t> plain(data.size());
+    std::vector<uint8_t> block_iv = iv;
+    for (size_t i = 0; i < cipher.size(); i += 2048) {
+      size_t size = std::min((size_t)(2048), cipher.size() - i);
+      ctr.set_iv(&block_iv[0], block_iv.size());
+      ctr.process(&cipher[i], &plain[i], size);
+      ctr.get_iv(&block_iv[0], block_iv.size());
+    }
+    CFG_ASSERT(plain == data);
+    CFG_ASSERT(block_iv == expected_iv);
+  }
+}
+
+void test_ctr_session_benchmark() {
+  CFG_POST_MSG("CTR Session Benchmark");
+  const size_t data_size = 256 * 1024 * 1024;
+  const size_t block_size = 2048;
+  std::vector<uint8_t> data(data_size);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i ^ (i >> 13));
+  }
+  std::vector<uint8_t> key(32);
+  std::vector<uint8_t> iv(16);
+  CFGOpenSSL::generate_random_data(&key[0], key.size());
+  CFGOpenSSL::generate_random_data(&iv[0], iv.size());
+  std::vector<uint8_t> running_iv(16);
+  // Session: keyed once, encrypt then decrypt in place
+  auto start = std::chrono::steady_clock::now();
+  CFGOpenSSL_CTR ctr(&key[0], key.size());
+  ctr.set_iv(&iv[0], iv.size());
+  ctr.process(&data[0], &data[0], data.size());
+  double encrypt_time = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  start = std::chrono::steady_clock::now();
+  memcpy(&running_iv[0], &iv[0], iv.size());
+  for (size_t i = 0; i < data.size(); i += block_size) {
+    ctr.set_iv(&running_iv[0], running_iv.size());
+    ctr.process(&data[i], &data[i], block_size);
+    ctr.get_iv(&running_iv[0], running_iv.size());
+  }
+  double decrypt_time = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  for (size_t i = 0; i < data.size(); i++) {
+    CFG_ASSERT(data[i] == (uint8_t)(i ^ (i >> 13)));
+  }
+  // One shot per block, keyed on every call
+  start = std::chrono::steady_clock::now();
+  memcpy(&running_iv[0], &iv[0], iv.size());
+  for (size_t i = 0; i < data.size(); i += block_size) {
+    CFGOpenSSL::ctr_decrypt(&data[i], &data[i], block_size, &key[0],
+                            key.size(), &running_iv[0], running_iv.size(),
+                            &running_iv[0]);
+  }
+  double one_shot_time = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  CFG_POST_MSG("!!! Result: %ld MB encrypted in %.3f ms, decrypted per %ld "
+               "bytes block in %.3f ms (one shot per block %.3f ms)",
+               data_size / (1024 * 1024), encrypt_time, block_size,
+               decrypt_time, one_shot_time);
+}
+
 int main(int argc, const char** argv) {
   CFG_POST_MSG("This is CFGOpenSSL unit test");
+  // Benchmarks only run on request: cfgcrypto_test --benchmark
+  bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
   test_sha();
   test_encryption();
+  test_ctr_session();
+  if (benchmark) {
+    test_ctr_session_benchmark();
+  }
   test_signing();
   return 0;
 }
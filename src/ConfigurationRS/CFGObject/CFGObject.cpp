@@ -1,145 +1,232 @@
 #include "CFGObject_auto.h"
 
+#include <filesystem>
+
 #define OPTIMIZE_DATA_LENGTH
 
+// Writer
+CFGObject_WRITER::CFGObject_WRITER(const std::string& filepath,
+                                   const uint8_t compress_version)
+    : m_filepath(filepath),
+      m_temp_filepath(filepath + ".tmp"),
+      m_compress_version(compress_version) {
+  m_file.open(m_temp_filepath.c_str(), std::ios::in | std::ios::out |
+                                           std::ios::trunc | std::ios::binary);
+  CFG_ASSERT_MSG(m_file.is_open(), "Fail to open file %s for writing",
+                 m_temp_filepath.c_str());
+}
+
+CFGObject_WRITER::~CFGObject_WRITER() {
+  if (m_file.is_open()) {
+    // Not closed, serialization failed halfway. Drop the partial file and
+    // leave the target untouched
+    m_file.close();
+    std::remove(m_temp_filepath.c_str());
+  }
+}
+
+void CFGObject_WRITER::flush(bool force) {
+  if (m_buffer.size() && (force || m_buffer.size() >= CFGOBJECT_WRITER_SIZE)) {
+    write_file(&m_buffer[0], m_buffer.size());
+    m_buffer.clear();
+  }
+}
+
+void CFGObject_WRITER::write(const uint8_t* data, size_t size) {
+  flush(true);
+  if (size) {
+    write_file(data, size);
+  }
+}
+
+void CFGObject_WRITER::patch(size_t offset, const std::vector<uint8_t>& data) {
+  CFG_ASSERT(data.size() && (offset + data.size()) <= size());
+  flush(true);
+  m_file.seekp(offset);
+  m_file.write(reinterpret_cast<const char*>(&data[0]), data.size());
+  m_file.seekp(0, std::ios::end);
+  CFG_ASSERT(m_file.good());
+  m_patched = true;
+}
+
+void CFGObject_WRITER::close() {
+  flush(true);
+  if (m_patched) {
+    // Running CRC is outdated, read back the file to calculate it again
+    std::vector<uint8_t> chunk(CFGOBJECT_WRITER_SIZE);
+    m_crc = 0xFFFF;
+    m_file.seekg(0);
+    size_t index = 0;
+    while (index < m_size) {
+      size_t size = std::min(chunk.size(), m_size - index);
+      m_file.read(reinterpret_cast<char*>(&chunk[0]), size);
+      CFG_ASSERT(m_file.good());
+      m_crc = CFG_crc16(&chunk[0], size, m_crc, false);
+      index += size;
+    }
+    m_file.seekp(0, std::ios::end);
+  }
+  uint16_t crc = m_crc ^ 0xFFFF;
+  uint8_t crc_bytes[2] = {(uint8_t)(crc & 0xFF), (uint8_t)((crc >> 8) & 0xFF)};
+  m_file.write(reinterpret_cast<const char*>(crc_bytes), sizeof(crc_bytes));
+  CFG_ASSERT(m_file.good());
+  m_file.close();
+  // The target only ever holds a complete file
+  std::error_code ec;
+  std::filesystem::rename(m_temp_filepath, m_filepath, ec);
+  if (ec) {
+    std::remove(m_temp_filepath.c_str());
+    CFG_INTERNAL_ERROR("Fail to rename file %s to %s: %s",
+                       m_temp_filepath.c_str(), m_filepath.c_str(),
+                       ec.message().c_str());
+  }
+}
+
+void CFGObject_WRITER::write_file(const uint8_t* data, size_t size) {
+  m_file.write(reinterpret_cast<const char*>(data), size);
+  CFG_ASSERT(m_file.good());
+  m_crc = CFG_crc16(data, size, m_crc, false);
+  m_size += size;
+}
+
 // Public functions
 std::string CFGObject::get_name() const { return name; }
 
 void CFGObject::write_bool(const std::string& name, bool value) const {
-  write_data(name, "bool", value);
+  write_data(name, CFGObject_BOOL_TYPE, value);
 }
 
 void CFGObject::write_u8(const std::string& name, uint8_t value) const {
-  write_data(name, "u8", value);
+  write_data(name, CFGObject_U8_TYPE, value);
 }
 
 void CFGObject::write_u16(const std::string& name, uint16_t value) const {
-  write_data(name, "u16", value);
+  write_data(name, CFGObject_U16_TYPE, value);
 }
 
 void CFGObject::write_u32(const std::string& name, uint32_t value) const {
-  write_data(name, "u32", value);
+  write_data(name, CFGObject_U32_TYPE, value);
 }
 
 void CFGObject::write_u64(const std::string& name, uint64_t value) const {
-  write_data(name, "u64", value);
+  write_data(name, CFGObject_U64_TYPE, value);
 }
 
 void CFGObject::write_i32(const std::string& name, int32_t value) const {
-  write_data(name, "i32", value);
+  write_data(name, CFGObject_I32_TYPE, value);
 }
 
 void CFGObject::write_i64(const std::string& name, int64_t value) const {
-  write_data(name, "i64", value);
+  write_data(name, CFGObject_I64_TYPE, value);
 }
 
 void CFGObject::write_u8s(const std::string& name,
                           std::vector<uint8_t> value) const {
-  write_data(name, "u8s", value);
+  write_data(name, CFGObject_U8S_TYPE, value);
 }
 
 void CFGObject::write_u16s(const std::string& name,
                            std::vector<uint16_t> value) const {
-  write_data(name, "u16s", value);
+  write_data(name, CFGObject_U16S_TYPE, value);
 }
 
 void CFGObject::write_u32s(const std::string& name,
                            std::vector<uint32_t> value) const {
-  write_data(name, "u32s", value);
+  write_data(name, CFGObject_U32S_TYPE, value);
 }
 
 void CFGObject::write_u64s(const std::string& name,
                            std::vector<uint64_t> value) const {
-  write_data(name, "u64s", value);
+  write_data(name, CFGObject_U64S_TYPE, value);
 }
 
 void CFGObject::write_i32s(const std::string& name,
                            std::vector<int32_t> value) const {
-  write_data(name, "i32s", value);
+  write_data(name, CFGObject_I32S_TYPE, value);
 }
 
 void CFGObject::write_i64s(const std::string& name,
                            std::vector<int64_t> value) const {
-  write_data(name, "i64s", value);
+  write_data(name, CFGObject_I64S_TYPE, value);
 }
 
 void CFGObject::write_str(const std::string& name,
                           const std::string& value) const {
-  write_data(name, "str", value);
+  write_data(name, CFGObject_STR_TYPE, value);
 }
 
 void CFGObject::write_strs(const std::string& name,
                            std::vector<std::string> value) const {
-  write_data(name, "strs", value);
+  write_data(name, CFGObject_STRS_TYPE, value);
 }
 
 void CFGObject::append_u8s(const std::string& name,
                            std::vector<uint8_t> value) const {
-  append_datas(name, "u8s", value);
+  append_datas(name, CFGObject_U8S_TYPE, value);
 }
 
 void CFGObject::append_u16s(const std::string& name,
                             std::vector<uint16_t> value) const {
-  append_datas(name, "u16s", value);
+  append_datas(name, CFGObject_U16S_TYPE, value);
 }
 
 void CFGObject::append_u32s(const std::string& name,
                             std::vector<uint32_t> value) const {
-  append_datas(name, "u32s", value);
+  append_datas(name, CFGObject_U32S_TYPE, value);
 }
 
 void CFGObject::append_u64s(const std::string& name,
                             std::vector<uint64_t> value) const {
-  append_datas(name, "u64s", value);
+  append_datas(name, CFGObject_U64S_TYPE, value);
 }
 
 void CFGObject::append_i32s(const std::string& name,
                             std::vector<int32_t> value) const {
-  append_datas(name, "i32s", value);
+  append_datas(name, CFGObject_I32S_TYPE, value);
 }
 
 void CFGObject::append_i64s(const std::string& name,
                             std::vector<int64_t> value) const {
-  append_datas(name, "i64s", value);
+  append_datas(name, CFGObject_I64S_TYPE, value);
 }
 
 void CFGObject::append_str(const std::string& name,
                            const std::string& value) const {
-  append_datas(name, "str", value);
+  append_datas(name, CFGObject_STR_TYPE, value);
 }
 
 void CFGObject::append_strs(const std::string& name,
                             std::vector<std::string> value) const {
-  append_datas(name, "strs", value);
+  append_datas(name, CFGObject_STRS_TYPE, value);
 }
 
 void CFGObject::append_u8(const std::string& name, uint8_t value) const {
-  append_data(name, "u8s", value);
+  append_data(name, CFGObject_U8S_TYPE, value);
 }
 
 void CFGObject::append_u16(const std::string& name, uint16_t value) const {
-  append_data(name, "u16s", value);
+  append_data(name, CFGObject_U16S_TYPE, value);
 }
 
 void CFGObject::append_u32(const std::string& name, uint32_t value) const {
-  append_data(name, "u32s", value);
+  append_data(name, CFGObject_U32S_TYPE, value);
 }
 
 void CFGObject::append_u64(const std::string& name, uint64_t value) const {
-  append_data(name, "u64s", value);
+  append_data(name, CFGObject_U64S_TYPE, value);
 }
 
 void CFGObject::append_i32(const std::string& name, int32_t value) const {
-  append_data(name, "i32s", value);
+  append_data(name, CFGObject_I32S_TYPE, value);
 }
 
 void CFGObject::append_i64(const std::string& name, int64_t value) const {
-  append_data(name, "i64s", value);
+  append_data(name, CFGObject_I64S_TYPE, value);
 }
 
 void CFGObject::append_char(const std::string& name, char value) const {
   const CFGObject_RULE* rule = get_rule(name);
-  CFG_ASSERT(rule->type == "str");
+  CFG_ASSERT(rule->type_enum == CFGObject_STR_TYPE);
   std::string* ptr =
       reinterpret_cast<std::string*>(const_cast<void*>(rule->ptr));
   ptr->push_back(value);
@@ -147,7 +234,8 @@ void CFGObject::append_char(const std::string& name, char value) const {
 }
 
 bool CFGObject::write(const std::string& filepath,
-                      std::vector<std::string>* errors) {
+                      std::vector<std::string>* errors, bool index,
+                      const uint8_t compress_version) {
   // Only allow writing data at top level
   CFG_ASSERT(parent_ptr == nullptr);
   CFG_ASSERT(name.size() >= 1 && name.size() <= 8);
@@ -156,7 +244,8 @@ bool CFGObject::write(const std::string& filepath,
   bool status = check_rule(errors);
   if (status) {
     // Serialize data (fixed 8 bytes)
-    std::vector<uint8_t> data;
+    CFGObject_WRITER writer(filepath, compress_version);
+    std::vector<uint8_t>& data = writer.buffer();
     for (auto c : name) {
       data.push_back((uint8_t)(c));
     }
@@ -169,15 +258,54 @@ bool CFGObject::write(const std::string& filepath,
     CFG_write_variable_u64(data, object_count);
 
     // Serialize
-    serialize(data);
+    if (index) {
+      // Index of each top level member offset (relative to the end of the
+      // index) so that a lazy reader can jump straight to it. The offsets
+      // are only known after the members are written, reserve fixed size
+      // variable u64 and patch them at the end
+      std::vector<const CFGObject_RULE*> entries;
+      for (auto& r : rules) {
+        if (is_serializable(r)) {
+          entries.push_back(&r);
+        }
+      }
+      data.push_back(CFGOBJECT_INDEX_TYPE);
+      CFG_write_variable_u64(data, (uint64_t)(entries.size()));
+      std::vector<size_t> offset_locations;
+      for (auto r : entries) {
+        for (auto c : r->name) {
+          data.push_back((uint8_t)(c));
+        }
+        if (r->name.size() < 16) {
+          data.push_back(0);
+        }
+        offset_locations.push_back(writer.size());
+        data.insert(data.end(), CFGOBJECT_INDEX_OFFSET_SIZE, 0);
+      }
+      size_t objects_location = writer.size();
+      std::vector<uint8_t> offsets;
+      for (auto r : entries) {
+        size_t offset = writer.size() - objects_location;
+        serialize_rule(writer, r);
+        CFG_ASSERT((uint64_t)(offset) <
+                   ((uint64_t)(1) << (7 * CFGOBJECT_INDEX_OFFSET_SIZE)));
+        for (size_t i = 0; i < CFGOBJECT_INDEX_OFFSET_SIZE; i++) {
+          uint8_t next = i < (CFGOBJECT_INDEX_OFFSET_SIZE - 1) ? 0x80 : 0;
+          offsets.push_back((uint8_t)((offset >> (7 * i)) & 0x7F) | next);
+        }
+      }
+      for (size_t i = 0; i < offset_locations.size(); i++) {
+        auto begin = offsets.begin() + i * CFGOBJECT_INDEX_OFFSET_SIZE;
+        writer.patch(offset_locations[i],
+                     std::vector<uint8_t>(
+                         begin, begin + CFGOBJECT_INDEX_OFFSET_SIZE));
+      }
+    } else {
+      serialize(writer);
+    }
 
     // CRC
-    uint16_t crc = CFG_crc16(&data[0], data.size());
-    data.push_back(crc & 0xFF);
-    data.push_back((crc >> 8) & 0xFF);
-
-    // Open file as binary and dump data
-    CFG_write_binary_file(filepath, &data[0], data.size());
+    writer.close();
   }
   return status;
 }
@@ -213,6 +341,11 @@ bool CFGObject::read(std::vector<uint8_t>& data,
   object_count = CFG_read_variable_u64(&data[0], data.size(), index, 10);
   CFG_ASSERT(index < data.size());
 
+  // Index is not needed when everything is read
+  if (data[index] == CFGOBJECT_INDEX_TYPE) {
+    read_index(&data[0], data.size(), index);
+  }
+
   // Parse
   size_t parsed_object_count = 0;
   while (index < data.size()) {
@@ -240,22 +373,93 @@ bool CFGObject::read(const std::string& filepath,
   return read(data, errors);
 }
 
+bool CFGObject::read(const std::string& filepath,
+                     const std::vector<std::string>& names,
+                     std::vector<std::string>* errors,
+                     const std::string& key_name,
+                     const std::string& key_value) {
+  // Only allow reading data at top level
+  CFG_ASSERT(parent_ptr == nullptr);
+  CFG_ASSERT(name.size() >= 1 && name.size() <= 8);
+
+  // The class should be started from a blank one
+  CFG_ASSERT(get_object_count() == 0);
+
+  CFG_MMAP_FILE file(filepath);
+  CFG_ASSERT_MSG(file.is_open(), "Fail to memory map file %s",
+                 filepath.c_str());
+  CFG_ASSERT(file.size() >= 13);
+  const uint8_t* data = file.data();
+  size_t data_size = file.size() - 2;
+
+  // Make sure filename is good
+  size_t index = 0;
+  std::string filename =
+      CFG_get_string_from_bytes(data, data_size, index, 8, 2, 8);
+  CFG_ASSERT(filename == name);
+  CFG_read_variable_u64(data, data_size, index, 10);
+  CFG_ASSERT(index < data_size);
+
+  // Jump to the requested members if there is index, otherwise skip through
+  // the others without decoding them
+  size_t object_count = 0;
+  if (data[index] == CFGOBJECT_INDEX_TYPE) {
+    std::vector<std::pair<std::string, size_t>> entries =
+        read_index(data, data_size, index);
+    for (auto& entry : entries) {
+      if (std::find(names.begin(), names.end(), entry.first) != names.end()) {
+        size_t object_index = index + entry.second;
+        CFG_ASSERT(object_index < data_size);
+        parse_lazy_object(data, data_size, object_index, object_count,
+                          key_name, key_value);
+      }
+    }
+  } else {
+    while (index < data_size) {
+      size_t name_index = index + 1;
+      CFG_ASSERT(name_index < data_size);
+      std::string object_name =
+          CFG_get_string_from_bytes(data, data_size, name_index, 16, 1);
+      if (std::find(names.begin(), names.end(), object_name) != names.end()) {
+        parse_lazy_object(data, data_size, index, object_count, key_name,
+                          key_value);
+      } else {
+        skip_object(data, data_size, index);
+      }
+    }
+    CFG_ASSERT(index == data_size);
+  }
+
+  // Only check the requested members
+  bool status = true;
+  for (auto& n : names) {
+    status = check_exist(*get_rule(n), errors) && status;
+  }
+  return status;
+}
+
 // Generic, Helper
 void CFGObject::set_parent_ptr(const CFGObject* pp) const {
   CFGObject** ptr = const_cast<CFGObject**>(&parent_ptr);
   (*ptr) = const_cast<CFGObject*>(pp);
 }
 
-const CFGObject_RULE* CFGObject::get_rule(const std::string& name) const {
-  const CFGObject_RULE* rule = nullptr;
-  for (auto& r : rules) {
-    if (r.name == name) {
-      rule = &r;
-      break;
+size_t CFGObject::get_rule_index(const std::string& name) const {
+  // Generated objects override this with a switch
+  for (size_t i = 0; i < rules.size(); i++) {
+    if (rules[i].name == name) {
+      return i;
     }
   }
-  CFG_ASSERT(rule != nullptr);
-  return rule;
+  return rules.size();
+}
+
+const CFGObject_RULE* CFGObject::get_rule(const std::string& name) const {
+  size_t index = get_rule_index(name);
+  CFG_ASSERT_MSG(index < rules.size() && rules[index].name == name,
+                 "%s does not have member %s", this->name.c_str(),
+                 name.c_str());
+  return &rules[index];
 }
 
 const CFGObject_RULE* CFGObject::get_rule(const void* ptr) const {
@@ -299,25 +503,32 @@ bool CFGObject::check_exist(std::vector<std::string>* errors) const {
   bool status = true;
   // Must follow the rule
   for (auto& r : rules) {
-    // If the rule said this member must exist then we further check the
-    // existence
-    if (r.exist && !r.is_exist) {
-      post_error(CFG_print("%s does not exist", r.name.c_str()), errors);
-      status = false;
+    status = check_exist(r, errors) && status;
+  }
+  return status;
+}
+
+bool CFGObject::check_exist(const CFGObject_RULE& r,
+                            std::vector<std::string>* errors) const {
+  bool status = true;
+  // If the rule said this member must exist then we further check the
+  // existence
+  if (r.exist && !r.is_exist) {
+    post_error(CFG_print("%s does not exist", r.name.c_str()), errors);
+    status = false;
+  }
+  // Check if it has child
+  if (r.type_enum == CFGObject_LIST_TYPE) {
+    const std::vector<CFGObject*>* ptr =
+        reinterpret_cast<const std::vector<CFGObject*>*>(r.ptr);
+    for (auto child_ptr : *ptr) {
+      status = child_ptr->check_exist(errors) && status;
     }
-    // Check if it has child
-    if (r.type == "list") {
-      const std::vector<CFGObject*>* ptr =
-          reinterpret_cast<const std::vector<CFGObject*>*>(r.ptr);
-      for (auto child_ptr : *ptr) {
-        status = child_ptr->check_exist(errors) && status;
-      }
-    } else if (r.type == "class") {
-      if (r.is_exist) {
-        // For a class, only if the parent exist, we need to check the child
-        const CFGObject* ptr = reinterpret_cast<const CFGObject*>(r.ptr);
-        status = ptr->check_exist(errors) && status;
-      }
+  } else if (r.type_enum == CFGObject_CLASS_TYPE) {
+    if (r.is_exist) {
+      // For a class, only if the parent exist, we need to check the child
+      const CFGObject* ptr = reinterpret_cast<const CFGObject*>(r.ptr);
+      status = ptr->check_exist(errors) && status;
     }
   }
   return status;
@@ -331,21 +542,13 @@ void CFGObject::post_error(const std::string& msg,
   }
 }
 
-uint8_t CFGObject::get_type_enum(const std::string& type) const {
-  auto iter = std::find(SUPPORTED_TYPES.begin(), SUPPORTED_TYPES.end(), type);
-  CFG_ASSERT(iter != SUPPORTED_TYPES.end());
-  size_t distance = std::distance(SUPPORTED_TYPES.begin(), iter);
-  CFG_ASSERT(distance < 64);  // The rest reserved
-  return (uint8_t)(distance);
-}
-
 uint64_t CFGObject::get_object_count() const {
   uint64_t count = 0;
   // Must follow the rule
   for (auto& r : rules) {
     // If the rule said this member must exist then we further check the
     // existence
-    if (r.type == "list") {
+    if (r.type_enum == CFGObject_LIST_TYPE) {
       // For list, as long as the size() > 0, it exists
       const std::vector<CFGObject*>* ptr =
           reinterpret_cast<const std::vector<CFGObject*>*>(r.ptr);
@@ -362,7 +565,7 @@ uint64_t CFGObject::get_object_count() const {
     } else if (r.is_exist) {
       // exists
       count++;
-      if (r.type == "class") {
+      if (r.type_enum == CFGObject_CLASS_TYPE) {
         // if this is a class, further check the child
         const CFGObject* ptr = reinterpret_cast<const CFGObject*>(r.ptr);
         count += ptr->get_object_count();
@@ -373,40 +576,52 @@ uint64_t CFGObject::get_object_count() const {
 }
 
 // Write
-void CFGObject::serialize(std::vector<uint8_t>& data) const {
+bool CFGObject::is_serializable(const CFGObject_RULE& rule) const {
   // Only serialize those that exists
+  if (rule.type_enum == CFGObject_LIST_TYPE) {
+    return reinterpret_cast<const std::vector<CFGObject*>*>(rule.ptr)->size();
+  }
+  return rule.is_exist;
+}
+
+void CFGObject::serialize(CFGObject_WRITER& writer) const {
   for (auto& r : rules) {
-    // Check if it has child
-    if (r.type == "list") {
-      const std::vector<CFGObject*>* ptr =
-          reinterpret_cast<const std::vector<CFGObject*>*>(r.ptr);
-      if (ptr->size()) {
-        serialize_type_and_name(data, &r);
-        CFG_write_variable_u64(data, (uint64_t)(ptr->size()));
-        for (auto child_ptr : *ptr) {
-          child_ptr->serialize(data);
-          data.push_back(0xFF);
-        }
-      }
-    } else if (r.is_exist) {
-      serialize_type_and_name(data, &r);
-      if (r.type == "class") {
-        const CFGObject* ptr = reinterpret_cast<const CFGObject*>(r.ptr);
-        ptr->serialize(data);
-        data.push_back(0xFF);
-      } else {
-        serialize_value(data, &r);
-      }
+    serialize_rule(writer, &r);
+  }
+}
+
+void CFGObject::serialize_rule(CFGObject_WRITER& writer,
+                               const CFGObject_RULE* rule) const {
+  if (!is_serializable(*rule)) {
+    return;
+  }
+  std::vector<uint8_t>& data = writer.buffer();
+  serialize_type_and_name(data, rule);
+  // Check if it has child
+  if (rule->type_enum == CFGObject_LIST_TYPE) {
+    const std::vector<CFGObject*>* ptr =
+        reinterpret_cast<const std::vector<CFGObject*>*>(rule->ptr);
+    CFG_write_variable_u64(data, (uint64_t)(ptr->size()));
+    for (auto child_ptr : *ptr) {
+      child_ptr->serialize(writer);
+      data.push_back(0xFF);
     }
+  } else if (rule->type_enum == CFGObject_CLASS_TYPE) {
+    const CFGObject* ptr = reinterpret_cast<const CFGObject*>(rule->ptr);
+    ptr->serialize(writer);
+    data.push_back(0xFF);
+  } else {
+    serialize_value(writer, rule);
   }
+  writer.flush();
 }
 
 void CFGObject::serialize_type_and_name(std::vector<uint8_t>& data,
                                         const CFGObject_RULE* rule) const {
   CFG_ASSERT(rule != nullptr);
   CFG_ASSERT(rule->name.size() >= 1 && rule->name.size() <= 16);
-  uint8_t type_enum = get_type_enum(rule->type);
-  data.push_back(type_enum);
+  CFG_ASSERT(rule->type_enum < 64);  // The rest reserved
+  data.push_back((uint8_t)(rule->type_enum));
   for (auto c : rule->name) {
     data.push_back((uint8_t)(c));
   }
@@ -415,61 +630,81 @@ void CFGObject::serialize_type_and_name(std::vector<uint8_t>& data,
   }
 }
 
-void CFGObject::serialize_value(std::vector<uint8_t>& data,
+void CFGObject::serialize_value(CFGObject_WRITER& writer,
                                 const CFGObject_RULE* rule) const {
   CFG_ASSERT(rule != nullptr);
+  std::vector<uint8_t>& data = writer.buffer();
   void* ptr = const_cast<void*>(rule->ptr);
-  if (rule->type == "bool") {
-    serialize_data(data, *(reinterpret_cast<bool*>(ptr)));
-  } else if (rule->type == "u8") {
-    serialize_data(data, *(reinterpret_cast<uint8_t*>(ptr)));
-  } else if (rule->type == "u16") {
-    serialize_data(data, *(reinterpret_cast<uint16_t*>(ptr)));
-  } else if (rule->type == "u32") {
-    serialize_data(data, *(reinterpret_cast<uint32_t*>(ptr)));
-  } else if (rule->type == "u64") {
-    serialize_data(data, *(reinterpret_cast<uint64_t*>(ptr)));
-  } else if (rule->type == "i32") {
-    serialize_data(data, *(reinterpret_cast<int32_t*>(ptr)));
-  } else if (rule->type == "i64") {
-    serialize_data(data, *(reinterpret_cast<int64_t*>(ptr)));
-  } else if (rule->type == "u8s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<uint8_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "u16s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<uint16_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "u32s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<uint32_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "u64s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<uint64_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "i32s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<int32_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "i64s") {
-    serialize_datas(data, *(reinterpret_cast<std::vector<int64_t>*>(ptr)),
-                    rule->compress);
-  } else if (rule->type == "str") {
-    std::string* string = reinterpret_cast<std::string*>(ptr);
-    for (auto c : *string) {
-      data.push_back((uint8_t)(c));
-    }
-    data.push_back(0);
-  } else if (rule->type == "strs") {
-    std::vector<std::string>* strings =
-        reinterpret_cast<std::vector<std::string>*>(ptr);
-    CFG_write_variable_u64(data, (uint64_t)(strings->size()));
-    for (auto string : *strings) {
-      for (auto c : string) {
+  switch (rule->type_enum) {
+    case CFGObject_BOOL_TYPE:
+      serialize_data(data, *(reinterpret_cast<bool*>(ptr)));
+      break;
+    case CFGObject_U8_TYPE:
+      serialize_data(data, *(reinterpret_cast<uint8_t*>(ptr)));
+      break;
+    case CFGObject_U16_TYPE:
+      serialize_data(data, *(reinterpret_cast<uint16_t*>(ptr)));
+      break;
+    case CFGObject_U32_TYPE:
+      serialize_data(data, *(reinterpret_cast<uint32_t*>(ptr)));
+      break;
+    case CFGObject_U64_TYPE:
+      serialize_data(data, *(reinterpret_cast<uint64_t*>(ptr)));
+      break;
+    case CFGObject_I32_TYPE:
+      serialize_data(data, *(reinterpret_cast<int32_t*>(ptr)));
+      break;
+    case CFGObject_I64_TYPE:
+      serialize_data(data, *(reinterpret_cast<int64_t*>(ptr)));
+      break;
+    case CFGObject_U8S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<uint8_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_U16S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<uint16_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_U32S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<uint32_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_U64S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<uint64_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_I32S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<int32_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_I64S_TYPE:
+      serialize_datas(writer, *(reinterpret_cast<std::vector<int64_t>*>(ptr)),
+                      rule->compress);
+      break;
+    case CFGObject_STR_TYPE: {
+      std::string* string = reinterpret_cast<std::string*>(ptr);
+      for (auto c : *string) {
         data.push_back((uint8_t)(c));
       }
       data.push_back(0);
+      break;
     }
-  } else {
-    CFG_INTERNAL_ERROR("serialize_value(): Unsupported type %s",
-                       rule->type.c_str());
+    case CFGObject_STRS_TYPE: {
+      std::vector<std::string>* strings =
+          reinterpret_cast<std::vector<std::string>*>(ptr);
+      CFG_write_variable_u64(data, (uint64_t)(strings->size()));
+      for (auto string : *strings) {
+        for (auto c : string) {
+          data.push_back((uint8_t)(c));
+        }
+        data.push_back(0);
+      }
+      break;
+    }
+    default:
+      CFG_INTERNAL_ERROR("serialize_value(): Unsupported type %s",
+                         rule->type.c_str());
+      break;
   }
 }
 
@@ -479,63 +714,86 @@ void CFGObject::parse_object(const uint8_t* data, size_t data_size,
   CFG_ASSERT(data != nullptr && data_size > 0);
   CFG_ASSERT(index < data_size);
   CFG_ASSERT(data[index] < (uint8_t)(SUPPORTED_TYPES.size()));
-  std::string object_type = SUPPORTED_TYPES[data[index]];
+  CFGObject_TYPE object_type = (CFGObject_TYPE)(data[index]);
   index++;
   CFG_ASSERT(index < data_size);
   std::string object_name =
       CFG_get_string_from_bytes(data, data_size, index, 16, 1);
   const CFGObject_RULE* rule = get_rule(object_name);
-  CFG_ASSERT(rule->type == object_type);
-  if (object_type == "bool") {
-    read_data(data, data_size, index, rule, bool(false));
-  } else if (object_type == "u8") {
-    read_data(data, data_size, index, rule, uint8_t(0));
-  } else if (object_type == "u16") {
-    read_data(data, data_size, index, rule, uint16_t(0));
-  } else if (object_type == "u32") {
-    read_data(data, data_size, index, rule, uint32_t(0));
-  } else if (object_type == "u64") {
-    read_data(data, data_size, index, rule, uint64_t(0));
-  } else if (object_type == "i32") {
-    read_data(data, data_size, index, rule, int32_t(0));
-  } else if (object_type == "i64") {
-    read_data(data, data_size, index, rule, int64_t(0));
-  } else if (object_type == "u8s") {
-    read_datas(data, data_size, index, rule, uint8_t(0));
-  } else if (object_type == "u16s") {
-    read_datas(data, data_size, index, rule, uint16_t(0));
-  } else if (object_type == "u32s") {
-    read_datas(data, data_size, index, rule, uint32_t(0));
-  } else if (object_type == "u64s") {
-    read_datas(data, data_size, index, rule, uint64_t(0));
-  } else if (object_type == "i32s") {
-    read_datas(data, data_size, index, rule, int32_t(0));
-  } else if (object_type == "i64s") {
-    read_datas(data, data_size, index, rule, int64_t(0));
-  } else if (object_type == "str") {
-    write_data(rule, CFG_get_string_from_bytes(data, data_size, index));
-  } else if (object_type == "strs") {
-    uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
-    std::vector<std::string> strs;
-    for (uint64_t i = 0; i < list_count; i++) {
-      strs.push_back(CFG_get_string_from_bytes(data, data_size, index));
+  CFG_ASSERT(rule->type_enum == object_type);
+  switch (object_type) {
+    case CFGObject_BOOL_TYPE:
+      read_data(data, data_size, index, rule, bool(false));
+      break;
+    case CFGObject_U8_TYPE:
+      read_data(data, data_size, index, rule, uint8_t(0));
+      break;
+    case CFGObject_U16_TYPE:
+      read_data(data, data_size, index, rule, uint16_t(0));
+      break;
+    case CFGObject_U32_TYPE:
+      read_data(data, data_size, index, rule, uint32_t(0));
+      break;
+    case CFGObject_U64_TYPE:
+      read_data(data, data_size, index, rule, uint64_t(0));
+      break;
+    case CFGObject_I32_TYPE:
+      read_data(data, data_size, index, rule, int32_t(0));
+      break;
+    case CFGObject_I64_TYPE:
+      read_data(data, data_size, index, rule, int64_t(0));
+      break;
+    case CFGObject_U8S_TYPE:
+      read_datas(data, data_size, index, rule, uint8_t(0));
+      break;
+    case CFGObject_U16S_TYPE:
+      read_datas(data, data_size, index, rule, uint16_t(0));
+      break;
+    case CFGObject_U32S_TYPE:
+      read_datas(data, data_size, index, rule, uint32_t(0));
+      break;
+    case CFGObject_U64S_TYPE:
+      read_datas(data, data_size, index, rule, uint64_t(0));
+      break;
+    case CFGObject_I32S_TYPE:
+      read_datas(data, data_size, index, rule, int32_t(0));
+      break;
+    case CFGObject_I64S_TYPE:
+      read_datas(data, data_size, index, rule, int64_t(0));
+      break;
+    case CFGObject_STR_TYPE:
+      write_data(rule, CFG_get_string_from_bytes(data, data_size, index));
+      break;
+    case CFGObject_STRS_TYPE: {
+      uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
+      std::vector<std::string> strs;
+      for (uint64_t i = 0; i < list_count; i++) {
+        strs.push_back(CFG_get_string_from_bytes(data, data_size, index));
+      }
+      write_data(rule, strs);
+      break;
     }
-    write_data(rule, strs);
-  } else if (object_type == "class") {
-    const CFGObject* ptr = reinterpret_cast<const CFGObject*>(rule->ptr);
-    ptr->parse_class_object(data, data_size, index, object_count);
-  } else if (object_type == "list") {
-    uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
-    std::vector<CFGObject*>* list = reinterpret_cast<std::vector<CFGObject*>*>(
-        const_cast<void*>(rule->ptr));
-    for (uint64_t i = 0; i < list_count; i++) {
-      CFGObject_create_child_from_names(name, object_name,
-                                        const_cast<CFGObject*>(this));
-      list->back()->parse_class_object(data, data_size, index, object_count);
+    case CFGObject_CLASS_TYPE: {
+      const CFGObject* ptr = reinterpret_cast<const CFGObject*>(rule->ptr);
+      ptr->parse_class_object(data, data_size, index, object_count);
+      break;
     }
-  } else {
-    CFG_INTERNAL_ERROR("parse_object(): Unsupport type %s",
-                       object_type.c_str());
+    case CFGObject_LIST_TYPE: {
+      uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
+      std::vector<CFGObject*>* list =
+          reinterpret_cast<std::vector<CFGObject*>*>(
+              const_cast<void*>(rule->ptr));
+      for (uint64_t i = 0; i < list_count; i++) {
+        CFGObject_create_child_from_names(name, object_name,
+                                          const_cast<CFGObject*>(this));
+        list->back()->parse_class_object(data, data_size, index,
+                                         object_count);
+      }
+      break;
+    }
+    default:
+      CFG_INTERNAL_ERROR("parse_object(): Unsupport type %d", object_type);
+      break;
   }
   object_count++;
 }
@@ -554,6 +812,183 @@ void CFGObject::parse_class_object(const uint8_t* data, size_t data_size,
   index++;
 }
 
+void CFGObject::parse_list_object(const uint8_t* data, size_t data_size,
+                                  size_t& index, size_t& object_count,
+                                  const std::string& key_name,
+                                  const std::string& key_value) const {
+  CFG_ASSERT(data != nullptr && data_size > 0);
+  CFG_ASSERT(index < data_size);
+  CFG_ASSERT(data[index] == (uint8_t)(CFGObject_LIST_TYPE));
+  index++;
+  CFG_ASSERT(index < data_size);
+  std::string object_name =
+      CFG_get_string_from_bytes(data, data_size, index, 16, 1);
+  const CFGObject_RULE* rule = get_rule(object_name);
+  CFG_ASSERT(rule->type_enum == CFGObject_LIST_TYPE);
+  uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
+  for (uint64_t i = 0; i < list_count; i++) {
+    // Walk past the element members without decoding them, only the key is
+    // compared. A matching element is then parsed from its start
+    size_t element_index = index;
+    bool match = false;
+    CFG_ASSERT(index < data_size);
+    CFG_ASSERT(data[index] != 0xFF);
+    while (data[index] != 0xFF) {
+      if (data[index] == (uint8_t)(CFGObject_STR_TYPE)) {
+        size_t name_index = index + 1;
+        CFG_ASSERT(name_index < data_size);
+        if (CFG_get_string_from_bytes(data, data_size, name_index, 16, 1) ==
+            key_name) {
+          match = CFG_get_string_from_bytes(data, data_size, name_index) ==
+                  key_value;
+        }
+      }
+      skip_object(data, data_size, index);
+      CFG_ASSERT(index < data_size);
+    }
+    index++;
+    if (match) {
+      CFGObject_create_child_from_names(name, object_name,
+                                        const_cast<CFGObject*>(this));
+      reinterpret_cast<const std::vector<CFGObject*>*>(rule->ptr)
+          ->back()
+          ->parse_class_object(data, data_size, element_index, object_count);
+    }
+  }
+  object_count++;
+}
+
+void CFGObject::parse_lazy_object(const uint8_t* data, size_t data_size,
+                                  size_t& index, size_t& object_count,
+                                  const std::string& key_name,
+                                  const std::string& key_value) const {
+  CFG_ASSERT(index < data_size);
+  if (key_name.size() && data[index] == (uint8_t)(CFGObject_LIST_TYPE)) {
+    parse_list_object(data, data_size, index, object_count, key_name,
+                      key_value);
+  } else {
+    parse_object(data, data_size, index, object_count);
+  }
+}
+
+void CFGObject::skip_object(const uint8_t* data, size_t data_size,
+                            size_t& index) {
+  CFG_ASSERT(data != nullptr && data_size > 0);
+  CFG_ASSERT(index < data_size);
+  CFG_ASSERT(data[index] < (uint8_t)(SUPPORTED_TYPES.size()));
+  CFGObject_TYPE object_type = (CFGObject_TYPE)(data[index]);
+  index++;
+  CFG_ASSERT(index < data_size);
+  CFG_get_string_from_bytes(data, data_size, index, 16, 1);
+  switch (object_type) {
+    case CFGObject_BOOL_TYPE:
+    case CFGObject_U8_TYPE: {
+      uint8_t value = 0;
+      deserialize_data(data, data_size, index, value);
+      break;
+    }
+    case CFGObject_U16_TYPE: {
+      uint16_t value = 0;
+      deserialize_data(data, data_size, index, value);
+      break;
+    }
+    case CFGObject_U32_TYPE:
+    case CFGObject_I32_TYPE: {
+      uint32_t value = 0;
+      deserialize_data(data, data_size, index, value);
+      break;
+    }
+    case CFGObject_U64_TYPE:
+    case CFGObject_I64_TYPE: {
+      uint64_t value = 0;
+      deserialize_data(data, data_size, index, value);
+      break;
+    }
+    case CFGObject_U8S_TYPE:
+      skip_datas(data, data_size, index, uint8_t(0));
+      break;
+    case CFGObject_U16S_TYPE:
+      skip_datas(data, data_size, index, uint16_t(0));
+      break;
+    case CFGObject_U32S_TYPE:
+    case CFGObject_I32S_TYPE:
+      skip_datas(data, data_size, index, uint32_t(0));
+      break;
+    case CFGObject_U64S_TYPE:
+    case CFGObject_I64S_TYPE:
+      skip_datas(data, data_size, index, uint64_t(0));
+      break;
+    case CFGObject_STR_TYPE:
+      CFG_get_string_from_bytes(data, data_size, index);
+      break;
+    case CFGObject_STRS_TYPE: {
+      uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
+      for (uint64_t i = 0; i < list_count; i++) {
+        CFG_get_string_from_bytes(data, data_size, index);
+      }
+      break;
+    }
+    default: {
+      uint64_t list_count = 1;
+      if (object_type == CFGObject_LIST_TYPE) {
+        list_count = CFG_read_variable_u64(data, data_size, index, 10);
+      }
+      for (uint64_t i = 0; i < list_count; i++) {
+        CFG_ASSERT(index < data_size);
+        CFG_ASSERT(data[index] != 0xFF);
+        while (data[index] != 0xFF) {
+          skip_object(data, data_size, index);
+          CFG_ASSERT(index < data_size);
+        }
+        index++;
+      }
+      break;
+    }
+  }
+}
+
+std::vector<std::pair<std::string, size_t>> CFGObject::read_index(
+    const uint8_t* data, size_t data_size, size_t& index) {
+  CFG_ASSERT(data != nullptr && data_size > 0);
+  CFG_ASSERT(index < data_size);
+  CFG_ASSERT(data[index] == CFGOBJECT_INDEX_TYPE);
+  index++;
+  std::vector<std::pair<std::string, size_t>> entries;
+  uint64_t entry_count = CFG_read_variable_u64(data, data_size, index, 10);
+  for (uint64_t i = 0; i < entry_count; i++) {
+    std::string entry_name =
+        CFG_get_string_from_bytes(data, data_size, index, 16, 1);
+    size_t offset =
+        (size_t)(CFG_read_variable_u64(data, data_size, index, 10));
+    entries.push_back(std::make_pair(entry_name, offset));
+  }
+  CFG_ASSERT(index < data_size);
+  return entries;
+}
+
+bool CFGObject::is_compression_worthy(const uint8_t* data, size_t size,
+                                      size_t serialized_size) {
+  // Compress evenly spread samples and extrapolate, only a big input that
+  // clearly does not compress well skips the full compression
+  const size_t sample_count = 16;
+  const size_t sample_size = 4096;
+  if (size <= (4 * sample_count * sample_size)) {
+    return true;
+  }
+  std::vector<uint8_t> sample(sample_count * sample_size);
+  size_t stride = (size - sample_size) / (sample_count - 1);
+  for (size_t i = 0; i < sample_count; i++) {
+    memcpy(&sample[i * sample_size], &data[i * stride], sample_size);
+  }
+  std::vector<uint8_t> compress_data;
+  CFG_compress(&sample[0], sample.size(), compress_data, nullptr, false);
+  double estimated_size =
+      (double)(compress_data.size()) * (double)(size) / (double)(sample.size());
+  memset(&sample[0], 0, sample.size());
+  memset(&compress_data[0], 0, compress_data.size());
+  return estimated_size < (double)(serialized_size);
+}
+
 // Template
 template <typename T>
 void CFGObject::write_data(const CFGObject_RULE* rule, T value) const {
@@ -563,10 +998,10 @@ void CFGObject::write_data(const CFGObject_RULE* rule, T value) const {
 }
 
 template <typename T>
-void CFGObject::write_data(const std::string& name, const std::string& type,
+void CFGObject::write_data(const std::string& name, CFGObject_TYPE type,
                            T value) const {
   const CFGObject_RULE* rule = get_rule(name);
-  CFG_ASSERT(rule->type == type);
+  CFG_ASSERT(rule->type_enum == type);
   write_data(rule, value);
 }
 
@@ -596,17 +1031,22 @@ std::vector<T> CFGObject::read_raw_datas(const uint8_t* data, size_t data_size,
         CFG_read_variable_u64(data, data_size, temp_index, 10);
     CFG_ASSERT((list_count * sizeof(T)) == original_size);
     CFG_ASSERT((temp_index + compress_size) <= data_size);
-    std::vector<uint8_t> temp_data;
     size_t compression_total_size = temp_index - index + compress_size;
-    CFG_decompress(&data[index], compression_total_size, temp_data);
-    CFG_ASSERT(original_size == temp_data.size());
     // When compression happen, data is raw
     // We cannot use deserialisze method to read the data since deserialisze
     // might use dynamic way (depends on compression flag)
+    // Decompress straight into the values
     values.resize(list_count);
-    memcpy(&values[0], &temp_data[0], original_size);
+    CFG_decompress(&data[index], compression_total_size,
+                   reinterpret_cast<uint8_t*>(&values[0]), original_size);
     index += compression_total_size;
+  } else if (sizeof(T) == 1) {
+    CFG_ASSERT((index + list_count) <= data_size);
+    values.resize(list_count);
+    memcpy(&values[0], &data[index], list_count);
+    index += list_count;
   } else {
+    values.reserve(list_count);
     for (uint64_t i = 0; i < list_count; i++) {
       deserialize_data(data, data_size, index, value);
       values.push_back(value);
@@ -615,6 +1055,30 @@ std::vector<T> CFGObject::read_raw_datas(const uint8_t* data, size_t data_size,
   return values;
 }
 
+template <typename T>
+void CFGObject::skip_datas(const uint8_t* data, size_t data_size,
+                           size_t& index, T value) {
+  uint64_t list_count = CFG_read_variable_u64(data, data_size, index, 10);
+  bool compress = bool(list_count & 1);
+  list_count >>= 1;
+  CFG_ASSERT(list_count > 0);
+  if (compress) {
+    size_t temp_index = index + 8;
+    CFG_read_variable_u64(data, data_size, temp_index, 10);
+    uint64_t compress_size =
+        CFG_read_variable_u64(data, data_size, temp_index, 10);
+    CFG_ASSERT((temp_index + compress_size) <= data_size);
+    index = temp_index + compress_size;
+  } else if (sizeof(T) == 1) {
+    CFG_ASSERT((index + list_count) <= data_size);
+    index += list_count;
+  } else {
+    for (uint64_t i = 0; i < list_count; i++) {
+      deserialize_data(data, data_size, index, value);
+    }
+  }
+}
+
 template <typename T>
 void CFGObject::read_datas(const uint8_t* data, size_t data_size, size_t& index,
                            const CFGObject_RULE* rule, T value) const {
@@ -623,20 +1087,20 @@ void CFGObject::read_datas(const uint8_t* data, size_t data_size, size_t& index,
 }
 
 template <typename T>
-void CFGObject::append_datas(const std::string& name, const std::string& type,
+void CFGObject::append_datas(const std::string& name, CFGObject_TYPE type,
                              T value) const {
   const CFGObject_RULE* rule = get_rule(name);
-  CFG_ASSERT(rule->type == type);
+  CFG_ASSERT(rule->type_enum == type);
   T* ptr = reinterpret_cast<T*>(const_cast<void*>(rule->ptr));
   ptr->insert(ptr->end(), value.begin(), value.end());
   update_exist(rule);
 }
 
 template <typename T>
-void CFGObject::append_data(const std::string& name, const std::string& type,
+void CFGObject::append_data(const std::string& name, CFGObject_TYPE type,
                             T value) const {
   const CFGObject_RULE* rule = get_rule(name);
-  CFG_ASSERT(rule->type == type);
+  CFG_ASSERT(rule->type_enum == type);
   std::vector<T>* ptr =
       reinterpret_cast<std::vector<T>*>(const_cast<void*>(rule->ptr));
   ptr->push_back(value);
@@ -690,30 +1154,89 @@ void CFGObject::deserialize_data(const uint8_t* data, size_t data_size,
 }
 
 template <typename T>
-void CFGObject::serialize_datas(std::vector<uint8_t>& data,
-                                std::vector<T>& value, bool compress) const {
-  std::vector<uint8_t> temp;
+size_t CFGObject::get_serialized_size(const std::vector<T>& value) const {
+#if defined(OPTIMIZE_DATA_LENGTH)
+  if (sizeof(T) == 1) {
+    return value.size();
+  }
+  size_t size = 0;
   for (auto v : value) {
-    serialize_data(temp, v);
+    uint64_t u64 = (uint64_t)(v);
+    if (sizeof(T) < 8) {
+      u64 &= ((uint64_t)(1) << (sizeof(T) * 8)) - 1;
+    }
+    do {
+      size++;
+      u64 >>= 7;
+    } while (u64);
   }
+  return size;
+#else
+  return value.size() * sizeof(T);
+#endif
+}
+
+// All the array types (visible to the unit test)
+template size_t CFGObject::get_serialized_size(
+    const std::vector<uint8_t>& value) const;
+template size_t CFGObject::get_serialized_size(
+    const std::vector<uint16_t>& value) const;
+template size_t CFGObject::get_serialized_size(
+    const std::vector<uint32_t>& value) const;
+template size_t CFGObject::get_serialized_size(
+    const std::vector<uint64_t>& value) const;
+template size_t CFGObject::get_serialized_size(
+    const std::vector<int32_t>& value) const;
+template size_t CFGObject::get_serialized_size(
+    const std::vector<int64_t>& value) const;
+
+template <typename T>
+void CFGObject::serialize_datas(CFGObject_WRITER& writer,
+                                std::vector<T>& value, bool compress) const {
+  std::vector<uint8_t>& data = writer.buffer();
+  size_t serialized_size = get_serialized_size(value);
   if (compress) {
     uint8_t* original_data = reinterpret_cast<uint8_t*>(&value[0]);
     size_t original_size = (value.size() * sizeof(T));
-    std::vector<uint8_t> compress_data;
-    CFG_compress(original_data, original_size, compress_data, nullptr, false);
-    if (temp.size() > compress_data.size()) {
-      CFG_write_variable_u64(data, (uint64_t)(value.size()) << 1 | 1);
-      data.insert(data.end(), compress_data.begin(), compress_data.end());
-    } else {
-      compress = false;
+    compress = is_compression_worthy(original_data, original_size,
+                                     serialized_size);
+    if (compress) {
+      std::vector<uint8_t> compress_data;
+      CFG_compress(original_data, original_size, compress_data, nullptr,
+                   false, true, writer.compress_version());
+      if (serialized_size > compress_data.size()) {
+        CFG_write_variable_u64(data, (uint64_t)(value.size()) << 1 | 1);
+        writer.write(&compress_data[0], compress_data.size());
+      } else {
+        compress = false;
+      }
+      memset(&compress_data[0], 0, compress_data.size());
+      compress_data.clear();
     }
-    memset(&compress_data[0], 0, compress_data.size());
-    compress_data.clear();
   }
   if (!compress) {
     CFG_write_variable_u64(data, (uint64_t)(value.size()) << 1);
-    data.insert(data.end(), temp.begin(), temp.end());
+    if (sizeof(T) == 1) {
+      // Byte array is serialized as it is, write it in one go
+      writer.write(reinterpret_cast<const uint8_t*>(&value[0]), value.size());
+    } else {
+      for (auto v : value) {
+        serialize_data(data, v);
+        writer.flush();
+      }
+    }
   }
-  memset(&temp[0], 0, temp.size());
-  temp.clear();
 }
+
+// CFGObject_parse.cpp uses these directly
+#define CFGOBJECT_INSTANTIATE_DATAS(T)                                      \
+  template void CFGObject::deserialize_data(const uint8_t*, size_t, size_t&, \
+                                            T&);                            \
+  template std::vector<T> CFGObject::read_raw_datas(const uint8_t*, size_t,  \
+                                                    size_t&, T);
+CFGOBJECT_INSTANTIATE_DATAS(uint8_t)
+CFGOBJECT_INSTANTIATE_DATAS(uint16_t)
+CFGOBJECT_INSTANTIATE_DATAS(uint32_t)
+CFGOBJECT_INSTANTIATE_DATAS(uint64_t)
+CFGOBJECT_INSTANTIATE_DATAS(int32_t)
+CFGOBJECT_INSTANTIATE_DATAS(int64_t)
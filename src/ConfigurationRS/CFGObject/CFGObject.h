@@ -2,7 +2,9 @@
 #define CFGOBJECT_H
 
 #include <algorithm>
+#include <fstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
@@ -13,16 +15,62 @@ const std::vector<std::string> SUPPORTED_TYPES = {
     "bool", "u8",   "u16",  "u32",  "u64", "i32",  "i64",   "u8s", "u16s",
     "u32s", "u64s", "i32s", "i64s", "str", "strs", "class", "list"};
 
+// Same ordering as SUPPORTED_TYPES
+enum CFGObject_TYPE {
+  CFGObject_BOOL_TYPE,
+  CFGObject_U8_TYPE,
+  CFGObject_U16_TYPE,
+  CFGObject_U32_TYPE,
+  CFGObject_U64_TYPE,
+  CFGObject_I32_TYPE,
+  CFGObject_I64_TYPE,
+  CFGObject_U8S_TYPE,
+  CFGObject_U16S_TYPE,
+  CFGObject_U32S_TYPE,
+  CFGObject_U64S_TYPE,
+  CFGObject_I32S_TYPE,
+  CFGObject_I64S_TYPE,
+  CFGObject_STR_TYPE,
+  CFGObject_STRS_TYPE,
+  CFGObject_CLASS_TYPE,
+  CFGObject_LIST_TYPE
+};
+
+inline CFGObject_TYPE CFGObject_get_type(const std::string& type) {
+  auto iter = std::find(SUPPORTED_TYPES.begin(), SUPPORTED_TYPES.end(), type);
+  CFG_ASSERT(iter != SUPPORTED_TYPES.end());
+  return (CFGObject_TYPE)(std::distance(SUPPORTED_TYPES.begin(), iter));
+}
+
+// Member name hash (FNV-1a), the generated objects use it to switch from name
+// to rule index at compile time
+constexpr uint64_t CFGObject_hash(const char* name) {
+  uint64_t hash = 0xCBF29CE484222325;
+  while (*name) {
+    hash = (hash ^ (uint64_t)((uint8_t)(*name++))) * 0x100000001B3;
+  }
+  return hash;
+}
+
+// Reserved type (outside of SUPPORTED_TYPES) of the optional index of the top
+// level members. When it exists, it is the first object
+const uint8_t CFGOBJECT_INDEX_TYPE = 63;
+// Index offset is always written in this many bytes of variable u64
+const size_t CFGOBJECT_INDEX_OFFSET_SIZE = 8;
+// CFGObject_WRITER flushes its buffer to file once it reaches this size
+const size_t CFGOBJECT_WRITER_SIZE = 1024 * 1024;
+
 struct CFGObject_RULE {
   CFGObject_RULE(std::string n, bool e, bool c, void* p, const std::string& t)
-      : name(n), exist(e), compress(c), ptr(p), type(t) {
+      : CFGObject_RULE(n, e, c, p, CFGObject_get_type(t)) {}
+  CFGObject_RULE(std::string n, bool e, bool c, void* p, CFGObject_TYPE t)
+      : name(n), exist(e), compress(c), ptr(p), type_enum(t) {
     // name
     CFG_ASSERT(name.size() >= 1 && name.size() <= 16);
     // ptr  must not be nullptr
     CFG_ASSERT(ptr != nullptr);
     // type must be supported
-    auto iter = std::find(SUPPORTED_TYPES.begin(), SUPPORTED_TYPES.end(), type);
-    CFG_ASSERT(iter != SUPPORTED_TYPES.end());
+    CFG_ASSERT((size_t)(type_enum) < SUPPORTED_TYPES.size());
   }
   void set_exist(bool e) const {
     bool* is_exist_ptr = const_cast<bool*>(&is_exist);
@@ -32,15 +80,53 @@ struct CFGObject_RULE {
   const bool exist;
   const bool compress;
   const void* ptr;
-  const std::string type;
+  const CFGObject_TYPE type_enum;
+  const std::string& type = SUPPORTED_TYPES[type_enum];
   bool is_exist = false;
 };
 
+// Buffered file output of CFGObject::write(). Serialized bytes go into
+// buffer() and are flushed to the file whenever it grows beyond the threshold,
+// so the whole serialized object never sits in memory. The file is written
+// as <filepath>.tmp and only renamed to filepath by close()
+class CFGObject_WRITER {
+ public:
+  CFGObject_WRITER(const std::string& filepath,
+                   const uint8_t compress_version = 0);
+  ~CFGObject_WRITER();
+  std::vector<uint8_t>& buffer() { return m_buffer; }
+  // CFG_CMP stream version of the compressed arrays
+  uint8_t compress_version() const { return m_compress_version; }
+  // Total bytes written so far (including what is still buffered)
+  size_t size() const { return m_size + m_buffer.size(); }
+  void flush(bool force = false);
+  // Write big data straight to the file without copying it into the buffer
+  void write(const uint8_t* data, size_t size);
+  // Overwrite bytes which had been written earlier
+  void patch(size_t offset, const std::vector<uint8_t>& data);
+  // Append the CRC16 of the whole file, close it and move it to the target
+  void close();
+
+ private:
+  CFGObject_WRITER(const CFGObject_WRITER&) = delete;
+  CFGObject_WRITER& operator=(const CFGObject_WRITER&) = delete;
+  void write_file(const uint8_t* data, size_t size);
+  const std::string m_filepath;
+  const std::string m_temp_filepath;
+  const uint8_t m_compress_version;
+  std::fstream m_file;
+  std::vector<uint8_t> m_buffer;
+  size_t m_size = 0;
+  uint16_t m_crc = 0xFFFF;
+  bool m_patched = false;
+};
+
 class CFGObject {
  public:
   CFGObject() {}
   CFGObject(const std::string& n, const std::vector<CFGObject_RULE>& r)
       : name(n), rules(r) {}
+  virtual ~CFGObject() {}
 
   // Let caller doubel confirm the name of CFGObject
   std::string get_name() const;
@@ -80,11 +166,19 @@ class CFGObject {
 
   // File IO
   bool write(const std::string& filepath,
-             std::vector<std::string>* errors = nullptr);
+             std::vector<std::string>* errors = nullptr, bool index = false,
+             const uint8_t compress_version = 0);
   bool read(std::vector<uint8_t>& data,
             std::vector<std::string>* errors = nullptr);
   bool read(const std::string& filepath,
             std::vector<std::string>* errors = nullptr);
+  // Lazy read: memory map the file and only decode the requested top level
+  // members (CRC is not checked). If key_name is set, a requested list only
+  // decodes the elements whose str member key_name equals key_value
+  bool read(const std::string& filepath, const std::vector<std::string>& names,
+            std::vector<std::string>* errors = nullptr,
+            const std::string& key_name = "",
+            const std::string& key_value = "");
   // Generic, Helper (Public)
   void set_parent_ptr(const CFGObject* pp) const;
   uint64_t get_object_count() const;
@@ -98,37 +192,54 @@ class CFGObject {
   template <typename T>
   static std::vector<T> read_raw_datas(const uint8_t* data, size_t data_size,
                                        size_t& index, T value);
+  static void skip_object(const uint8_t* data, size_t data_size,
+                          size_t& index);
+  static std::vector<std::pair<std::string, size_t>> read_index(
+      const uint8_t* data, size_t data_size, size_t& index);
 
  protected:
   // Generic, Helper
+  virtual size_t get_rule_index(const std::string& name) const;
   const CFGObject_RULE* get_rule(const std::string& name) const;
   const CFGObject_RULE* get_rule(const void* ptr) const;
   void update_exist(const CFGObject_RULE* rule) const;
   void update_exist(const std::string& name) const;
   bool check_rule(std::vector<std::string>* errors) const;
   bool check_exist(std::vector<std::string>* errors) const;
+  bool check_exist(const CFGObject_RULE& rule,
+                   std::vector<std::string>* errors) const;
   void post_error(const std::string& msg,
                   std::vector<std::string>* errors) const;
-  uint8_t get_type_enum(const std::string& type) const;
 
   // Write
-  void serialize(std::vector<uint8_t>& data) const;
+  bool is_serializable(const CFGObject_RULE& rule) const;
+  void serialize(CFGObject_WRITER& writer) const;
+  void serialize_rule(CFGObject_WRITER& writer,
+                      const CFGObject_RULE* rule) const;
   void serialize_type_and_name(std::vector<uint8_t>& data,
                                const CFGObject_RULE* rule) const;
-  void serialize_value(std::vector<uint8_t>& data,
+  void serialize_value(CFGObject_WRITER& writer,
                        const CFGObject_RULE* rule) const;
+  static bool is_compression_worthy(const uint8_t* data, size_t size,
+                                    size_t serialized_size);
 
   // Read
   void parse_object(const uint8_t* data, size_t data_size, size_t& index,
                     size_t& object_count) const;
   void parse_class_object(const uint8_t* data, size_t data_size, size_t& index,
                           size_t& object_count) const;
+  void parse_list_object(const uint8_t* data, size_t data_size, size_t& index,
+                         size_t& object_count, const std::string& key_name,
+                         const std::string& key_value) const;
+  void parse_lazy_object(const uint8_t* data, size_t data_size, size_t& index,
+                         size_t& object_count, const std::string& key_name,
+                         const std::string& key_value) const;
 
   // Using template
   template <typename T>
   void write_data(const CFGObject_RULE* rule, T value) const;
   template <typename T>
-  void write_data(const std::string& name, const std::string& type,
+  void write_data(const std::string& name, CFGObject_TYPE type,
                   T value) const;
   template <typename T>
   void read_data(const uint8_t* data, size_t data_size, size_t& index,
@@ -137,16 +248,21 @@ class CFGObject {
   void read_datas(const uint8_t* data, size_t data_size, size_t& index,
                   const CFGObject_RULE* rule, T value) const;
   template <typename T>
-  void append_datas(const std::string& name, const std::string& type,
+  void append_datas(const std::string& name, CFGObject_TYPE type,
                     T value) const;
   template <typename T>
-  void append_data(const std::string& name, const std::string& type,
+  void append_data(const std::string& name, CFGObject_TYPE type,
                    T value) const;
   template <typename T>
+  static void skip_datas(const uint8_t* data, size_t data_size, size_t& index,
+                         T value);
+  template <typename T>
   void serialize_data(std::vector<uint8_t>& data, T value) const;
 
   template <typename T>
-  void serialize_datas(std::vector<uint8_t>& data, std::vector<T>& value,
+  size_t get_serialized_size(const std::vector<T>& value) const;
+  template <typename T>
+  void serialize_datas(CFGObject_WRITER& writer, std::vector<T>& value,
                        bool compress) const;
 
   // Members
@@ -99,6 +99,14 @@ def check_element(values, name, siblings, level=0) :
   if level > MAX_LEVEL :
     MAX_LEVEL = level
 
+def get_name_hash(name) :
+
+  # Must match CFGObject_hash() in CFGObject.h (FNV-1a)
+  hash = 0xCBF29CE484222325
+  for c in name :
+    hash = ((hash ^ ord(c)) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+  return hash
+
 def write_rule(file, element, parent_name, space, last) :
 
   if len(parent_name) :
@@ -112,10 +120,10 @@ def write_rule(file, element, parent_name, space, last) :
       element_type = "class"
   else :
     element_type = element.type
-  file.write("%sCFGObject_RULE(\"%s\", %s, %s, &%s, \"%s\")" % \
+  file.write("%sCFGObject_RULE(\"%s\", %s, %s, &%s, CFGObject_%s_TYPE)" % \
         (space, name, 
           "true" if element.exist else "false",
-          "true" if element.compress else "false", name, element_type))
+          "true" if element.compress else "false", name, element_type.upper()))
   if not last :
     file.write(",")
   file.write("\n")
@@ -159,6 +167,19 @@ def write_class(file, elements, class_name, current_level, target_level) :
           CLASS_CREATOR.append(class_name[10:])
     file.write("    CFG_INTERNAL_ERROR(\"%s does not support child %%s\", name.c_str());\n" % (class_name))
     file.write("  }\n\n")  
+    # Rule index
+    hashes = []
+    file.write("  size_t get_rule_index(const std::string& name) const\n")
+    file.write("  {\n")
+    file.write("    switch (CFGObject_hash(name.c_str())) {\n")
+    for i, element in enumerate(elements) :
+      hash = get_name_hash(element.name)
+      assert hash not in hashes, "%s element %s name hash collides" % (class_name, element.name)
+      hashes.append(hash)
+      file.write("      case CFGObject_hash(\"%s\"): return %d;\n" % (element.name, i))
+    file.write("      default: return rules.size();\n")
+    file.write("    }\n")
+    file.write("  }\n\n")
     # Members
     for element in elements :
       if element.type == None :
@@ -169,6 +169,16 @@ void CFGObject::parse(const std::string& input_filepath,
   file << "  Total Object: " << object_count << "\n";
   CFG_ASSERT(index < input_data.size());
 
+  if (input_data[index] == CFGOBJECT_INDEX_TYPE) {
+    std::vector<std::pair<std::string, size_t>> entries =
+        CFGObject::read_index(&input_data[0], input_data.size(), index);
+    file << "  Index\n";
+    for (auto& entry : entries) {
+      file << "    " << entry.first.c_str()
+           << CFG_print(" - offset: 0x%08lX\n", entry.second).c_str();
+    }
+  }
+
   file << "  Objects\n";
   size_t parsed_object_count = 0;
   while (index < input_data.size()) {
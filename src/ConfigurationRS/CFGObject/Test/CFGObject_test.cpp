@@ -1,3 +1,6 @@
+#include <chrono>
+#include <filesystem>
+
 #include "CFGCommonRS/CFGCommonRS.h"
 #include "CFGObject_auto.h"
 #include "nlohmann_json/json.hpp"
@@ -19,8 +22,245 @@ const std::vector<std::string> FIRST_TEST_OBJECT_ERRORS = {
 const std::vector<std::string> SECOND_TEST_OBJECT_ERRORS = {
     "u64s does not exist", "str0 does not exist"};
 
+// Exposes the protected serialization helpers
+class CFGObject_TEST : public CFGObject {
+ public:
+  using CFGObject::get_serialized_size;
+  using CFGObject::is_compression_worthy;
+};
+
+// Mandatory BITOBJ members
+static void test_bitobj_header(CFGObject_BITOBJ& bitobj) {
+  bitobj.write_str("version", "Test");
+  bitobj.write_str("project", "cfgobject_test");
+  bitobj.write_str("device", "Test");
+  bitobj.configuration.write_str("family", "Gemini");
+  bitobj.configuration.write_str("series", "Gemini");
+  bitobj.configuration.write_str("protocol", "BOP");
+  bitobj.configuration.write_str("blwl", "BL");
+  bitobj.write_str("time", "Now");
+}
+
+static std::vector<uint8_t> test_random_data(size_t size, uint32_t seed) {
+  std::vector<uint8_t> data(size);
+  for (auto& d : data) {
+    seed = seed * 1664525 + 1013904223;
+    d = (uint8_t)(seed >> 24);
+  }
+  return data;
+}
+
+void test_serialize_helpers() {
+  CFG_POST_MSG("CFGObject Serialize Helpers Test");
+  CFGObject_TEST object;
+  // Byte array as it is, others 7 bits per byte of their own width
+  CFG_ASSERT(object.get_serialized_size(std::vector<uint8_t>(100, 0xFF)) ==
+             100);
+  CFG_ASSERT(object.get_serialized_size(std::vector<uint16_t>(
+                 {0, 0x7F, 0x80, 0x3FFF, 0x4000, 0xFFFF})) == 12);
+  CFG_ASSERT(object.get_serialized_size(std::vector<uint32_t>(
+                 {0x0FFFFFFF, 0x10000000})) == 9);
+  CFG_ASSERT(object.get_serialized_size(std::vector<int32_t>({-1, 1})) == 6);
+  CFG_ASSERT(object.get_serialized_size(std::vector<uint64_t>(
+                 {0xFFFFFFFFFFFFFFFF})) == 10);
+  CFG_ASSERT(object.get_serialized_size(std::vector<int64_t>({-1, 0})) == 11);
+  // Up to 256KB compression is always tried, above it a sample decides
+  const size_t threshold = 256 * 1024;
+  std::vector<uint8_t> random = test_random_data(threshold + 1, 0x243F6A88);
+  std::vector<uint8_t> zero(threshold + 1, 0);
+  CFG_ASSERT(
+      CFGObject_TEST::is_compression_worthy(&random[0], threshold, threshold));
+  CFG_ASSERT(!CFGObject_TEST::is_compression_worthy(&random[0], random.size(),
+                                                    random.size()));
+  CFG_ASSERT(
+      CFGObject_TEST::is_compression_worthy(&zero[0], threshold, threshold));
+  CFG_ASSERT(CFGObject_TEST::is_compression_worthy(&zero[0], zero.size(),
+                                                   zero.size()));
+}
+
+void test_u8s_round_trip() {
+  CFG_POST_MSG("CFGObject U8S Round Trip Test");
+  // Compressed rule with small, incompressible and compressible arrays
+  for (size_t size : {1, 1000, 256 * 1024, 300 * 1024}) {
+    std::vector<uint8_t> random = test_random_data(size, (uint32_t)(size));
+    std::vector<uint8_t> sparse(size, 0);
+    for (size_t i = 0; i < size; i += 97) {
+      sparse[i] = (uint8_t)(i >> 3);
+    }
+    CFGObject_BITOBJ bitobj;
+    test_bitobj_header(bitobj);
+    bitobj.icb.write_u32("bits", (uint32_t)(size * 8));
+    bitobj.icb.write_u8s("data", random);
+    bitobj.post_icb.write_u32("bits", (uint32_t)(size * 8));
+    bitobj.post_icb.write_u8s("data", sparse);
+    CFG_ASSERT(bitobj.write("bitobj_u8s.bin"));
+    CFGObject_BITOBJ rdback;
+    CFG_ASSERT(rdback.read("bitobj_u8s.bin"));
+    CFG_ASSERT(rdback.icb.data == random);
+    CFG_ASSERT(rdback.post_icb.data == sparse);
+  }
+  std::remove("bitobj_u8s.bin");
+}
+
+// BITOBJ bigger than the 1MB buffer of the file writer, with an
+// incompressible and a compressible member
+static void test_writer_bitobj(CFGObject_BITOBJ& bitobj) {
+  const size_t size = 3 * 1024 * 1024 + 123;
+  std::vector<uint8_t> sparse(size, 0);
+  for (size_t i = 0; i < size; i += 97) {
+    sparse[i] = (uint8_t)(i >> 3);
+  }
+  test_bitobj_header(bitobj);
+  bitobj.icb.write_u32("bits", (uint32_t)(size * 8));
+  bitobj.icb.write_u8s("data", test_random_data(size, 0x9B05688C));
+  bitobj.post_icb.write_u32("bits", (uint32_t)(size * 8));
+  bitobj.post_icb.write_u8s("data", sparse);
+}
+
+void test_large_write() {
+  CFG_POST_MSG("CFGObject Large Write Test");
+  CFGObject_BITOBJ bitobj;
+  test_writer_bitobj(bitobj);
+  // Without index: same bytes as the in-memory writer it replaced
+  CFG_ASSERT(bitobj.write("bitobj_large.bin"));
+  std::vector<uint8_t> data;
+  CFG_read_binary_file("bitobj_large.bin", data);
+  CFG_ASSERT(data.size() == 3242981);
+  CFG_ASSERT(CFG_crc32(&data[0], data.size()) == 0xFBEABFEC);
+  CFG_ASSERT(!std::filesystem::exists("bitobj_large.bin.tmp"));
+  // With index: the offsets are patched after the buffer had been flushed,
+  // full read checks the CRC recalculated over the patched file
+  CFG_ASSERT(bitobj.write("bitobj_large.bin", nullptr, true));
+  CFGObject_BITOBJ rdback;
+  CFG_ASSERT(rdback.read("bitobj_large.bin"));
+  CFG_ASSERT(rdback.icb.data == bitobj.icb.data);
+  CFG_ASSERT(rdback.post_icb.data == bitobj.post_icb.data);
+  CFG_ASSERT(rdback.configuration.blwl == "BL");
+  CFGObject_BITOBJ lazy;
+  CFG_ASSERT(lazy.read("bitobj_large.bin", {"post_icb", "time"}));
+  CFG_ASSERT(lazy.post_icb.data == bitobj.post_icb.data);
+  CFG_ASSERT(lazy.time == "Now");
+  CFG_ASSERT(lazy.icb.data.size() == 0);
+  CFG_ASSERT(!std::filesystem::exists("bitobj_large.bin.tmp"));
+  // Segmented compression (CFG_CMP version 1) reads back the same
+  CFG_ASSERT(bitobj.write("bitobj_large.bin", nullptr, true, 1));
+  CFG_read_binary_file("bitobj_large.bin", data);
+  const uint8_t magic[] = {'C', 'F', 'G', '_', 'C', 'M', 'P', 1};
+  CFG_ASSERT(std::search(data.begin(), data.end(), magic,
+                         magic + sizeof(magic)) != data.end());
+  CFGObject_BITOBJ segmented;
+  CFG_ASSERT(segmented.read("bitobj_large.bin"));
+  CFG_ASSERT(segmented.icb.data == bitobj.icb.data);
+  CFG_ASSERT(segmented.post_icb.data == bitobj.post_icb.data);
+  std::remove("bitobj_large.bin");
+}
+
+void test_lazy_list_read() {
+  CFG_POST_MSG("CFGObject Lazy List Read Test");
+  CFGObject_DEV_DDB ddb;
+  ddb.write_strs("family", {"Gemini", "Virgo"});
+  ddb.write_strs("series", {"A", "B"});
+  ddb.write_strs("protocol", {"jtag"});
+  ddb.write_strs("blwl", {"BL", "WL"});
+  for (uint32_t i = 0; i < 100; i++) {
+    ddb.create_child("device");
+    ddb.device.back()->write_str("name", CFG_print("device%d", i));
+    ddb.device.back()->write_u32s("data", {i % 2, i % 2, 0, i % 2});
+  }
+  // Only the element with matching key is decoded, with and without index
+  for (bool index : {false, true}) {
+    CFG_ASSERT(ddb.write("ddb.bin", nullptr, index));
+    CFGObject_DEV_DDB lazy;
+    CFG_ASSERT(lazy.read("ddb.bin", {"family", "device"}, nullptr, "name",
+                         "device51"));
+    CFG_ASSERT(lazy.family == ddb.family);
+    CFG_ASSERT(lazy.series.size() == 0);
+    CFG_ASSERT(lazy.device.size() == 1);
+    CFG_ASSERT(lazy.device.back()->name == "device51");
+    CFG_ASSERT(lazy.device.back()->data == ddb.device[51]->data);
+    std::vector<std::string> errors;
+    CFGObject_DEV_DDB missing;
+    CFG_ASSERT(!missing.read("ddb.bin", {"device"}, &errors, "name", "none"));
+    CFG_ASSERT(missing.device.size() == 0);
+    CFG_ASSERT(errors.size() == 1);
+  }
+  std::remove("ddb.bin");
+}
+
+void test_append_benchmark() {
+  CFG_POST_MSG("CFGObject Append Benchmark");
+  // Element by element append goes through rule lookup and type check
+  const size_t count = 4 * 1024 * 1024;
+  CFGObject_BITOBJ bitobj;
+  test_bitobj_header(bitobj);
+  bitobj.icb.write_u32("bits", (uint32_t)(count * 8));
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    bitobj.icb.append_u8("data", (uint8_t)(i % 7 == 0 ? i : 0));
+  }
+  auto append_end = std::chrono::steady_clock::now();
+  CFG_ASSERT(bitobj.write("bitobj_benchmark.bin"));
+  auto write_end = std::chrono::steady_clock::now();
+  CFGObject_BITOBJ rdback;
+  CFG_ASSERT(rdback.read("bitobj_benchmark.bin"));
+  auto read_end = std::chrono::steady_clock::now();
+  CFG_ASSERT(rdback.icb.bits == (uint32_t)(count * 8));
+  CFG_ASSERT(rdback.icb.data == bitobj.icb.data);
+  CFG_ASSERT(rdback.configuration.blwl == "BL");
+  CFG_POST_MSG("!!! Result: %ld elements appended in %.3f ms, write %.3f ms, "
+               "read %.3f ms",
+               count,
+               std::chrono::duration<double, std::milli>(append_end - start)
+                   .count(),
+               std::chrono::duration<double, std::milli>(write_end -
+                                                         append_end)
+                   .count(),
+               std::chrono::duration<double, std::milli>(read_end - write_end)
+                   .count());
+  std::remove("bitobj_benchmark.bin");
+}
+
+void test_serialize_benchmark() {
+  CFG_POST_MSG("CFGObject Serialize Benchmark");
+  // Large byte arrays, one does not compress and one does
+  const size_t size = 32 * 1024 * 1024;
+  CFGObject_BITOBJ bitobj;
+  test_bitobj_header(bitobj);
+  std::vector<uint8_t> random(size);
+  std::vector<uint8_t> sparse(size, 0);
+  uint32_t seed = 0x510E527F;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1664525 + 1013904223;
+    random[i] = (uint8_t)(seed >> 24);
+    if ((seed & 0xFF) < 8) {
+      sparse[i] = (uint8_t)(seed >> 8);
+    }
+  }
+  bitobj.icb.write_u32("bits", (uint32_t)(size * 8));
+  bitobj.icb.write_u8s("data", random);
+  bitobj.post_icb.write_u32("bits", (uint32_t)(size * 8));
+  bitobj.post_icb.write_u8s("data", sparse);
+  auto start = std::chrono::steady_clock::now();
+  CFG_ASSERT(bitobj.write("bitobj_benchmark.bin"));
+  auto write_end = std::chrono::steady_clock::now();
+  CFGObject_BITOBJ rdback;
+  CFG_ASSERT(rdback.read("bitobj_benchmark.bin"));
+  auto read_end = std::chrono::steady_clock::now();
+  CFG_ASSERT(rdback.icb.data == random);
+  CFG_ASSERT(rdback.post_icb.data == sparse);
+  CFG_POST_MSG("!!! Result: 2x %ld MB written in %.3f ms, read %.3f ms",
+               size / (1024 * 1024),
+               std::chrono::duration<double, std::milli>(write_end - start)
+                   .count(),
+               std::chrono::duration<double, std::milli>(read_end - write_end)
+                   .count());
+  std::remove("bitobj_benchmark.bin");
+}
+
 int main(int argc, const char** argv) {
   CFG_POST_MSG("This is CFGObject unit test");
+  // Benchmarks only run on request: cfgobject_test --benchmark
+  bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
   CFGObject_UTST utst;
   std::vector<std::string> errors;
   CFG_ASSERT(!utst.write("utst.bin", &errors));
@@ -135,5 +375,33 @@ int main(int argc, const char** argv) {
   CFG_ASSERT(rdback.strs[3] == "");
   CFG_ASSERT(rdback.strs[4] == "jkl");
   CFG_ASSERT(rdback.data_after_cmp == 0x1234567890ABCDEF);
+
+  // Lazy read with and without index, only requested members are decoded
+  CFG_ASSERT(utst.write("utst_index.bin", &errors, true));
+  CFGObject_UTST index_rdback;
+  CFG_ASSERT(index_rdback.read("utst_index.bin", &errors));
+  CFG_ASSERT(index_rdback.get_object_count() == rdback.get_object_count());
+  CFG_ASSERT(index_rdback.strs == rdback.strs);
+  for (std::string filepath : {"utst.bin", "utst_index.bin"}) {
+    CFGObject_UTST lazy;
+    CFG_ASSERT(lazy.read(filepath, {"cmp", "list0", "data_after_cmp"}));
+    CFG_ASSERT(lazy.cmp == cmp_test_data);
+    CFG_ASSERT(lazy.list0.size() == 1);
+    CFG_ASSERT(lazy.list0.back()->u64 == 1);
+    CFG_ASSERT(lazy.list0.back()->i32s.size() == 3);
+    CFG_ASSERT(lazy.data_after_cmp == 0x1234567890ABCDEF);
+    CFG_ASSERT(lazy.u8s.size() == 0);
+    CFG_ASSERT(lazy.strs.size() == 0);
+    CFG_ASSERT(!lazy.check_exist("object"));
+  }
+  CFG_ASSERT(errors.size() == 0);
+  test_serialize_helpers();
+  test_u8s_round_trip();
+  test_large_write();
+  test_lazy_list_read();
+  if (benchmark) {
+    test_append_benchmark();
+    test_serialize_benchmark();
+  }
   return 0;
 }
@@ -3,6 +3,7 @@
 #include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
 #include "OclaHelpers.h"
 #include "OclaJtagAdapter.h"
+#include "OclaJtagBatch.h"
 
 #define MAX_IO_INPUT_REG (2)
 #define MAX_IO_OUTPUT_REG (2)
@@ -17,6 +18,16 @@ EioIP::EioIP(OclaJtagAdapter *adapter, uint32_t baseaddr)
   read_registers();
 }
 
+EioIP::EioIP(OclaJtagAdapter *adapter, uint32_t baseaddr, OclaJtagBatch &batch)
+    : m_adapter(adapter),
+      m_baseaddr(baseaddr),
+      m_ctrl(0),
+      m_type(0),
+      m_version(0),
+      m_id(0) {
+  queue_read_registers(batch);
+}
+
 EioIP::~EioIP() {}
 
 std::string EioIP::get_type() const {
@@ -46,9 +57,11 @@ void EioIP::write_output_bits(std::vector<uint32_t> values, uint32_t length) {
   CFG_ASSERT(length > 0);
   CFG_ASSERT(length <= MAX_IO_OUTPUT_REG);
   CFG_ASSERT(values.size() >= length);
+  OclaJtagBatch batch{m_adapter};
   for (uint32_t i = 0; i < length; i++) {
-    m_adapter->write(m_baseaddr + EIO_AXI_DAT_OUT + (i << 2), values[i]);
+    batch.write(m_baseaddr + EIO_AXI_DAT_OUT + (i << 2), values[i]);
   }
+  batch.flush();
 }
 
 std::vector<uint32_t> EioIP::read_bits(uint32_t addr, uint32_t length) {
@@ -82,10 +95,16 @@ std::vector<uint32_t> EioIP::read_input_bits(uint32_t length) {
   return read_bits(m_baseaddr + EIO_AXI_DAT_IN, length);
 }
 
+void EioIP::queue_read_registers(OclaJtagBatch &batch) {
+  batch.read(m_baseaddr + EIO_CTRL, &m_ctrl);
+  batch.read(m_baseaddr + EIO_IP_TYPE, &m_type);
+  batch.read(m_baseaddr + EIO_IP_VERSION, &m_version);
+  batch.read(m_baseaddr + EIO_IP_ID, &m_id);
+}
+
 void EioIP::read_registers() {
   CFG_ASSERT(m_adapter != nullptr);
-  m_ctrl = m_adapter->read(m_baseaddr + EIO_CTRL);
-  m_type = m_adapter->read(m_baseaddr + EIO_IP_TYPE);
-  m_version = m_adapter->read(m_baseaddr + EIO_IP_VERSION);
-  m_id = m_adapter->read(m_baseaddr + EIO_IP_ID);
+  OclaJtagBatch batch{m_adapter};
+  queue_read_registers(batch);
+  batch.flush();
 }
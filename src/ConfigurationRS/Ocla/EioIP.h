@@ -20,12 +20,16 @@
 #define EIO_CTRL_PRS_Msk (((1u << EIO_CTRL_PRS_Width) - 1) << EIO_CTRL_PRS_Pos)
 
 class OclaJtagAdapter;
+class OclaJtagBatch;
 
 enum eio_prs_mode { PROBE_IN = 0, PROBE_OUT = 1 };
 
 class EioIP {
  public:
   EioIP(OclaJtagAdapter *adapter, uint32_t baseaddr);
+  // queue the register reads into the caller's batch. the getters are valid
+  // once the batch is flushed.
+  EioIP(OclaJtagAdapter *adapter, uint32_t baseaddr, OclaJtagBatch &batch);
   ~EioIP();
   std::string get_type() const;
   uint32_t get_version() const;
@@ -39,6 +43,7 @@ class EioIP {
  private:
   std::vector<uint32_t> read_bits(uint32_t addr, uint32_t length);
   void read_registers();
+  void queue_read_registers(OclaJtagBatch &batch);
   OclaJtagAdapter *m_adapter;
   uint32_t m_baseaddr;
   uint32_t m_ctrl;
@@ -1,5 +1,7 @@
 #include "Ocla.h"
 
+#include <algorithm>
+#include <list>
 #include <map>
 
 #include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
@@ -7,6 +9,7 @@
 #include "OclaHelpers.h"
 #include "OclaIP.h"
 #include "OclaJtagAdapter.h"
+#include "OclaJtagBatch.h"
 
 #define EIO_IP_TYPE_STRING "EIO"
 
@@ -632,6 +635,13 @@ void Ocla::show_instance_info() {
 }
 
 bool Ocla::get_waveform(uint32_t domain_id, oc_waveform_t &output) {
+  std::atomic<bool> stop = false;
+  return get_waveform(domain_id, output, stop);
+}
+
+bool Ocla::get_waveform(uint32_t domain_id, oc_waveform_t &output,
+                        std::atomic<bool> &stop,
+                        ocla_progress_callback progress) {
   CFG_ASSERT(m_adapter != nullptr);
 
   OclaDebugSession *session = nullptr;
@@ -641,16 +651,56 @@ bool Ocla::get_waveform(uint32_t domain_id, oc_waveform_t &output) {
     return false;
   }
 
-  // retrieve samples from all OCLA instances of the clock domain
+  // retrieve samples from all OCLA instances of the clock domain. the
+  // uploads are interleaved: every round queues the next chunk of each
+  // instance into one batch so all instances share a single jtag round trip.
+  // the upload progress is reported over the total of all instances.
   std::map<uint32_t, ocla_data> sample_data{};
+  std::vector<std::pair<OclaIP, ocla_data *>> uploads{};
+  std::vector<uint32_t> offsets{};
+  uint32_t total_words = 0;
+  uint32_t words_done = 0;
 
   for (auto &instance : domain->get_instances()) {
     OclaIP ocla_ip{m_adapter, instance.get_baseaddr()};
-    sample_data[instance.get_index()] = ocla_ip.get_data();
+    auto &data = sample_data[instance.get_index()];
+    data = ocla_ip.get_data_format();
+    data.values.resize(data.depth * data.words_per_line);
+    total_words += data.values.size();
+    uploads.emplace_back(ocla_ip, &data);
+    offsets.push_back(0);
+  }
+
+  // without a session every round trip starts an openocd process, the whole
+  // upload then goes in a single batch
+  uint32_t chunk_size = OCLA_TBDR_CHUNK_SIZE;
+  if (!m_adapter->is_session_open()) {
+    chunk_size = std::max(1u, total_words);
   }
 
-  // transform flat sample data into logical format by probes and signals
+  while (words_done < total_words) {
+    if (stop) {
+      CFG_POST_WARNING("Waveform upload cancelled");
+      return false;
+    }
+    OclaJtagBatch batch{m_adapter};
+    for (size_t i = 0; i < uploads.size(); i++) {
+      uint32_t n = uploads[i].first.queue_data(batch, *uploads[i].second,
+                                               offsets[i], chunk_size);
+      offsets[i] += n;
+      words_done += n;
+    }
+    batch.flush();
+    if (progress) {
+      progress(words_done, total_words);
+    }
+  }
+
+  // transform flat sample data into logical format by probes and signals.
+  // the layout is built first so that the signals can be unpacked in
+  // parallel without changing the probe and signal ordering.
   std::vector<oc_probe_t> probes{};
+  std::vector<std::pair<oc_signal_t *, ocla_data *>> signals{};
 
   for (auto &probe : domain->get_probes()) {
     oc_probe_t probe_data{};
@@ -668,14 +718,6 @@ bool Ocla::get_waveform(uint32_t domain_id, oc_waveform_t &output) {
       signal_data.values.assign(signal_data.words_per_line * signal_data.depth,
                                 0);
 
-      // copy sample
-      for (uint32_t i = 0; i < data.depth; i++) {
-        CFG_copy_bits_vec32(
-            &data.values.at(i * data.words_per_line), signal_data.bitpos,
-            &signal_data.values.at(i * signal_data.words_per_line), 0,
-            signal_data.bitwidth);
-      }
-
       probe_data.signal_list.push_back(signal_data);
     }
 
@@ -683,8 +725,30 @@ bool Ocla::get_waveform(uint32_t domain_id, oc_waveform_t &output) {
     probes.push_back(probe_data);
   }
 
+  uint32_t p = 0;
+  for (auto &probe : domain->get_probes()) {
+    auto &data = sample_data[probe.get_instance_index()];
+    for (auto &signal_data : probes[p++].signal_list) {
+      signals.emplace_back(&signal_data, &data);
+    }
+  }
+
+  // copy every signal out of all samples, the signals are unpacked in
+  // parallel
+  CFG_parallel_for(signals.size(), 0, [&](size_t k) {
+    auto &signal_data = *signals[k].first;
+    auto &data = *signals[k].second;
+    CFG_ASSERT(signal_data.bitpos + signal_data.bitwidth <=
+               data.words_per_line * 32);
+    if (data.depth > 0) {
+      CFG_extract_field_vec32(data.values.data(), data.words_per_line,
+                              signal_data.bitpos, signal_data.values.data(),
+                              signal_data.bitwidth, data.depth);
+    }
+  });
+
   output.domain_id = domain->get_index();
-  output.probes = probes;
+  output.probes = std::move(probes);
 
   return true;
 }
@@ -765,54 +829,72 @@ bool Ocla::verify(OclaDebugSession *session) {
 
   uint32_t error_count = 0;
 
+  // latch the id registers of all the instances in a single batch. std::list
+  // keeps the ip objects in place until the batch is flushed.
+  OclaJtagBatch batch{m_adapter};
+  std::list<std::pair<OclaInstance *, OclaIP>> ocla_ips{};
+  std::list<std::pair<EioInstance *, EioIP>> eio_ips{};
+
   for (auto &domain : session->get_clock_domains()) {
     for (auto &instance : domain.get_instances()) {
-      OclaIP ocla_ip{m_adapter, instance.get_baseaddr()};
+      ocla_ips.emplace_back(
+          std::piecewise_construct, std::forward_as_tuple(&instance),
+          std::forward_as_tuple(m_adapter, instance.get_baseaddr(), batch));
+    }
+  }
 
-      if (ocla_ip.get_type() != instance.get_type()) {
-        CFG_POST_ERR("Could not detect instance %d at 0x%08x",
-                     instance.get_index(), instance.get_baseaddr());
-        ++error_count;
-        continue;
-      }
+  for (auto &instance : session->get_eio_instances()) {
+    eio_ips.emplace_back(
+        std::piecewise_construct, std::forward_as_tuple(&instance),
+        std::forward_as_tuple(m_adapter, instance.get_baseaddr(), batch));
+  }
 
-      if (ocla_ip.get_version() != instance.get_version()) {
-        CFG_POST_ERR(
-            "Instance %d version mismatched (expected=0x%x, actual=0x%x)",
-            instance.get_index(), instance.get_version(),
-            ocla_ip.get_version());
-        ++error_count;
-      }
+  batch.flush();
 
-      if (ocla_ip.get_id() != instance.get_id()) {
-        CFG_POST_ERR("Instance %d ID mismatched (expected=0x%x, actual=0x%x)",
-                     instance.get_index(), instance.get_id(), ocla_ip.get_id());
-        ++error_count;
-      }
+  for (auto &[instance, ocla_ip] : ocla_ips) {
+    if (ocla_ip.get_type() != instance->get_type()) {
+      CFG_POST_ERR("Could not detect instance %d at 0x%08x",
+                   instance->get_index(), instance->get_baseaddr());
+      ++error_count;
+      continue;
+    }
 
-      if (ocla_ip.get_memory_depth() != instance.get_memory_depth()) {
-        CFG_POST_ERR(
-            "Instance %d memory depth mismatched (expected=%d, actual=%d)",
-            instance.get_index(), instance.get_memory_depth(),
-            ocla_ip.get_memory_depth());
-        ++error_count;
-      }
+    if (ocla_ip.get_version() != instance->get_version()) {
+      CFG_POST_ERR(
+          "Instance %d version mismatched (expected=0x%x, actual=0x%x)",
+          instance->get_index(), instance->get_version(),
+          ocla_ip.get_version());
+      ++error_count;
+    }
 
-      if (ocla_ip.get_number_of_probes() != instance.get_num_of_probes()) {
-        CFG_POST_ERR(
-            "Instance %d no. of probes mismatched (expected=%d, actual=%d)",
-            instance.get_index(), instance.get_num_of_probes(),
-            ocla_ip.get_number_of_probes());
-        ++error_count;
-      }
+    if (ocla_ip.get_id() != instance->get_id()) {
+      CFG_POST_ERR("Instance %d ID mismatched (expected=0x%x, actual=0x%x)",
+                   instance->get_index(), instance->get_id(),
+                   ocla_ip.get_id());
+      ++error_count;
+    }
+
+    if (ocla_ip.get_memory_depth() != instance->get_memory_depth()) {
+      CFG_POST_ERR(
+          "Instance %d memory depth mismatched (expected=%d, actual=%d)",
+          instance->get_index(), instance->get_memory_depth(),
+          ocla_ip.get_memory_depth());
+      ++error_count;
+    }
+
+    if (ocla_ip.get_number_of_probes() != instance->get_num_of_probes()) {
+      CFG_POST_ERR(
+          "Instance %d no. of probes mismatched (expected=%d, actual=%d)",
+          instance->get_index(), instance->get_num_of_probes(),
+          ocla_ip.get_number_of_probes());
+      ++error_count;
     }
   }
 
-  for (auto &instance : session->get_eio_instances()) {
-    EioIP eio{m_adapter, instance.get_baseaddr()};
+  for (auto &[instance, eio] : eio_ips) {
     if (eio.get_type() != EIO_IP_TYPE_STRING) {
       CFG_POST_ERR("Could not detect EIO instance %d at 0x%08x",
-                   instance.get_index(), instance.get_baseaddr());
+                   instance->get_index(), instance->get_baseaddr());
       ++error_count;
       continue;
     }
@@ -870,7 +952,7 @@ bool Ocla::start(uint32_t domain_id) {
   return true;
 }
 
-void Ocla::start_session(std::string filepath) {
+bool Ocla::start_session(std::string filepath) {
   CFG_ASSERT(m_adapter != nullptr);
 
   // NOTE:
@@ -878,12 +960,12 @@ void Ocla::start_session(std::string filepath) {
   // support multiple debug sessions in the future.
   if (!m_sessions.empty()) {
     CFG_POST_ERR("Debug session is already loaded");
-    return;
+    return false;
   }
 
   if (!std::filesystem::exists(filepath)) {
     CFG_POST_ERR("File '%s' not found", filepath.c_str());
-    return;
+    return false;
   }
 
   std::vector<std::string> error_messages{};
@@ -891,6 +973,7 @@ void Ocla::start_session(std::string filepath) {
 
   if (session.load(filepath, error_messages)) {
     m_sessions.push_back(session);
+    return true;
   } else {
     // print loading/parsing error message if any returned
     for (auto &msg : error_messages) {
@@ -898,6 +981,8 @@ void Ocla::start_session(std::string filepath) {
     }
     CFG_POST_ERR("Failed to load user design");
   }
+
+  return false;
 }
 
 void Ocla::stop_session() {
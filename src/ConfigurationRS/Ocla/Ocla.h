@@ -1,6 +1,7 @@
 #ifndef __OCLA_H__
 #define __OCLA_H__
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -51,9 +52,12 @@ class Ocla {
                     uint32_t compare_width);
   void remove_trigger(uint32_t domain_id, uint32_t trigger_index);
   bool get_waveform(uint32_t domain_id, oc_waveform_t &output);
+  bool get_waveform(uint32_t domain_id, oc_waveform_t &output,
+                    std::atomic<bool> &stop,
+                    ocla_progress_callback progress = nullptr);
   bool get_status(uint32_t domain_id, uint32_t &status);
   bool start(uint32_t domain_id);
-  void start_session(std::string filepath);
+  bool start_session(std::string filepath);
   bool set_io(std::vector<std::string> signal_list);
   bool get_io(std::vector<std::string> signal_list,
               std::vector<eio_value_t> &output);
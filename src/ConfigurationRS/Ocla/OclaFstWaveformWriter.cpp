@@ -1,7 +1,9 @@
 #include "OclaFstWaveformWriter.h"
 
+#include <string.h>
 #include <time.h>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <string>
@@ -21,7 +23,7 @@ struct fst_signal_var_t {
 };
 
 bool OclaFstWaveformWriter::write(oc_waveform_t& waveform,
-                                  std::string filepath) {
+                                  std::string filepath, bool all_samples) {
   std::vector<fst_signal_var_t> fst_signals{};
   uint32_t max_depth = 0;
 
@@ -59,15 +61,51 @@ bool OclaFstWaveformWriter::write(oc_waveform_t& waveform,
     fstWriterSetUpscope(fst);
   }
 
-  // write waveform
+  // collect the value changes. the history of every signal is contiguous in
+  // oc_signal_t (column view) so it is scanned one signal at a time. the
+  // changes are bucketed by time in two passes (count then fill) so that
+  // they can be emitted in time order without storing them twice.
+  auto scan = [&](uint32_t k, auto&& on_change) {
+    auto& signal = fst_signals[k].signal;
+    const uint32_t* prev = nullptr;
+    for (uint32_t i = 0; i < signal.depth; i++) {
+      const uint32_t* line = &signal.values[i * signal.words_per_line];
+      if (all_samples || prev == nullptr ||
+          memcmp(prev, line, signal.words_per_line * sizeof(uint32_t)) != 0) {
+        on_change(i);
+      }
+      prev = line;
+    }
+  };
+
+  std::vector<uint32_t> changes_per_time(max_depth + 1, 0);
+  for (uint32_t k = 0; k < fst_signals.size(); k++) {
+    auto& signal = fst_signals[k].signal;
+    CFG_ASSERT(signal.values.size() >= signal.depth * signal.words_per_line);
+    scan(k, [&](uint32_t i) { changes_per_time[i + 1]++; });
+  }
+  for (uint32_t i = 0; i < max_depth; i++) {
+    changes_per_time[i + 1] += changes_per_time[i];
+  }
+  std::vector<uint32_t> ordered(changes_per_time[max_depth]);
+  for (uint32_t k = 0; k < fst_signals.size(); k++) {
+    scan(k, [&](uint32_t i) { ordered[changes_per_time[i]++] = k; });
+  }
+
+  // write waveform. changes_per_time[i] now holds the end of the changes of
+  // time i in ordered[]
+  uint32_t index = 0;
   for (uint32_t i = 0; i < max_depth; i++) {
+    // always emit the last sample time so the waveform keeps its length
+    if (index == changes_per_time[i] && i + 1 < max_depth) {
+      continue;
+    }
     fstWriterEmitTimeChange(fst, i);
-    for (auto& var : fst_signals) {
-      if (i < var.signal.depth) {
-        fstWriterEmitValueChangeVec32(
-            fst, var.handle, var.signal.bitwidth,
-            &var.signal.values.at(i * var.signal.words_per_line));
-      }
+    for (; index < changes_per_time[i]; index++) {
+      auto& var = fst_signals[ordered[index]];
+      fstWriterEmitValueChangeVec32(
+          fst, var.handle, var.signal.bitwidth,
+          &var.signal.values[i * var.signal.words_per_line]);
     }
   }
 
@@ -5,7 +5,10 @@
 
 class OclaFstWaveformWriter {
  public:
-  bool write(oc_waveform_t &waveform, std::string filepath);
+  // only the value changes of each signal are written unless all_samples is
+  // set, in which case every signal is dumped at every sample time
+  bool write(oc_waveform_t &waveform, std::string filepath,
+             bool all_samples = false);
 };
 
 #endif  //__OCLAFSTWAVEFORMWRITER_H__
@@ -95,6 +95,65 @@ void CFG_copy_bits_vec32(uint32_t* data, uint32_t pos, uint32_t* output,
   }
 }
 
+void CFG_extract_bits_vec32(const uint32_t* src, uint32_t pos, uint32_t* dest,
+                            uint32_t nbits) {
+  // callee should make sure data ptr not out of bound
+  CFG_ASSERT(src != nullptr);
+  CFG_ASSERT(dest != nullptr);
+  if (nbits == 0) {
+    return;
+  }
+  const uint32_t* p = src + (pos / 32);
+  uint32_t shift = pos % 32;
+  uint32_t nwords = ((nbits - 1) / 32) + 1;
+  // the last source word touched by the field, never read beyond it
+  uint32_t last = (shift + nbits - 1) / 32;
+  for (uint32_t i = 0; i < nwords; i++) {
+    uint32_t value = p[i] >> shift;
+    if (shift && i + 1 <= last) {
+      value |= p[i + 1] << (32 - shift);
+    }
+    dest[i] = value;
+  }
+  if (nbits % 32) {
+    dest[nwords - 1] &= (1u << (nbits % 32)) - 1;
+  }
+}
+
+void CFG_extract_field_vec32(const uint32_t* src, uint32_t src_stride,
+                             uint32_t pos, uint32_t* dest, uint32_t nbits,
+                             uint32_t depth) {
+  // callee should make sure data ptr not out of bound
+  CFG_ASSERT(src != nullptr);
+  CFG_ASSERT(dest != nullptr);
+  if (nbits == 0) {
+    return;
+  }
+  src += pos / 32;
+  uint32_t shift = pos % 32;
+  if (shift + nbits <= 32) {
+    // the field sits in one source word: a plain strided shift and mask
+    // loop that the compiler can vectorize
+    uint32_t mask = nbits == 32 ? 0xffffffff : (1u << nbits) - 1;
+    for (uint32_t i = 0; i < depth; i++) {
+      dest[i] = (src[i * src_stride] >> shift) & mask;
+    }
+  } else if (nbits <= 32) {
+    // the field straddles two source words
+    uint32_t mask = nbits == 32 ? 0xffffffff : (1u << nbits) - 1;
+    for (uint32_t i = 0; i < depth; i++) {
+      const uint32_t* line = src + i * src_stride;
+      dest[i] = ((line[0] >> shift) | (line[1] << (32 - shift))) & mask;
+    }
+  } else {
+    uint32_t nwords = ((nbits - 1) / 32) + 1;
+    for (uint32_t i = 0; i < depth; i++) {
+      CFG_extract_bits_vec32(src + i * src_stride, shift, dest + i * nwords,
+                             nbits);
+    }
+  }
+}
+
 uint32_t CFG_parse_signal(std::string& signal_str, std::string& name,
                           uint32_t& bit_start, uint32_t& bit_end,
                           uint32_t& bit_width, uint64_t* value) {
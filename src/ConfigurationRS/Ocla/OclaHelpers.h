@@ -54,6 +54,18 @@ void CFG_write_bit_vec32(uint32_t *data, uint32_t pos, uint32_t value);
 void CFG_copy_bits_vec32(uint32_t *src, uint32_t pos, uint32_t *dest,
                          uint32_t dest_pos, uint32_t nbits);
 
+// copy the nbits wide field at bit pos of src to bit 0 of dest a word at a
+// time. the unused upper bits of the last dest word are cleared.
+void CFG_extract_bits_vec32(const uint32_t *src, uint32_t pos, uint32_t *dest,
+                            uint32_t nbits);
+
+// transposed extraction: copy the same (pos, nbits) field out of depth lines
+// of src_stride words each into consecutive dest lines of
+// ((nbits - 1) / 32) + 1 words, in a single pass over the samples.
+void CFG_extract_field_vec32(const uint32_t *src, uint32_t src_stride,
+                             uint32_t pos, uint32_t *dest, uint32_t nbits,
+                             uint32_t depth);
+
 uint32_t CFG_parse_signal(std::string &signal_str, std::string &name,
                           uint32_t &bit_start, uint32_t &bit_end,
                           uint32_t &bit_width, uint64_t *value = nullptr);
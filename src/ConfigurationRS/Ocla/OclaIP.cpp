@@ -1,8 +1,11 @@
 #include "OclaIP.h"
 
+#include <algorithm>
+
 #include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
 #include "OclaHelpers.h"
 #include "OclaJtagAdapter.h"
+#include "OclaJtagBatch.h"
 
 OclaIP::OclaIP(OclaJtagAdapter *adapter, uint32_t base_addr)
     : m_adapter(adapter),
@@ -18,6 +21,21 @@ OclaIP::OclaIP(OclaJtagAdapter *adapter, uint32_t base_addr)
   read_registers();
 }
 
+OclaIP::OclaIP(OclaJtagAdapter *adapter, uint32_t base_addr,
+               OclaJtagBatch &batch)
+    : m_adapter(adapter),
+      m_base_addr(base_addr),
+      m_type(0),
+      m_version(0),
+      m_id(0),
+      m_uidp0(0),
+      m_uidp1(0),
+      m_ocsr(0),
+      m_tmtr(0),
+      m_chregs({}) {
+  queue_read_registers(batch);
+}
+
 OclaIP::OclaIP() : m_adapter(nullptr), m_base_addr(0) {}
 
 OclaIP::~OclaIP() {}
@@ -109,9 +127,12 @@ void OclaIP::configure_channel(uint32_t channel, ocla_trigger_config &cfg) {
   }
 
   m_chregs[channel] = reg;
-  m_adapter->write(m_base_addr + TSSR + (channel * 0x30), reg.tssr);
-  m_adapter->write(m_base_addr + TCUR + (channel * 0x30), reg.tcur);
-  m_adapter->write(m_base_addr + TDCR + (channel * 0x30), reg.tdcr);
+
+  OclaJtagBatch batch{m_adapter};
+  batch.write(m_base_addr + TSSR + (channel * 0x30), reg.tssr);
+  batch.write(m_base_addr + TCUR + (channel * 0x30), reg.tcur);
+  batch.write(m_base_addr + TDCR + (channel * 0x30), reg.tdcr);
+  batch.flush();
 }
 
 void OclaIP::reset() {
@@ -132,9 +153,7 @@ void OclaIP::start() {
   m_adapter->write(m_base_addr + OCCR, (1u << OCCR_ST_Pos));
 }
 
-ocla_data OclaIP::get_data() const {
-  CFG_ASSERT(m_adapter != nullptr);
-
+ocla_data OclaIP::get_data_format() const {
   ocla_data data;
 
   if (m_tmtr & TMTR_FNS_Msk) {
@@ -145,6 +164,13 @@ ocla_data OclaIP::get_data() const {
 
   data.width = get_number_of_probes();
   data.words_per_line = ((data.width - 1) / 32) + 1;
+  return data;
+}
+
+ocla_data OclaIP::get_data() const {
+  CFG_ASSERT(m_adapter != nullptr);
+
+  ocla_data data = get_data_format();
   auto result =
       m_adapter->read(m_base_addr + TBDR, data.depth * data.words_per_line);
   for (auto const &value : result) {
@@ -153,29 +179,91 @@ ocla_data OclaIP::get_data() const {
   return data;
 }
 
-void OclaIP::read_registers() {
+bool OclaIP::get_data(ocla_data &data, std::atomic<bool> &stop,
+                      ocla_progress_callback progress,
+                      uint32_t chunk_size) const {
   CFG_ASSERT(m_adapter != nullptr);
+  CFG_ASSERT(chunk_size > 0);
+
+  data = get_data_format();
+
+  // every chunk holds whole sample lines so that a cancelled upload leaves
+  // only complete samples behind
+  uint32_t total = data.depth * data.words_per_line;
+  uint32_t lines_per_chunk = std::max(1u, chunk_size / data.words_per_line);
+  uint32_t words_per_chunk = lines_per_chunk * data.words_per_line;
+  uint32_t offset = 0;
+
+  data.values.resize(total);
+
+  while (offset < total) {
+    if (stop) {
+      data.depth = offset / data.words_per_line;
+      data.values.resize(offset);
+      return false;
+    }
+    uint32_t n = std::min(words_per_chunk, total - offset);
+    auto result = m_adapter->read(m_base_addr + TBDR, n);
+    CFG_ASSERT_MSG(result.size() == n,
+                   "values size is not equal to read requests");
+    for (uint32_t i = 0; i < n; i++) {
+      data.values[offset + i] = result[i].data;
+    }
+    offset += n;
+    if (progress) {
+      progress(offset, total);
+    }
+  }
+
+  return true;
+}
+
+uint32_t OclaIP::queue_data(OclaJtagBatch &batch, ocla_data &data,
+                            uint32_t offset, uint32_t chunk_size) const {
+  CFG_ASSERT(chunk_size > 0);
 
+  uint32_t total = data.depth * data.words_per_line;
+  CFG_ASSERT(data.values.size() >= total);
+  if (offset >= total) {
+    return 0;
+  }
+
+  uint32_t lines_per_chunk = std::max(1u, chunk_size / data.words_per_line);
+  uint32_t n = std::min(lines_per_chunk * data.words_per_line, total - offset);
+  batch.read(m_base_addr + TBDR, n, 0, &data.values[offset]);
+  return n;
+}
+
+void OclaIP::queue_read_registers(OclaJtagBatch &batch) {
   // latch all read-only registers
-  m_type = m_adapter->read(m_base_addr + IP_TYPE);
-  m_version = m_adapter->read(m_base_addr + IP_VERSION);
-  m_id = m_adapter->read(m_base_addr + IP_ID);
-  m_uidp0 = m_adapter->read(m_base_addr + UIDP0);
-  m_uidp1 = m_adapter->read(m_base_addr + UIDP1);
-  m_ocsr = m_adapter->read(m_base_addr + OCSR);
+  batch.read(m_base_addr + IP_TYPE, &m_type);
+  batch.read(m_base_addr + IP_VERSION, &m_version);
+  batch.read(m_base_addr + IP_ID, &m_id);
+  batch.read(m_base_addr + UIDP0, &m_uidp0);
+  batch.read(m_base_addr + UIDP1, &m_uidp1);
+  batch.read(m_base_addr + OCSR, &m_ocsr);
 
   // latch the global configuration register
-  m_tmtr = m_adapter->read(m_base_addr + TMTR);
-
-  // latch all channle configuration registers
-  for (uint32_t i = 0; i < get_trigger_count(); i++) {
-    ocla_channel_register reg{};
-    reg.tssr = m_adapter->read(m_base_addr + TSSR + (i * 0x30));
-    reg.tcur = m_adapter->read(m_base_addr + TCUR + (i * 0x30));
-    reg.tdcr = m_adapter->read(m_base_addr + TDCR + (i * 0x30));
-    reg.mask = m_adapter->read(m_base_addr + MASK + (i * 0x30));
-    m_chregs.push_back(reg);
+  batch.read(m_base_addr + TMTR, &m_tmtr);
+}
+
+void OclaIP::read_registers() {
+  CFG_ASSERT(m_adapter != nullptr);
+
+  OclaJtagBatch batch{m_adapter};
+  queue_read_registers(batch);
+  batch.flush();
+
+  // latch all channle configuration registers. the number of channels is
+  // only known once OCSR is read so they go in a second batch
+  m_chregs.resize(get_trigger_count());
+  for (uint32_t i = 0; i < m_chregs.size(); i++) {
+    batch.read(m_base_addr + TSSR + (i * 0x30), &m_chregs[i].tssr);
+    batch.read(m_base_addr + TCUR + (i * 0x30), &m_chregs[i].tcur);
+    batch.read(m_base_addr + TDCR + (i * 0x30), &m_chregs[i].tdcr);
+    batch.read(m_base_addr + MASK + (i * 0x30), &m_chregs[i].mask);
   }
+  batch.flush();
 }
 
 ocla_config OclaIP::get_config() const {
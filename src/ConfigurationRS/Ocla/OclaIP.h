@@ -1,7 +1,9 @@
 #ifndef __OCLAIP_H__
 #define __OCLAIP_H__
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -30,6 +32,9 @@
           // will be written to this register.  
 #define MASK (0x3C)  // [RW] Channel 1. For disjoint probe comparision
 
+// Number of words requested from TBDR per read when streaming the samples
+#define OCLA_TBDR_CHUNK_SIZE (4096)
+
 // OCSR (OCLA Status Register) bitfield definitions
 #define OCSR_DA_Pos (0)
 #define OCSR_DA_Width (1)
@@ -96,6 +101,7 @@
 #define OCCR_SR_Msk (((1u << OCCR_SR_Width) - 1) << OCCR_SR_Pos)
 
 class OclaJtagAdapter;
+class OclaJtagBatch;
 
 enum ocla_status { NA = 0, DATA_AVAILABLE = 1 };
 
@@ -152,10 +158,18 @@ struct ocla_channel_register {
   uint32_t mask;
 };
 
+// Called after each chunk of sample data is uploaded with the number of words
+// received so far and the total number of words
+typedef std::function<void(uint32_t, uint32_t)> ocla_progress_callback;
+
 class OclaIP {
  public:
   OclaIP();
   OclaIP(OclaJtagAdapter *adapter, uint32_t base_addr);
+  // queue the id and parameter register reads into the caller's batch. the
+  // getters are valid once the batch is flushed. the channel registers are
+  // not latched so the object can't be used to configure triggers.
+  OclaIP(OclaJtagAdapter *adapter, uint32_t base_addr, OclaJtagBatch &batch);
   virtual ~OclaIP();
   void configure(ocla_config &cfg);
   void configure_channel(uint32_t channel, ocla_trigger_config &trig_cfg);
@@ -171,11 +185,21 @@ class OclaIP {
   uint32_t get_version() const;
   std::string get_type() const;
   uint32_t get_id() const;
+  ocla_data get_data_format() const;
   ocla_data get_data() const;
+  bool get_data(ocla_data &data, std::atomic<bool> &stop,
+                ocla_progress_callback progress = nullptr,
+                uint32_t chunk_size = OCLA_TBDR_CHUNK_SIZE) const;
+  // queue the TBDR read of the next chunk of whole sample lines starting at
+  // offset into data, which must be sized from get_data_format(). returns the
+  // number of words queued (0 once all samples are queued)
+  uint32_t queue_data(OclaJtagBatch &batch, ocla_data &data, uint32_t offset,
+                      uint32_t chunk_size = OCLA_TBDR_CHUNK_SIZE) const;
   uint32_t get_base_addr() const { return m_base_addr; }
 
  private:
   void read_registers();
+  void queue_read_registers(OclaJtagBatch &batch);
   OclaJtagAdapter *m_adapter;
   uint32_t m_base_addr;
   uint32_t m_type;
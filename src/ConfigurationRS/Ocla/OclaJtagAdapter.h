@@ -13,6 +13,16 @@ struct jtag_read_result {
   uint32_t status;
 };
 
+enum jtag_transaction_type { JTAG_WRITE = 0, JTAG_READ = 1 };
+
+struct jtag_transaction {
+  jtag_transaction_type type;
+  uint32_t address;
+  uint32_t data;
+  uint32_t num_reads;
+  uint32_t increase_by;
+};
+
 class OclaJtagAdapter {
  public:
   virtual ~OclaJtagAdapter(){};
@@ -23,6 +33,30 @@ class OclaJtagAdapter {
                                              uint32_t increase_by = 0) = 0;
   virtual void set_target_device(FOEDAG::Device device,
                                  std::vector<FOEDAG::Tap> taplist) = 0;
+
+  // Whether a jtag round trip is cheap, so that long uploads can be split
+  // into several of them. Adapters that start a new process for every round
+  // trip return false while they have no session.
+  virtual bool is_session_open() const { return true; }
+
+  // Execute the transactions in order and return the results of all the
+  // reads. Adapters that can batch override this to run the whole list in a
+  // single jtag round trip; the default issues one access per transaction.
+  virtual std::vector<jtag_read_result> execute(
+      const std::vector<jtag_transaction> &transactions) {
+    std::vector<jtag_read_result> results{};
+    for (auto &t : transactions) {
+      if (t.type == JTAG_WRITE) {
+        write(t.address, t.data);
+      } else if (t.num_reads == 1 && t.increase_by == 0) {
+        results.push_back({t.address, read(t.address), 0});
+      } else {
+        auto values = read(t.address, t.num_reads, t.increase_by);
+        results.insert(results.end(), values.begin(), values.end());
+      }
+    }
+    return results;
+  }
 };
 
 #endif  //__OCLAJTAGADAPTER_H__
@@ -0,0 +1,42 @@
+#include "OclaJtagBatch.h"
+
+#include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
+
+OclaJtagBatch::OclaJtagBatch(OclaJtagAdapter *adapter) : m_adapter(adapter) {}
+
+OclaJtagBatch::~OclaJtagBatch() {}
+
+void OclaJtagBatch::write(uint32_t addr, uint32_t data) {
+  m_transactions.push_back({JTAG_WRITE, addr, data, 0, 0});
+}
+
+void OclaJtagBatch::read(uint32_t addr, uint32_t *value) {
+  read(addr, 1, 0, value);
+}
+
+void OclaJtagBatch::read(uint32_t base_addr, uint32_t num_reads,
+                         uint32_t increase_by, uint32_t *values) {
+  CFG_ASSERT(values != nullptr);
+  CFG_ASSERT(num_reads > 0);
+  m_transactions.push_back({JTAG_READ, base_addr, 0, num_reads, increase_by});
+  for (uint32_t i = 0; i < num_reads; i++) {
+    m_outputs.push_back(&values[i]);
+  }
+}
+
+void OclaJtagBatch::flush() {
+  CFG_ASSERT(m_adapter != nullptr);
+  if (m_transactions.empty()) {
+    return;
+  }
+  auto results = m_adapter->execute(m_transactions);
+  CFG_ASSERT_MSG(results.size() == m_outputs.size(),
+                 "batch result size is not equal to read requests");
+  for (size_t i = 0; i < results.size(); i++) {
+    *m_outputs[i] = results[i].data;
+  }
+  m_transactions.clear();
+  m_outputs.clear();
+}
+
+bool OclaJtagBatch::empty() const { return m_transactions.empty(); }
@@ -0,0 +1,29 @@
+#ifndef __OCLAJTAGBATCH_H__
+#define __OCLAJTAGBATCH_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "OclaJtagAdapter.h"
+
+// Queue of register transactions that is sent to the adapter in one go on
+// flush(). The read values are stored to the locations given when the reads
+// were queued, so they must stay valid until the batch is flushed.
+class OclaJtagBatch {
+ public:
+  OclaJtagBatch(OclaJtagAdapter *adapter);
+  ~OclaJtagBatch();
+  void write(uint32_t addr, uint32_t data);
+  void read(uint32_t addr, uint32_t *value);
+  void read(uint32_t base_addr, uint32_t num_reads, uint32_t increase_by,
+            uint32_t *values);
+  void flush();
+  bool empty() const;
+
+ private:
+  OclaJtagAdapter *m_adapter;
+  std::vector<jtag_transaction> m_transactions;
+  std::vector<uint32_t *> m_outputs;
+};
+
+#endif  //__OCLAJTAGBATCH_H__
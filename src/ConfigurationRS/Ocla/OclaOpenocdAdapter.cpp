@@ -1,18 +1,27 @@
 #include "OclaOpenocdAdapter.h"
 
 #include <cassert>
+#include <chrono>
 #include <iomanip>
-#include <regex>
 #include <sstream>
 #include <vector>
 
 #include "Configuration/HardwareManager/OpenocdHelper.h"
 #include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
 
+#define OCLA_OPENOCD_LOCALHOST "127.0.0.1"
+#define OCLA_OPENOCD_POLL_TIMEOUT_MS (100)
+
 OclaOpenocdAdapter::OclaOpenocdAdapter(std::string openocd)
-    : FOEDAG::OpenocdAdapter(openocd), m_openocd(openocd) {}
+    : FOEDAG::OpenocdAdapter(openocd),
+      m_openocd(openocd),
+      m_server_stop(false),
+      m_server_exited(false),
+      m_server_owned(false),
+      m_persistent(false),
+      m_tcl_port(OCLA_OPENOCD_TCL_PORT) {}
 
-OclaOpenocdAdapter::~OclaOpenocdAdapter() {}
+OclaOpenocdAdapter::~OclaOpenocdAdapter() { close_session(); }
 
 void OclaOpenocdAdapter::write(uint32_t addr, uint32_t data) {
   // ocla jtag write via openocd command
@@ -24,19 +33,15 @@ void OclaOpenocdAdapter::write(uint32_t addr, uint32_t data) {
 
   std::string output;
   std::stringstream ss;
-  uint32_t i = m_device.tap.index;
 
-  ss << " -c \"set addr [format 0x%08x " << addr << "];"
-     << "set data [format 0x%08x " << data << "];"
-     << "irscan tap" << i << ".tap 0x04;"
-     << "drscan tap" << i << ".tap 1 0x1 1 0x1 32 \\$addr 32 \\$data 2 0x0;"
-     << "irscan tap" << i << ".tap 0x08;"
-     << "set res [drscan tap" << i << ".tap 32 0x0 2 0x0];"
-     << "echo \\\"\\$addr \\$res\\\";\"";
+  ss << "ocla_write tap" << m_device.tap.index << ".tap "
+     << CFG_print("0x%08x 0x%08x", addr, data);
 
   CFG_ASSERT_MSG(execute_command(ss.str(), output) == 0, "cmdexec error: %s",
                  output.c_str());
-  parse(output);
+  std::vector<jtag_read_result> values{};
+  values.reserve(1);
+  CFG_ASSERT_MSG(parse(output, values) > 0, "empty result");
 }
 
 uint32_t OclaOpenocdAdapter::read(uint32_t addr) {
@@ -57,31 +62,117 @@ std::vector<jtag_read_result> OclaOpenocdAdapter::read(uint32_t base_addr,
   std::string output;
   std::stringstream ss;
 
-  ss << build_tcl_proc(m_device.index) << " -c \"ocla_read " << std::hex
-     << std::showbase << base_addr << std::dec << std::noshowbase << " "
-     << num_reads << " " << increase_by << ";\"";
+  ss << "ocla_read tap" << m_device.index << ".tap "
+     << CFG_print("0x%08x", base_addr) << " " << num_reads << " "
+     << increase_by;
 
   CFG_ASSERT_MSG(execute_command(ss.str(), output) == 0, "cmdexec error: %s",
                  output.c_str());
-  auto values = parse(output);
+  std::vector<jtag_read_result> values{};
+  values.reserve(num_reads);
+  CFG_ASSERT_MSG(parse(output, values) > 0, "empty result");
   CFG_ASSERT_MSG(values.size() == num_reads,
                  "values size is not equal to read requests");
   return values;
 }
 
-std::string OclaOpenocdAdapter::build_tcl_proc(uint32_t tap_index) {
+std::vector<jtag_read_result> OclaOpenocdAdapter::execute(
+    const std::vector<jtag_transaction> &transactions) {
+  // all transactions are sent as the arguments of one ocla_batch call, so a
+  // whole batch costs a single openocd command (and a single process launch
+  // when no persistent session is open). each write returns one line and
+  // each read returns one line per word, in the order they were queued.
+  std::string output;
+  std::stringstream ss;
+  uint32_t num_lines = 0;
+  uint32_t num_reads = 0;
+
+  if (transactions.empty()) {
+    return {};
+  }
+
+  ss << "ocla_batch tap" << m_device.tap.index << ".tap";
+  for (auto &t : transactions) {
+    if (t.type == JTAG_WRITE) {
+      ss << CFG_print(" {w 0x%08x 0x%08x}", t.address, t.data);
+      ++num_lines;
+    } else {
+      ss << CFG_print(" {r 0x%08x %u %u}", t.address, t.num_reads,
+                      t.increase_by);
+      num_lines += t.num_reads;
+      num_reads += t.num_reads;
+    }
+  }
+
+  CFG_ASSERT_MSG(execute_command(ss.str(), output) == 0, "cmdexec error: %s",
+                 output.c_str());
+  std::vector<jtag_read_result> values{};
+  values.reserve(num_lines);
+  CFG_ASSERT_MSG(parse(output, values) > 0, "empty result");
+  CFG_ASSERT_MSG(values.size() == num_lines,
+                 "values size is not equal to batch requests");
+
+  std::vector<jtag_read_result> results{};
+  results.reserve(num_reads);
+  size_t index = 0;
+  for (auto &t : transactions) {
+    if (t.type == JTAG_WRITE) {
+      ++index;
+    } else {
+      results.insert(results.end(), values.begin() + index,
+                     values.begin() + index + t.num_reads);
+      index += t.num_reads;
+    }
+  }
+  return results;
+}
+
+std::string OclaOpenocdAdapter::build_tcl_proc() {
+  // the procs return the "<addr> <data> <status>" lines instead of echoing
+  // them so that the same procs work for the one-shot process and for the
+  // tcl rpc channel of a persistent session
+  return "proc ocla_write {tap addr data} { set addr [format 0x%08x $addr]; "
+         "set data [format 0x%08x $data]; irscan $tap 0x04; drscan $tap 1 0x1 "
+         "1 0x1 32 $addr 32 $data 2 0x0; irscan $tap 0x08; set res [drscan "
+         "$tap 32 0x0 2 0x0]; return \"$addr $res\" }; "
+         "proc ocla_read {tap addr {n 1} {c 0}} { set out \"\"; for {set i 0} "
+         "{$i < $n} {incr i} { set addr [format 0x%08x $addr]; irscan $tap "
+         "0x04; drscan $tap 1 0x1 1 0x0 32 $addr 32 0x0 2 0x0; irscan $tap "
+         "0x08; set res [drscan $tap 32 0x0 2 0x0]; append out \"$addr "
+         "$res\\n\"; incr addr $c }; return $out }; "
+         "proc ocla_batch {tap args} { set out \"\"; foreach op $args { if "
+         "{[lindex $op 0] == \"w\"} { append out [ocla_write $tap [lindex $op "
+         "1] [lindex $op 2]] \"\\n\" } else { append out [ocla_read $tap "
+         "[lindex $op 1] [lindex $op 2] [lindex $op 3]] } }; return $out };";
+}
+
+std::string OclaOpenocdAdapter::build_openocd_config() {
   std::ostringstream ss;
-  ss << " -c \"proc ocla_read {addr {n 1} {c 0}} { for {set i 0} {\\$i < \\$n} "
-        "{incr i} {; set addr [format 0x%08x \\$addr]; irscan tap"
-     << tap_index << ".tap 0x04; drscan tap" << tap_index
-     << ".tap 1 0x1 1 0x0 32 \\$addr 32 0x0 2 0x0; irscan tap" << tap_index
-     << ".tap 0x08; set res [drscan tap" << tap_index
-     << ".tap 32 0x0 2 0x0]; echo \\\"\\$addr \\$res\\\"; incr addr \\$c; }; "
-        "};\"";
+  ss << build_cable_config(m_device.cable) << build_tap_config(m_taplist)
+     << build_target_config(m_device);
   return ss.str();
 }
 
-int OclaOpenocdAdapter::execute_command(const std::string &cmd,
+std::string OclaOpenocdAdapter::escape_shell(const std::string &script) {
+  std::string escaped;
+  for (auto c : script) {
+    if (c == '"' || c == '$' || c == '\\' || c == '`') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
+int OclaOpenocdAdapter::execute_command(const std::string &script,
+                                        std::string &output) {
+  if (m_persistent && open_session()) {
+    return execute_rpc(script, output);
+  }
+  return execute_process(script, output);
+}
+
+int OclaOpenocdAdapter::execute_process(const std::string &script,
                                         std::string &output) {
   std::atomic<bool> stop = false;
   std::ostringstream ss;
@@ -89,10 +180,10 @@ int OclaOpenocdAdapter::execute_command(const std::string &cmd,
   ss << " -l /dev/stdout"  //<-- not windows friendly
      << " -d2";
 
-  ss << build_cable_config(m_device.cable) << build_tap_config(m_taplist)
-     << build_target_config(m_device);
+  ss << build_openocd_config();
   ss << " -c \"init\"";
-  ss << cmd;
+  ss << " -c \"" << escape_shell(build_tcl_proc()) << "\"";
+  ss << " -c \"echo [" << escape_shell(script) << "]\"";
   ss << " -c \"exit\"";
 
   int res = CFG_execute_cmd("OPENOCD_DEBUG_LEVEL=-3 " + m_openocd + ss.str(),
@@ -100,29 +191,179 @@ int OclaOpenocdAdapter::execute_command(const std::string &cmd,
   return res;
 }
 
-std::vector<jtag_read_result> OclaOpenocdAdapter::parse(
-    const std::string &output) {
-  std::stringstream ss(output);
-  std::string s;
-  std::cmatch matches;
-  std::vector<jtag_read_result> values;
-
-  while (std::getline(ss, s)) {
-    // look for text format (in hex): 0xNNNNNNNN xxxxxxxx yy
-    if (std::regex_search(
-            s.c_str(), matches,
-            std::regex("^0x([0-9A-F]{8}) ([0-9A-F]{8}) ([0-9A-F]{2})$",
-                       std::regex::icase)) == true) {
-      jtag_read_result res{};
-      res.address = (uint32_t)stoul(matches[1], 0, 16);
-      res.data = (uint32_t)stoul(matches[2], 0, 16);
-      res.status = (uint32_t)stoul(matches[3], 0, 16);
+int OclaOpenocdAdapter::execute_rpc(const std::string &script,
+                                    std::string &output) {
+  // the rpc server replies with the script result only, so prefix it with the
+  // catch return code to tell errors apart from regular results
+  std::string result;
+  if (!m_client.execute("format \"%d\\n%s\" [catch {" + script +
+                            "} ocla_res] $ocla_res",
+                        result)) {
+    output = "lost connection to openocd tcl server";
+    return -1;
+  }
+
+  auto pos = result.find('\n');
+  int res = std::atoi(result.substr(0, pos).c_str());
+  output = pos == std::string::npos ? "" : result.substr(pos + 1);
+  return res;
+}
+
+bool OclaOpenocdAdapter::open_session() {
+  std::string config = build_openocd_config();
+
+  if (m_client.is_connected()) {
+    // an attached server is used as it is while a launched server must have
+    // been initialized for the currently selected target
+    if (!m_server_owned || m_server_config == config) {
+      return true;
+    }
+    close_session();
+  }
+
+  // the tcl port must be free, otherwise the launched process fails to bind it
+  // and the adapter would end up talking to (and later shutting down) a server
+  // it does not own. attach() is the way to share an existing server
+  if (m_client.connect(OCLA_OPENOCD_LOCALHOST, m_tcl_port, 0)) {
+    m_client.disconnect();
+    CFG_POST_WARNING(
+        "Port %d is already used by another openocd tcl server. Fall back to "
+        "one openocd process per transaction",
+        m_tcl_port);
+    m_persistent = false;
+    return false;
+  }
+
+  // launch openocd in the background and keep it alive with its tcl rpc
+  // server enabled. the process is reused by all the register transactions
+  // until the session is closed.
+  std::ostringstream ss;
+  ss << "OPENOCD_DEBUG_LEVEL=-3 " << m_openocd << " -d1" << config
+     << " -c \"tcl_port " << m_tcl_port << "\""
+     << " -c \"telnet_port disabled\""
+     << " -c \"gdb_port disabled\""
+     << " -c \"init\"";
+  std::string cmd = ss.str();
+
+  m_server_stop = false;
+  m_server_exited = false;
+  m_server = std::thread([this, cmd]() {
+    std::string output;
+    CFG_execute_cmd(cmd, output, nullptr, m_server_stop);
+    m_server_exited = true;
+  });
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(OCLA_OPENOCD_CONNECT_TIMEOUT_MS);
+  while (!m_server_exited &&
+         !m_client.connect(OCLA_OPENOCD_LOCALHOST, m_tcl_port, 0) &&
+         std::chrono::steady_clock::now() < deadline) {
+    CFG_sleep_ms(OCLA_OPENOCD_POLL_TIMEOUT_MS);
+  }
+
+  // whoever accepted the connection is only our server if it is still running
+  std::string output;
+  if (!m_client.is_connected() || m_server_exited ||
+      execute_rpc(build_tcl_proc(), output) != 0) {
+    CFG_POST_WARNING(
+        "Fail to start persistent openocd session on port %d. Fall back to "
+        "one openocd process per transaction",
+        m_tcl_port);
+    close_session();
+    m_persistent = false;
+    return false;
+  }
+
+  m_server_config = config;
+  m_server_owned = true;
+  return true;
+}
+
+bool OclaOpenocdAdapter::attach(std::string host, uint32_t port) {
+  close_session();
+  if (!m_client.connect(host, port, OCLA_OPENOCD_CONNECT_TIMEOUT_MS)) {
+    return false;
+  }
+  std::string output;
+  if (execute_rpc(build_tcl_proc(), output) != 0) {
+    m_client.disconnect();
+    return false;
+  }
+  // server is not owned by the adapter so that it is never relaunched or
+  // shutdown by the adapter
+  m_persistent = true;
+  return true;
+}
+
+void OclaOpenocdAdapter::close_session() {
+  if (m_client.is_connected() && m_server_owned) {
+    std::string output;
+    m_client.execute("shutdown", output);
+  }
+  m_client.disconnect();
+  if (m_server.joinable()) {
+    m_server_stop = true;
+    m_server.join();
+  }
+  m_server_config.clear();
+  m_server_owned = false;
+}
+
+bool OclaOpenocdAdapter::is_session_open() const {
+  return m_client.is_connected();
+}
+
+void OclaOpenocdAdapter::set_persistent(bool enable, uint32_t tcl_port) {
+  if (!enable || tcl_port != m_tcl_port) {
+    close_session();
+  }
+  m_persistent = enable;
+  m_tcl_port = tcl_port;
+}
+
+static inline bool parse_hex(const char *p, size_t len, uint32_t &value) {
+  value = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint32_t c = (uint8_t)p[i];
+    uint32_t digit;
+    if (c - '0' < 10) {
+      digit = c - '0';
+    } else if ((c | 0x20) - 'a' < 6) {
+      digit = (c | 0x20) - 'a' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | digit;
+  }
+  return true;
+}
+
+size_t OclaOpenocdAdapter::parse(std::string_view output,
+                                 std::vector<jtag_read_result> &values) {
+  // look for text format (in hex): 0xNNNNNNNN xxxxxxxx yy
+  // every matching line is exactly 22 characters long, anything else
+  // (including lines with trailing characters) is ignored
+  const size_t line_len = 22;
+  size_t count = 0;
+  size_t pos = 0;
+
+  while (pos < output.size()) {
+    size_t end = output.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = output.size();
+    }
+    const char *p = output.data() + pos;
+    jtag_read_result res{};
+    if (end - pos == line_len && p[0] == '0' && (p[1] | 0x20) == 'x' &&
+        p[10] == ' ' && p[19] == ' ' && parse_hex(p + 2, 8, res.address) &&
+        parse_hex(p + 11, 8, res.data) && parse_hex(p + 20, 2, res.status)) {
       values.push_back(res);
+      ++count;
     }
+    pos = end + 1;
   }
 
-  CFG_ASSERT_MSG(values.empty() == false, "empty result");
-  return values;
+  return count;
 }
 
 void OclaOpenocdAdapter::set_target_device(FOEDAG::Device device,
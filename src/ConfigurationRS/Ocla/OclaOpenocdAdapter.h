@@ -5,10 +5,16 @@
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <string_view>
+#include <thread>
 #include <tuple>
 
 #include "Configuration/HardwareManager/OpenocdAdapter.h"
 #include "OclaJtagAdapter.h"
+#include "OclaTclRpcClient.h"
+
+#define OCLA_OPENOCD_TCL_PORT (6666)
+#define OCLA_OPENOCD_CONNECT_TIMEOUT_MS (5000)
 
 class OclaOpenocdAdapter : public OclaJtagAdapter,
                            public FOEDAG::OpenocdAdapter {
@@ -20,16 +26,40 @@ class OclaOpenocdAdapter : public OclaJtagAdapter,
   virtual std::vector<jtag_read_result> read(uint32_t base_addr,
                                              uint32_t num_reads,
                                              uint32_t increase_by = 0);
+  virtual std::vector<jtag_read_result> execute(
+      const std::vector<jtag_transaction>& transactions);
   virtual void set_target_device(FOEDAG::Device device,
                                  std::vector<FOEDAG::Tap> taplist);
+  void set_persistent(bool enable, uint32_t tcl_port = OCLA_OPENOCD_TCL_PORT);
+  bool attach(std::string host, uint32_t port);
+  void close_session();
+  virtual bool is_session_open() const;
+  // decode every "0xNNNNNNNN xxxxxxxx yy" line of the openocd output and
+  // append it to values. returns the number of decoded lines
+  static size_t parse(std::string_view output,
+                      std::vector<jtag_read_result>& values);
 
  private:
-  int execute_command(const std::string& cmd, std::string& output);
-  std::string build_tcl_proc(uint32_t tap_num);
-  std::vector<jtag_read_result> parse(const std::string& output);
+  int execute_command(const std::string& script, std::string& output);
+  int execute_process(const std::string& script, std::string& output);
+  int execute_rpc(const std::string& script, std::string& output);
+  bool open_session();
+  std::string build_openocd_config();
+  std::string build_tcl_proc();
+  std::string escape_shell(const std::string& script);
   std::string m_openocd;
   FOEDAG::Device m_device;
   std::vector<FOEDAG::Tap> m_taplist;
+  // persistent session states
+  OclaTclRpcClient m_client;
+  std::thread m_server;
+  std::atomic<bool> m_server_stop;
+  std::atomic<bool> m_server_exited;
+  std::string m_server_config;
+  // only a server launched by the adapter is shutdown when the session closes
+  bool m_server_owned;
+  bool m_persistent;
+  uint32_t m_tcl_port;
 };
 
 #endif  //__OCLAOPENOCDADAPTER_H__
@@ -0,0 +1,138 @@
+#include "OclaTclRpcClient.h"
+
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define OCLA_INVALID_SOCKET ((int64_t)INVALID_SOCKET)
+#define OCLA_CLOSE_SOCKET(s) closesocket((SOCKET)(s))
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define OCLA_INVALID_SOCKET ((int64_t)-1)
+#define OCLA_CLOSE_SOCKET(s) ::close((int)(s))
+#endif
+
+#include "ConfigurationRS/CFGCommonRS/CFGCommonRS.h"
+
+#define OCLA_TCL_RPC_RETRY_INTERVAL_MS (100)
+
+OclaTclRpcClient::OclaTclRpcClient() : m_socket(OCLA_INVALID_SOCKET) {
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  WSADATA wsa_data;
+  WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+}
+
+OclaTclRpcClient::~OclaTclRpcClient() {
+  disconnect();
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
+  WSACleanup();
+#endif
+}
+
+bool OclaTclRpcClient::connect(const std::string &host, uint32_t port,
+                               uint32_t timeout_ms) {
+  disconnect();
+
+  struct addrinfo hints {};
+  struct addrinfo *addrs = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                  &addrs) != 0) {
+    return false;
+  }
+
+  // the server might still be starting up, keep retrying until it accepts
+  // the connection or the timeout expires
+  uint32_t elapsed = 0;
+  while (m_socket == OCLA_INVALID_SOCKET) {
+    for (auto ai = addrs; ai != nullptr; ai = ai->ai_next) {
+      int64_t s = (int64_t)socket(ai->ai_family, ai->ai_socktype,
+                                  ai->ai_protocol);
+      if (s == OCLA_INVALID_SOCKET) {
+        continue;
+      }
+      if (::connect(s, ai->ai_addr, (int)ai->ai_addrlen) == 0) {
+        m_socket = s;
+        break;
+      }
+      OCLA_CLOSE_SOCKET(s);
+    }
+    if (m_socket != OCLA_INVALID_SOCKET || elapsed >= timeout_ms) {
+      break;
+    }
+    CFG_sleep_ms(OCLA_TCL_RPC_RETRY_INTERVAL_MS);
+    elapsed += OCLA_TCL_RPC_RETRY_INTERVAL_MS;
+  }
+  freeaddrinfo(addrs);
+
+  if (m_socket != OCLA_INVALID_SOCKET) {
+    // register transactions are small request/response pairs, do not let
+    // nagle hold them back
+    int flag = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&flag,
+               sizeof(flag));
+  }
+
+  return m_socket != OCLA_INVALID_SOCKET;
+}
+
+void OclaTclRpcClient::disconnect() {
+  if (m_socket != OCLA_INVALID_SOCKET) {
+    OCLA_CLOSE_SOCKET(m_socket);
+    m_socket = OCLA_INVALID_SOCKET;
+  }
+}
+
+bool OclaTclRpcClient::is_connected() const {
+  return m_socket != OCLA_INVALID_SOCKET;
+}
+
+bool OclaTclRpcClient::execute(const std::string &script,
+                               std::string &result) {
+  if (!is_connected()) {
+    return false;
+  }
+  if (!send_all(script + OCLA_TCL_RPC_TERMINATOR) || !receive(result)) {
+    // the connection is in unknown state, drop it
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+bool OclaTclRpcClient::send_all(const std::string &data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    auto n = send(m_socket, data.data() + offset, (int)(data.size() - offset),
+                  0);
+    if (n <= 0) {
+      return false;
+    }
+    offset += (size_t)n;
+  }
+  return true;
+}
+
+bool OclaTclRpcClient::receive(std::string &result) {
+  char buffer[4096];
+  result.clear();
+  while (true) {
+    auto n = recv(m_socket, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      return false;
+    }
+    result.append(buffer, (size_t)n);
+    // the server only sends one response per request so the terminator is
+    // always the last character received
+    if (result.back() == OCLA_TCL_RPC_TERMINATOR) {
+      result.pop_back();
+      return true;
+    }
+  }
+}
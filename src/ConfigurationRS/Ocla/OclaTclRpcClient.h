@@ -0,0 +1,28 @@
+#ifndef __OCLATCLRPCCLIENT_H__
+#define __OCLATCLRPCCLIENT_H__
+
+#include <cstdint>
+#include <string>
+
+// OpenOCD Tcl RPC protocol: every command and every response is terminated
+// by the 0x1a (SUB) character
+#define OCLA_TCL_RPC_TERMINATOR ('\x1a')
+
+class OclaTclRpcClient {
+ public:
+  OclaTclRpcClient();
+  ~OclaTclRpcClient();
+  OclaTclRpcClient(const OclaTclRpcClient &) = delete;
+  OclaTclRpcClient &operator=(const OclaTclRpcClient &) = delete;
+  bool connect(const std::string &host, uint32_t port, uint32_t timeout_ms);
+  void disconnect();
+  bool is_connected() const;
+  bool execute(const std::string &script, std::string &result);
+
+ private:
+  bool send_all(const std::string &data);
+  bool receive(std::string &result);
+  int64_t m_socket;
+};
+
+#endif  //__OCLATCLRPCCLIENT_H__
@@ -1,4 +1,7 @@
+#include <atomic>
+#include <csignal>
 #include <filesystem>
+#include <map>
 
 #include "CFGCommonRS/CFGArgRS_auto.h"
 #include "CFGObject/CFGObject_auto.h"
@@ -17,10 +20,50 @@
 #endif
 
 #define OCLA_WAIT_TIME_MS (1000)
+#define OCLA_PROGRESS_STEP (10)
 
-bool Ocla_select_device(OclaJtagAdapter& adapter,
+// device selections made while a persistent openocd session is open. the
+// session holds the cable so it can't be scanned again by another openocd
+// process until the session is closed.
+static std::map<std::pair<std::string, uint32_t>,
+                std::pair<FOEDAG::Device, std::vector<FOEDAG::Tap>>>
+    Ocla_selected_devices{};
+
+// one adapter per openocd executable, kept alive across commands so that the
+// openocd session opened for a loaded user design is reused until the design
+// is unloaded.
+static std::map<std::string, OclaOpenocdAdapter> Ocla_adapters{};
+static bool Ocla_persistent = false;
+
+// release the cable held by the persistent session. the selected devices
+// must be scanned again once it is reopened.
+void Ocla_close_session(OclaOpenocdAdapter& adapter) {
+  adapter.close_session();
+  Ocla_selected_devices.clear();
+}
+
+OclaOpenocdAdapter& Ocla_get_adapter(const std::string& openocd) {
+  // only the adapter of the current openocd may hold the cable
+  for (auto& it : Ocla_adapters) {
+    if (it.first != openocd && it.second.is_session_open()) {
+      Ocla_close_session(it.second);
+    }
+  }
+  auto& adapter = Ocla_adapters.try_emplace(openocd, openocd).first->second;
+  adapter.set_persistent(Ocla_persistent);
+  return adapter;
+}
+
+bool Ocla_select_device(OclaOpenocdAdapter& adapter,
                         FOEDAG::HardwareManager& hardware_manager,
                         std::string cable_name, uint32_t device_index) {
+  auto key = std::make_pair(cable_name, device_index);
+  auto it = Ocla_selected_devices.find(key);
+  if (it != Ocla_selected_devices.end() && adapter.is_session_open()) {
+    adapter.set_target_device(it->second.first, it->second.second);
+    return true;
+  }
+  Ocla_close_session(adapter);
   std::vector<FOEDAG::Tap> taplist{};
   FOEDAG::Device device{};
   if (!hardware_manager.find_device(cable_name, device_index, device, taplist,
@@ -30,6 +73,7 @@ bool Ocla_select_device(OclaJtagAdapter& adapter,
     return false;
   }
   adapter.set_target_device(device, taplist);
+  Ocla_selected_devices[key] = std::make_pair(device, taplist);
   return true;
 }
 
@@ -46,6 +90,40 @@ void Ocla_launch_gtkwave(oc_waveform_t& waveform, std::filesystem::path binpath,
   }
 }
 
+// set by Ctrl-C while the waveform is uploaded
+static std::atomic<bool> Ocla_upload_stop{false};
+
+static void Ocla_upload_interrupt(int) { Ocla_upload_stop = true; }
+
+bool Ocla_get_waveform(Ocla& ocla, uint32_t domain_id,
+                       oc_waveform_t& output) {
+  uint32_t next_percent = OCLA_PROGRESS_STEP;
+
+  // Ctrl-C cancels the upload before the next chunk is read. the previous
+  // handler is restored once the upload is over
+  Ocla_upload_stop = false;
+  auto previous_handler = std::signal(SIGINT, Ocla_upload_interrupt);
+  bool status = false;
+  try {
+    // report the upload progress for every OCLA_PROGRESS_STEP percent
+    status = ocla.get_waveform(
+        domain_id, output, Ocla_upload_stop,
+        [&](uint32_t words_read, uint32_t total) {
+          uint32_t percent = (uint32_t)((uint64_t)words_read * 100 / total);
+          if (percent >= next_percent) {
+            CFG_POST_MSG("Uploading waveform ... %d%%", percent);
+            next_percent = percent - (percent % OCLA_PROGRESS_STEP) +
+                           OCLA_PROGRESS_STEP;
+          }
+        });
+  } catch (...) {
+    std::signal(SIGINT, previous_handler);
+    throw;
+  }
+  std::signal(SIGINT, previous_handler);
+  return status;
+}
+
 void Ocla_wait_n_show_waveform(Ocla& ocla, uint32_t domain_id,
                                uint32_t timeout_sec,
                                std::string output_filepath,
@@ -72,7 +150,7 @@ void Ocla_wait_n_show_waveform(Ocla& ocla, uint32_t domain_id,
 
   // download the waveform from ocla ip
   oc_waveform_t output_waveform{};
-  if (!ocla.get_waveform(domain_id, output_waveform)) {
+  if (!Ocla_get_waveform(ocla, domain_id, output_waveform)) {
     CFG_POST_ERR("Failed to read waveform data");
     return;
   }
@@ -90,7 +168,7 @@ void Ocla_entry(CFGCommon_ARG* cmdarg) {
   }
 
   // setup hardware manager and ocla depencencies
-  OclaOpenocdAdapter adapter{cmdarg->toolPath.string()};
+  auto& adapter = Ocla_get_adapter(cmdarg->toolPath.string());
   Ocla ocla{&adapter};
   FOEDAG::HardwareManager hardware_manager{&adapter};
 
@@ -104,9 +182,15 @@ void Ocla_entry(CFGCommon_ARG* cmdarg) {
     }
   } else if (subcmd == "load") {
     auto parms = static_cast<const CFGArg_DEBUGGER_LOAD*>(arg->get_sub_arg());
-    ocla.start_session(parms->file);
+    if (ocla.start_session(parms->file)) {
+      Ocla_persistent = true;
+      adapter.set_persistent(true);
+    }
   } else if (subcmd == "unload") {
     ocla.stop_session();
+    Ocla_persistent = false;
+    adapter.set_persistent(false);
+    Ocla_selected_devices.clear();
   } else if (subcmd == "config") {
     auto parms = static_cast<const CFGArg_DEBUGGER_CONFIG*>(arg->get_sub_arg());
     if (Ocla_select_device(adapter, hardware_manager, parms->cable,
@@ -168,7 +252,7 @@ void Ocla_entry(CFGCommon_ARG* cmdarg) {
     if (Ocla_select_device(adapter, hardware_manager, parms->cable,
                            parms->device)) {
       oc_waveform_t output_waveform{};
-      if (ocla.get_waveform(parms->domain, output_waveform)) {
+      if (Ocla_get_waveform(ocla, parms->domain, output_waveform)) {
         Ocla_launch_gtkwave(
             output_waveform, cmdarg->binPath,
             parms->output.empty() ? DEF_FST_OUTPUT : parms->output);
@@ -242,6 +326,9 @@ void Ocla_entry(CFGCommon_ARG* cmdarg) {
     auto parms =
         static_cast<const CFGArg_DEBUGGER_LIST_CABLE*>(arg->get_sub_arg());
 
+    // release the cable held by the persistent session before scanning
+    Ocla_close_session(adapter);
+
     auto cables = hardware_manager.get_cables();
     if (cables.empty()) {
       if (parms->verbose) CFG_POST_MSG("No cable detected");
@@ -261,6 +348,9 @@ void Ocla_entry(CFGCommon_ARG* cmdarg) {
         static_cast<const CFGArg_DEBUGGER_LIST_DEVICE*>(arg->get_sub_arg());
     std::vector<FOEDAG::Device> devices{};
 
+    // release the cable held by the persistent session before scanning
+    Ocla_close_session(adapter);
+
     if (parms->m_args.size() == 1) {
       std::string cable_name = parms->m_args[0];
       if (!hardware_manager.is_cable_exists(cable_name, true)) {
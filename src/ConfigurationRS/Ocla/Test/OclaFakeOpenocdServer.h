@@ -0,0 +1,204 @@
+#ifndef __OCLAFAKEOPENOCDSERVER_H__
+#define __OCLAFAKEOPENOCDSERVER_H__
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal stand-in for an OpenOCD process running its Tcl RPC server. It
+// understands the ocla_read/ocla_write/ocla_batch procs sent by
+// OclaOpenocdAdapter and backs them with a register map so the persistent
+// session path can be exercised without a cable or an openocd binary.
+class OclaFakeOpenocdServer {
+ public:
+  OclaFakeOpenocdServer() : m_listen(-1), m_port(0), m_stop(false) {
+    m_listen = socket(AF_INET, SOCK_STREAM, 0);
+    int flag = 1;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(m_listen, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(m_listen, (sockaddr*)&addr, &len);
+    m_port = ntohs(addr.sin_port);
+    listen(m_listen, 1);
+    m_thread = std::thread([this]() { serve(); });
+  }
+
+  ~OclaFakeOpenocdServer() {
+    m_stop = true;
+    shutdown(m_listen, SHUT_RDWR);
+    close(m_listen);
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+
+  uint32_t port() const { return m_port; }
+
+  uint32_t get_register(uint32_t addr) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_registers[addr];
+  }
+
+  void set_register(uint32_t addr, uint32_t value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_registers[addr] = value;
+  }
+
+  uint32_t get_request_count() const { return m_requests; }
+  uint32_t get_connection_count() const { return m_connections; }
+  uint32_t get_batch_count() const { return m_batches; }
+
+ private:
+  void serve() {
+    while (!m_stop) {
+      int client = accept(m_listen, nullptr, nullptr);
+      if (client < 0) {
+        break;
+      }
+      m_connections++;
+      std::string request;
+      char buffer[4096];
+      while (true) {
+        auto n = recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+          break;
+        }
+        request.append(buffer, (size_t)n);
+        size_t pos;
+        bool shutdown_requested = false;
+        while ((pos = request.find('\x1a')) != std::string::npos) {
+          std::string script = request.substr(0, pos);
+          request.erase(0, pos + 1);
+          m_requests++;
+          std::string response =
+              evaluate(script, shutdown_requested) + '\x1a';
+          send(client, response.data(), response.size(), 0);
+        }
+        if (shutdown_requested) {
+          break;
+        }
+      }
+      close(client);
+    }
+  }
+
+  std::string evaluate(const std::string& script, bool& shutdown_requested) {
+    static const std::regex wrapped(
+        "^format \"%d\\\\n%s\" \\[catch \\{([\\s\\S]*)\\} ocla_res\\] "
+        "\\$ocla_res$");
+    std::smatch m;
+    if (script == "shutdown") {
+      shutdown_requested = true;
+      return "shutdown command invoked";
+    }
+    if (!std::regex_match(script, m, wrapped)) {
+      return "invalid command name";
+    }
+    std::string body = m[1];
+    if (body.rfind("proc ", 0) == 0) {
+      return "0\n";
+    }
+    std::string result;
+    for (auto& command : split_commands(body)) {
+      if (!execute(command, result)) {
+        return "1\ninvalid command name \"" + command + "\"";
+      }
+    }
+    return "0\n" + result;
+  }
+
+  std::vector<std::string> split_commands(const std::string& body) {
+    std::vector<std::string> commands;
+    std::string command;
+    for (auto c : body) {
+      if (c == ';' || c == '\n') {
+        if (!command.empty()) commands.push_back(command);
+        command.clear();
+      } else if (c != ' ' || !command.empty()) {
+        command.push_back(c);
+      }
+    }
+    if (!command.empty()) commands.push_back(command);
+    return commands;
+  }
+
+  bool execute(const std::string& command, std::string& result) {
+    std::istringstream ss(command);
+    std::string name, tap;
+    ss >> name >> tap;
+    if (name == "ocla_batch") {
+      // every {w addr data} or {r addr n c} argument is run as the matching
+      // ocla_write/ocla_read call
+      static const std::regex op("\\{(w|r) ([^}]*)\\}");
+      std::string output;
+      for (std::sregex_iterator it(command.begin(), command.end(), op), end;
+           it != end; ++it) {
+        std::string r;
+        bool is_write = (*it)[1] == "w";
+        execute(std::string(is_write ? "ocla_write " : "ocla_read ") + tap +
+                    " " + (*it)[2].str(),
+                r);
+        output += r + (is_write ? "\n" : "");
+      }
+      m_batches++;
+      result = output;
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (name == "ocla_write") {
+      std::string addr_str, data_str;
+      ss >> addr_str >> data_str;
+      uint32_t addr = (uint32_t)std::stoul(addr_str, nullptr, 0);
+      uint32_t data = (uint32_t)std::stoul(data_str, nullptr, 0);
+      m_registers[addr] = data;
+      result = format_line(addr, data);
+      return true;
+    }
+    if (name == "ocla_read") {
+      std::string addr_str;
+      uint32_t n = 1, c = 0;
+      ss >> addr_str >> n >> c;
+      uint32_t addr = (uint32_t)std::stoul(addr_str, nullptr, 0);
+      result.clear();
+      for (uint32_t i = 0; i < n; i++) {
+        result += format_line(addr, m_registers[addr]) + "\n";
+        addr += c;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  std::string format_line(uint32_t addr, uint32_t data) {
+    char line[32];
+    snprintf(line, sizeof(line), "0x%08x %08x 00", addr, data);
+    return line;
+  }
+
+  int m_listen;
+  uint32_t m_port;
+  std::atomic<bool> m_stop;
+  std::atomic<uint32_t> m_requests{0};
+  std::atomic<uint32_t> m_connections{0};
+  std::atomic<uint32_t> m_batches{0};
+  std::mutex m_mutex;
+  std::map<uint32_t, uint32_t> m_registers;
+  std::thread m_thread;
+};
+
+#endif  //__OCLAFAKEOPENOCDSERVER_H__
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "OclaFstWaveformWriter.h"
+#include "fstapi.h"
+
+typedef std::tuple<uint64_t, fstHandle, std::string> fst_value_change_t;
+
+// waveform of counter signals. signal n increments every 2^n samples so the
+// higher signals rarely change, like most probes of a real capture.
+static oc_waveform_t make_waveform(uint32_t num_signals, uint32_t depth,
+                                   uint32_t bitwidth) {
+  oc_waveform_t waveform{};
+  oc_probe_t probe{};
+  uint32_t words_per_line = ((bitwidth - 1) / 32) + 1;
+  for (uint32_t n = 0; n < num_signals; n++) {
+    oc_signal_t signal{};
+    signal.name = "s" + std::to_string(n);
+    signal.bitwidth = bitwidth;
+    signal.bitpos = n * bitwidth;
+    signal.words_per_line = words_per_line;
+    signal.depth = depth;
+    signal.values.assign(words_per_line * depth, 0);
+    for (uint32_t i = 0; i < depth; i++) {
+      signal.values[i * words_per_line] = i >> (n % 16);
+    }
+    probe.signal_list.push_back(signal);
+  }
+  probe.probe_id = 1;
+  waveform.probes.push_back(probe);
+  waveform.domain_id = 1;
+  return waveform;
+}
+
+static double write_waveform(oc_waveform_t& waveform, std::string filepath,
+                             bool all_samples) {
+  OclaFstWaveformWriter writer{};
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(writer.write(waveform, filepath, all_samples));
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// value changes of the file, read back with the fst reader. the reader also
+// reports the value of every signal at the start of each block (unknown 'x'
+// before the first sample), so only the last value of a signal at a given time
+// is kept and repeated values are dropped
+static std::vector<fst_value_change_t> read_waveform(std::string filepath) {
+  std::map<fstHandle, std::vector<std::pair<uint64_t, std::string>>> values{};
+  void* fst = fstReaderOpen(filepath.c_str());
+  EXPECT_NE(fst, nullptr);
+  if (fst != nullptr) {
+    fstReaderSetFacProcessMaskAll(fst);
+    fstReaderIterBlocks(
+        fst,
+        [](void* user_data, uint64_t time, fstHandle handle,
+           const unsigned char* value) {
+          auto& history = (*(std::map<
+              fstHandle, std::vector<std::pair<uint64_t, std::string>>>*)
+                               user_data)[handle];
+          if (!history.empty() && history.back().first == time) {
+            history.pop_back();
+          }
+          history.emplace_back(time, (const char*)value);
+        },
+        &values, nullptr);
+    fstReaderClose(fst);
+  }
+  std::vector<fst_value_change_t> changes{};
+  for (auto& history : values) {
+    std::string prev{};
+    for (auto& value : history.second) {
+      if (value.second != prev &&
+          value.second.find('x') == std::string::npos) {
+        changes.emplace_back(value.first, history.first, value.second);
+      }
+      prev = value.second;
+    }
+  }
+  std::sort(changes.begin(), changes.end());
+  return changes;
+}
+
+// value changes expected from the waveform. the handles follow the signal
+// creation order starting from 1 and the values are binary strings (msb
+// first)
+static std::vector<fst_value_change_t> expected_changes(
+    oc_waveform_t& waveform) {
+  std::vector<fst_value_change_t> changes{};
+  fstHandle handle = 0;
+  for (auto& probe : waveform.probes) {
+    for (auto& signal : probe.signal_list) {
+      handle++;
+      std::string prev{};
+      for (uint32_t i = 0; i < signal.depth; i++) {
+        std::string value{};
+        for (uint32_t b = signal.bitwidth; b-- > 0;) {
+          uint32_t word = signal.values[i * signal.words_per_line + b / 32];
+          value.push_back((word >> (b % 32)) & 1 ? '1' : '0');
+        }
+        if (value != prev) {
+          changes.emplace_back(i, handle, value);
+        }
+        prev = value;
+      }
+    }
+  }
+  std::sort(changes.begin(), changes.end());
+  return changes;
+}
+
+TEST(OclaFstWaveformWriterTest, value_change_test) {
+  auto dir = std::filesystem::temp_directory_path();
+  std::string full = (dir / "ocla_fst_full.fst").string();
+  std::string delta = (dir / "ocla_fst_delta.fst").string();
+
+  for (uint32_t bitwidth : {8, 40}) {
+    auto waveform = make_waveform(8, 256, bitwidth);
+    // upper word of the wide signals changes on its own
+    for (auto& signal : waveform.probes[0].signal_list) {
+      for (uint32_t i = 0; i < signal.depth && signal.words_per_line > 1;
+           i++) {
+        signal.values[i * signal.words_per_line + 1] = (i / 100) & 0xff;
+      }
+    }
+
+    // both files hold the same value changes, the delta one is smaller
+    write_waveform(waveform, full, true);
+    write_waveform(waveform, delta, false);
+    auto expected = expected_changes(waveform);
+    EXPECT_EQ(read_waveform(full), expected);
+    EXPECT_EQ(read_waveform(delta), expected);
+    EXPECT_LT(std::filesystem::file_size(delta),
+              std::filesystem::file_size(full));
+  }
+
+  std::filesystem::remove(full);
+  std::filesystem::remove(delta);
+}
+
+// benchmark is opt-in: ocla_test --gtest_also_run_disabled_tests
+TEST(OclaFstWaveformWriterTest, DISABLED_write_benchmark) {
+  // 256 signals x 32K samples
+  auto dir = std::filesystem::temp_directory_path();
+  std::string full = (dir / "ocla_fst_bench_full.fst").string();
+  std::string delta = (dir / "ocla_fst_bench_delta.fst").string();
+  auto waveform = make_waveform(256, 32 * 1024, 40);
+
+  double t0 = write_waveform(waveform, full, true);
+  double t1 = write_waveform(waveform, delta, false);
+  auto size0 = std::filesystem::file_size(full);
+  auto size1 = std::filesystem::file_size(delta);
+  EXPECT_LT(size1, size0);
+  std::cout << "fst 256 signals x 32768 samples: every sample " << t0
+            << " ms " << size0 << " bytes, value changes " << t1 << " ms "
+            << size1 << " bytes" << std::endl;
+
+  std::filesystem::remove(full);
+  std::filesystem::remove(delta);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <iostream>
+#include <random>
 #include <vector>
 
 #include "OclaHelpers.h"
@@ -271,6 +274,86 @@ TEST(ReadWriteBitsVectorUint32Test, CFG_copy_bits_vec32) {
   EXPECT_EQ(vector, expected_vector);
 }
 
+TEST(ReadWriteBitsVectorUint32Test, CFG_extract_bits_vec32) {
+  std::mt19937 rng(1);
+  std::vector<uint32_t> src(9);
+  for (auto& w : src) w = rng();
+
+  for (uint32_t pos = 0; pos < 96; pos += 5) {
+    for (uint32_t nbits = 1; pos + nbits <= 32 * src.size(); nbits += 11) {
+      uint32_t nwords = ((nbits - 1) / 32) + 1;
+      std::vector<uint32_t> expected(nwords, 0);
+      std::vector<uint32_t> output(nwords, 0xffffffff);
+      CFG_copy_bits_vec32(src.data(), pos, expected.data(), 0, nbits);
+      CFG_extract_bits_vec32(src.data(), pos, output.data(), nbits);
+      EXPECT_EQ(output, expected) << "pos " << pos << " nbits " << nbits;
+    }
+  }
+}
+
+// extract every signal of a capture with the bit by bit path and the
+// transposed path. the signal widths cover single word, word straddling and
+// multi word fields.
+static double extract_signals(uint32_t width, uint32_t depth, bool transposed,
+                              const std::vector<uint32_t>& samples,
+                              std::vector<std::vector<uint32_t>>& signals) {
+  const uint32_t widths[] = {1, 5, 16, 33, 7, 64, 2, 31, 97};
+  uint32_t words_per_line = ((width - 1) / 32) + 1;
+  uint32_t pos = 0;
+  uint32_t k = 0;
+  signals.clear();
+  auto start = std::chrono::steady_clock::now();
+  while (pos < width) {
+    uint32_t nbits = std::min(widths[k++ % 9], width - pos);
+    uint32_t nwords = ((nbits - 1) / 32) + 1;
+    signals.emplace_back(nwords * depth, 0);
+    auto& values = signals.back();
+    if (transposed) {
+      CFG_extract_field_vec32(samples.data(), words_per_line, pos,
+                              values.data(), nbits, depth);
+    } else {
+      for (uint32_t i = 0; i < depth; i++) {
+        CFG_copy_bits_vec32((uint32_t*)&samples[i * words_per_line], pos,
+                            &values[i * nwords], 0, nbits);
+      }
+    }
+    pos += nbits;
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+TEST(ReadWriteBitsVectorUint32Test, CFG_extract_field_vec32) {
+  std::mt19937 rng(2);
+  std::vector<uint32_t> samples(5 * 100);
+  for (auto& w : samples) w = rng();
+  std::vector<std::vector<uint32_t>> expected{};
+  std::vector<std::vector<uint32_t>> output{};
+  extract_signals(150, 100, false, samples, expected);
+  extract_signals(150, 100, true, samples, output);
+  EXPECT_EQ(output, expected);
+}
+
+// benchmark is opt-in: ocla_test --gtest_also_run_disabled_tests
+TEST(ReadWriteBitsVectorUint32Test,
+     DISABLED_CFG_extract_field_vec32_benchmark) {
+  // 1024 probes x 32K samples
+  const uint32_t width = 1024;
+  const uint32_t depth = 32 * 1024;
+  std::mt19937 rng(3);
+  std::vector<uint32_t> samples((width / 32) * depth);
+  for (auto& w : samples) w = rng();
+  std::vector<std::vector<uint32_t>> expected{};
+  std::vector<std::vector<uint32_t>> output{};
+  double t0 = extract_signals(width, depth, false, samples, expected);
+  double t1 = extract_signals(width, depth, true, samples, output);
+  EXPECT_EQ(output, expected);
+  std::cout << "extract " << width << " probes x " << depth
+            << " samples: bit by bit " << t0 << " ms, transposed " << t1
+            << " ms" << std::endl;
+}
+
 class ReverseByteOrderU32Test
     : public ::testing::TestWithParam<std::tuple<uint32_t, uint32_t>> {
  protected:
@@ -6,6 +6,7 @@
 #include <tuple>
 
 #include "OclaIP.h"
+#include "OclaJtagBatch.h"
 #include "OclaJtagAdapter.h"
 
 using ::testing::_;
@@ -236,6 +237,88 @@ TEST_F(OclaIPTest, getDataTest_End2End) {
   EXPECT_EQ(988 * 3, result.values.size());
 }
 
+TEST_F(OclaIPTest, getDataTest_Chunked) {
+  ON_CALL(mockAdapter, read(UIDP0)).WillByDefault(Return(1000));
+  ON_CALL(mockAdapter, read(UIDP1)).WillByDefault(Return(65));
+  ON_CALL(mockAdapter, read(TMTR))
+      .WillByDefault(Return((10u << 12) + (1u << 4)));
+
+  // 10 samples of 3 words in chunks of 3 samples (9 words)
+  EXPECT_CALL(mockAdapter, read(TBDR, 9, 0))
+      .Times(3)
+      .WillRepeatedly(Return(std::vector<jtag_read_result>(9, {0, 7, 0})));
+  EXPECT_CALL(mockAdapter, read(TBDR, 3, 0))
+      .Times(1)
+      .WillOnce(Return(std::vector<jtag_read_result>(3, {0, 8, 0})));
+
+  std::vector<uint32_t> progress{};
+  std::atomic<bool> stop = false;
+  ocla_data result{};
+  OclaIP oclaIP(&mockAdapter, 0);
+  EXPECT_TRUE(oclaIP.get_data(
+      result, stop,
+      [&](uint32_t words_read, uint32_t total) {
+        EXPECT_EQ(30, total);
+        progress.push_back(words_read);
+      },
+      10));
+  EXPECT_EQ(10, result.depth);
+  EXPECT_EQ(3, result.words_per_line);
+  ASSERT_EQ(30, result.values.size());
+  EXPECT_EQ(7, result.values[26]);
+  EXPECT_EQ(8, result.values[27]);
+  EXPECT_EQ(std::vector<uint32_t>({9, 18, 27, 30}), progress);
+}
+
+TEST_F(OclaIPTest, getDataTest_ChunkedCancel) {
+  ON_CALL(mockAdapter, read(UIDP0)).WillByDefault(Return(1000));
+  ON_CALL(mockAdapter, read(UIDP1)).WillByDefault(Return(32));
+  ON_CALL(mockAdapter, read(TMTR))
+      .WillByDefault(Return((100u << 12) + (1u << 4)));
+  EXPECT_CALL(mockAdapter, read(TBDR, 16, 0))
+      .Times(2)
+      .WillRepeatedly(Return(std::vector<jtag_read_result>(16, {0, 0, 0})));
+
+  // cancel the upload after the second chunk
+  std::atomic<bool> stop = false;
+  ocla_data result{};
+  OclaIP oclaIP(&mockAdapter, 0);
+  EXPECT_FALSE(oclaIP.get_data(
+      result, stop,
+      [&](uint32_t words_read, uint32_t) {
+        if (words_read >= 32) stop = true;
+      },
+      16));
+  EXPECT_EQ(32, result.depth);
+  EXPECT_EQ(32, result.values.size());
+}
+
+TEST_F(OclaIPTest, queueDataTest) {
+  ON_CALL(mockAdapter, read(UIDP0)).WillByDefault(Return(1000));
+  ON_CALL(mockAdapter, read(UIDP1)).WillByDefault(Return(65));
+  ON_CALL(mockAdapter, read(TMTR))
+      .WillByDefault(Return((4u << 12) + (1u << 4)));
+  EXPECT_CALL(mockAdapter, read(TBDR, 9, 0))
+      .Times(1)
+      .WillOnce(Return(std::vector<jtag_read_result>(9, {0, 5, 0})));
+  EXPECT_CALL(mockAdapter, read(TBDR, 3, 0))
+      .Times(1)
+      .WillOnce(Return(std::vector<jtag_read_result>(3, {0, 6, 0})));
+
+  OclaIP oclaIP(&mockAdapter, 0);
+  ocla_data data = oclaIP.get_data_format();
+  data.values.resize(data.depth * data.words_per_line);
+  OclaJtagBatch batch{&mockAdapter};
+  EXPECT_EQ(9, oclaIP.queue_data(batch, data, 0, 10));
+  batch.flush();
+  EXPECT_EQ(3, oclaIP.queue_data(batch, data, 9, 10));
+  batch.flush();
+  EXPECT_EQ(0, oclaIP.queue_data(batch, data, 12, 10));
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(std::vector<uint32_t>({5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6}),
+            data.values);
+}
+
 TEST_F(OclaIPTest, getDataTest_ConfigReadback) {
   ON_CALL(mockAdapter, read(UIDP0)).WillByDefault(Return(1000));
   ON_CALL(mockAdapter, read(UIDP1)).WillByDefault(Return(65));
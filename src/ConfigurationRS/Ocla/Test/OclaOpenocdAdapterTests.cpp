@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "OclaOpenocdAdapter.h"
+
+// reference implementation of the former regex based parser
+static std::vector<jtag_read_result> regex_parse(const std::string& output) {
+  std::stringstream ss(output);
+  std::string s;
+  std::cmatch matches;
+  std::vector<jtag_read_result> values;
+
+  while (std::getline(ss, s)) {
+    if (std::regex_search(
+            s.c_str(), matches,
+            std::regex("^0x([0-9A-F]{8}) ([0-9A-F]{8}) ([0-9A-F]{2})$",
+                       std::regex::icase)) == true) {
+      jtag_read_result res{};
+      res.address = (uint32_t)stoul(matches[1], 0, 16);
+      res.data = (uint32_t)stoul(matches[2], 0, 16);
+      res.status = (uint32_t)stoul(matches[3], 0, 16);
+      values.push_back(res);
+    }
+  }
+  return values;
+}
+
+static std::string make_dump(uint32_t num_lines) {
+  std::string output;
+  char line[32];
+  output.reserve(num_lines * 23);
+  for (uint32_t i = 0; i < num_lines; i++) {
+    snprintf(line, sizeof(line), (i & 1) ? "0x%08x %08X %02x\n"
+                                         : "0X%08X %08x %02X\n",
+             0x1000 + i * 4, i * 0x9e3779b9, i & 0x3);
+    output += line;
+  }
+  return output;
+}
+
+static void expect_same(const std::vector<jtag_read_result>& a,
+                        const std::vector<jtag_read_result>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    EXPECT_EQ(a[i].address, b[i].address);
+    EXPECT_EQ(a[i].data, b[i].data);
+    EXPECT_EQ(a[i].status, b[i].status);
+  }
+}
+
+TEST(OclaOpenocdAdapterParseTest, parse_test) {
+  std::string output =
+      "Info : JTAG tap: tap0.tap\n"
+      "0x00001000 deadBEEF 01\n"
+      "0x00001004 12345678 00 trailing\n"
+      "0x0000100 12345678 00\n"
+      "0x00001008 1234567g 00\n"
+      "0x0000100c 12345678 02\r\n"
+      "0xFFFFFFFC ffffffff ff";
+  std::vector<jtag_read_result> values{};
+  EXPECT_EQ(OclaOpenocdAdapter::parse(output, values), 2);
+  expect_same(values, regex_parse(output));
+  EXPECT_EQ(values[0].address, 0x1000);
+  EXPECT_EQ(values[0].data, 0xdeadbeef);
+  EXPECT_EQ(values[0].status, 1);
+  EXPECT_EQ(values[1].address, 0xfffffffc);
+  EXPECT_EQ(values[1].data, 0xffffffff);
+  EXPECT_EQ(values[1].status, 0xff);
+}
+
+TEST(OclaOpenocdAdapterParseTest, parse_empty_test) {
+  std::vector<jtag_read_result> values{};
+  EXPECT_EQ(OclaOpenocdAdapter::parse("", values), 0);
+  EXPECT_EQ(OclaOpenocdAdapter::parse("\n\ninvalid\n", values), 0);
+  EXPECT_TRUE(values.empty());
+}
+
+// benchmark is opt-in: ocla_test --gtest_also_run_disabled_tests
+TEST(OclaOpenocdAdapterParseTest, DISABLED_parse_benchmark_64k_lines) {
+  const uint32_t num_lines = 64 * 1024;
+  std::string output = make_dump(num_lines);
+
+  auto t0 = std::chrono::steady_clock::now();
+  auto expected = regex_parse(output);
+  auto t1 = std::chrono::steady_clock::now();
+  std::vector<jtag_read_result> values{};
+  values.reserve(num_lines);
+  EXPECT_EQ(OclaOpenocdAdapter::parse(output, values), num_lines);
+  auto t2 = std::chrono::steady_clock::now();
+
+  expect_same(values, expected);
+  std::cout << "parse " << num_lines << " lines: regex "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << " ms, scanner "
+            << std::chrono::duration<double, std::milli>(t2 - t1).count()
+            << " ms" << std::endl;
+}
+
+// the fake openocd server is built on posix sockets
+#ifndef _WIN32
+
+#include "EioIP.h"
+#include "OclaFakeOpenocdServer.h"
+#include "OclaIP.h"
+#include "OclaJtagBatch.h"
+
+class OclaOpenocdAdapterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(adapter.attach("127.0.0.1", server.port()));
+  }
+
+  void TearDown() override { adapter.close_session(); }
+
+  OclaFakeOpenocdServer server;
+  OclaOpenocdAdapter adapter{"openocd"};
+};
+
+TEST_F(OclaOpenocdAdapterTest, attach_test) {
+  EXPECT_TRUE(adapter.is_session_open());
+  EXPECT_EQ(server.get_connection_count(), 1);
+}
+
+TEST_F(OclaOpenocdAdapterTest, write_test) {
+  adapter.write(0x1000, 0xdeadbeef);
+  EXPECT_EQ(server.get_register(0x1000), 0xdeadbeef);
+}
+
+TEST_F(OclaOpenocdAdapterTest, read_test) {
+  server.set_register(0x2000, 0x12345678);
+  EXPECT_EQ(adapter.read(0x2000), 0x12345678);
+}
+
+TEST_F(OclaOpenocdAdapterTest, read_multiple_test) {
+  for (uint32_t i = 0; i < 8; i++) {
+    server.set_register(0x3000 + i * 4, i + 100);
+  }
+  auto result = adapter.read(0x3000, 8, 4);
+  ASSERT_EQ(result.size(), 8);
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(result[i].address, 0x3000 + i * 4);
+    EXPECT_EQ(result[i].data, i + 100);
+    EXPECT_EQ(result[i].status, 0);
+  }
+}
+
+TEST_F(OclaOpenocdAdapterTest, read_same_address_test) {
+  server.set_register(0x4028, 0xa5a5a5a5);
+  auto result = adapter.read(0x4028, 16);
+  ASSERT_EQ(result.size(), 16);
+  for (auto& r : result) {
+    EXPECT_EQ(r.address, 0x4028);
+    EXPECT_EQ(r.data, 0xa5a5a5a5);
+  }
+}
+
+TEST_F(OclaOpenocdAdapterTest, session_reuse_test) {
+  // one request per transaction, all over the same connection
+  OclaIP ip{&adapter, 0x5000};
+  auto count = server.get_request_count();
+  ip.start();
+  server.set_register(0x5000 + OCSR, 1);
+  EXPECT_EQ(ip.get_status(), DATA_AVAILABLE);
+  EXPECT_EQ(server.get_connection_count(), 1);
+  EXPECT_EQ(server.get_request_count(), count + 3);
+  EXPECT_EQ(server.get_register(0x5000 + OCCR), (1u << OCCR_ST_Pos));
+}
+
+TEST_F(OclaOpenocdAdapterTest, batch_test) {
+  server.set_register(0x6000, 0x11);
+  server.set_register(0x6100, 0x22);
+  server.set_register(0x6104, 0x33);
+  uint32_t value = 0;
+  uint32_t values[2] = {0, 0};
+  OclaJtagBatch batch{&adapter};
+  batch.write(0x6200, 0x44);
+  batch.read(0x6000, &value);
+  batch.read(0x6100, 2, 4, values);
+  batch.write(0x6204, 0x55);
+  EXPECT_FALSE(batch.empty());
+  auto count = server.get_request_count();
+  batch.flush();
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(server.get_request_count(), count + 1);
+  EXPECT_EQ(value, 0x11);
+  EXPECT_EQ(values[0], 0x22);
+  EXPECT_EQ(values[1], 0x33);
+  EXPECT_EQ(server.get_register(0x6200), 0x44);
+  EXPECT_EQ(server.get_register(0x6204), 0x55);
+}
+
+TEST_F(OclaOpenocdAdapterTest, ocla_ip_read_registers_test) {
+  // global registers then the channel registers of the 2 trigger channels
+  server.set_register(0x7000 + IP_TYPE, 0x6f636c61);
+  server.set_register(0x7000 + OCSR, (1u << OCSR_TC_Pos));
+  server.set_register(0x7000 + TSSR + 0x30, 0x12);
+  auto count = server.get_request_count();
+  OclaIP ip{&adapter, 0x7000};
+  EXPECT_EQ(server.get_request_count(), count + 2);
+  EXPECT_EQ(ip.get_type(), "ocla");
+  EXPECT_EQ(ip.get_trigger_count(), 2);
+  EXPECT_EQ(ip.get_channel_config(1).probe_num, 0x12);
+}
+
+TEST_F(OclaOpenocdAdapterTest, deferred_ip_read_registers_test) {
+  server.set_register(0x8000 + IP_ID, 0xabcd);
+  server.set_register(0x9000 + EIO_IP_ID, 0x1234);
+  auto count = server.get_request_count();
+  OclaJtagBatch batch{&adapter};
+  OclaIP ocla_ip{&adapter, 0x8000, batch};
+  EioIP eio_ip{&adapter, 0x9000, batch};
+  batch.flush();
+  EXPECT_EQ(server.get_request_count(), count + 1);
+  EXPECT_EQ(ocla_ip.get_id(), 0xabcd);
+  EXPECT_EQ(eio_ip.get_id(), 0x1234);
+}
+
+TEST_F(OclaOpenocdAdapterTest, interleaved_data_upload_test) {
+  // 2 instances of 8 samples x 2 words in chunks of 4 words. every round
+  // uploads one chunk of each instance in a single request.
+  for (uint32_t base : {0xa000u, 0xb000u}) {
+    server.set_register(base + UIDP0, 8);
+    server.set_register(base + UIDP1, 40);
+    server.set_register(base + TBDR, base);
+  }
+  OclaIP ip0{&adapter, 0xa000};
+  OclaIP ip1{&adapter, 0xb000};
+  ocla_data data0 = ip0.get_data_format();
+  ocla_data data1 = ip1.get_data_format();
+  data0.values.resize(16);
+  data1.values.resize(16);
+  uint32_t offset0 = 0, offset1 = 0;
+  auto count = server.get_request_count();
+  while (offset0 < 16 || offset1 < 16) {
+    OclaJtagBatch batch{&adapter};
+    offset0 += ip0.queue_data(batch, data0, offset0, 4);
+    offset1 += ip1.queue_data(batch, data1, offset1, 4);
+    batch.flush();
+  }
+  EXPECT_EQ(server.get_request_count(), count + 4);
+  EXPECT_EQ(data0.values, std::vector<uint32_t>(16, 0xa000));
+  EXPECT_EQ(data1.values, std::vector<uint32_t>(16, 0xb000));
+}
+
+TEST_F(OclaOpenocdAdapterTest, close_session_test) {
+  // seen through the generic jtag adapter the waveform upload is chunked
+  OclaJtagAdapter* jtag = &adapter;
+  EXPECT_TRUE(jtag->is_session_open());
+  auto count = server.get_request_count();
+  adapter.close_session();
+  EXPECT_FALSE(jtag->is_session_open());
+  // attached server is not owned by the adapter, it must not be shutdown
+  EXPECT_EQ(server.get_request_count(), count);
+}
+
+TEST(OclaOpenocdAdapterSessionTest, foreign_server_test) {
+  // a server the adapter did not launch already serves the tcl port. the
+  // adapter must not use it (nor shut it down) and fall back to one process
+  // per transaction, which fails here since there is no openocd
+  OclaFakeOpenocdServer server;
+  OclaOpenocdAdapter adapter{"false"};
+  adapter.set_persistent(true, server.port());
+  EXPECT_ANY_THROW(adapter.write(0x1000, 0xdeadbeef));
+  EXPECT_FALSE(adapter.is_session_open());
+  adapter.close_session();
+  EXPECT_EQ(server.get_connection_count(), 1);
+  EXPECT_EQ(server.get_request_count(), 0);
+}
+
+#endif